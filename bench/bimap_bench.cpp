@@ -0,0 +1,183 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/bimap.hpp>
+#include <libarude/flat_bimap.hpp>
+#include <libarude/small_bimap.hpp>
+#include <libarude/unordered_bimap.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+
+///
+/// Measures the average time of a lookup function over all keys.
+/// \return Nanoseconds per lookup
+///
+template<typename K, typename F>
+double measure(const std::vector<K>& keys, F f)
+{
+  auto sink = std::uint64_t{ 0 };
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& k : keys)
+  {
+    sink += static_cast<std::uint64_t>(f(k));
+  }
+  const auto stop = std::chrono::steady_clock::now();
+
+  // Keep the optimizer from dropping the loop
+  volatile auto keep = sink;
+  (void)keep;
+
+  return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(keys.size());
+}
+
+///
+/// Runs the benchmark for one table size.
+/// \param n Number of mappings
+/// \param lookups Number of lookups per measurement
+///
+void run(std::size_t n, std::size_t lookups)
+{
+  auto rng = std::mt19937_64{ 42 };
+
+  // Unique random ids on both sides
+  auto lefts = std::vector<std::uint32_t>(n);
+  for (auto i = std::size_t{ 0 }; i < n; ++i)
+  {
+    lefts[i] = static_cast<std::uint32_t>(i * 2654435761u);
+  }
+  std::sort(std::begin(lefts), std::end(lefts));
+  lefts.erase(std::unique(std::begin(lefts), std::end(lefts)), std::end(lefts));
+  std::shuffle(std::begin(lefts), std::end(lefts), rng);
+
+  auto init = arude::bimap<std::uint32_t, std::uint64_t>::init_map_type{};
+  for (auto i = std::size_t{ 0 }; i < lefts.size(); ++i)
+  {
+    init.emplace(lefts[i], (static_cast<std::uint64_t>(i) << 32) | 0x5bd1e995u);
+  }
+
+  const auto tree = arude::bimap<std::uint32_t, std::uint64_t>{ init };
+  const auto flat = arude::flat_bimap<std::uint32_t, std::uint64_t>{ init };
+  const auto hashed = arude::unordered_bimap<std::uint32_t, std::uint64_t>(std::begin(init), std::end(init));
+
+  auto lkeys = std::vector<std::uint32_t>(lookups);
+  auto rkeys = std::vector<std::uint64_t>(lookups);
+  auto dist = std::uniform_int_distribution<std::size_t>{ 0, lefts.size() - 1 };
+  for (auto i = std::size_t{ 0 }; i < lookups; ++i)
+  {
+    const auto j = dist(rng);
+    lkeys[i] = lefts[j];
+    rkeys[i] = init.at(lefts[j]);
+  }
+
+  std::cout << "n=" << lefts.size() << '\n';
+  std::cout << "  bimap      left->right " << measure(lkeys, [&tree](std::uint32_t k) { return tree.map(k); }) << " ns\n";
+  std::cout << "  flat_bimap left->right " << measure(lkeys, [&flat](std::uint32_t k) { return flat.map(k); }) << " ns\n";
+  std::cout << "  unordered  left->right " << measure(lkeys, [&hashed](std::uint32_t k) { return hashed.map(k); }) << " ns\n";
+  std::cout << "  bimap      right->left " << measure(rkeys, [&tree](std::uint64_t k) { return tree.map(k); }) << " ns\n";
+  std::cout << "  flat_bimap right->left " << measure(rkeys, [&flat](std::uint64_t k) { return flat.map(k); }) << " ns\n";
+  std::cout << "  unordered  right->left " << measure(rkeys, [&hashed](std::uint64_t k) { return hashed.map(k); }) << " ns\n";
+
+  // Batch lookups including 50% misses
+  auto batch = lkeys;
+  for (auto i = std::size_t{ 0 }; i < batch.size(); i += 2)
+  {
+    batch[i] ^= 1;
+  }
+  auto out = std::vector<std::uint64_t>(batch.size());
+  auto missing = std::vector<bool>{};
+  auto perop = [&batch](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(batch.size());
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  tree.map_n(batch.data(), batch.size(), out.data(), missing);
+  std::cout << "  bimap      map_n       " << perop(start) << " ns\n";
+  start = std::chrono::steady_clock::now();
+  flat.map_n(batch.data(), batch.size(), out.data(), missing);
+  std::cout << "  flat_bimap map_n       " << perop(start) << " ns\n";
+}
+
+///
+/// Runs the benchmark for a small enum like table.
+/// \param lookups Number of lookups per measurement
+///
+void run_small(std::size_t lookups)
+{
+  auto rng = std::mt19937_64{ 42 };
+
+  auto init = arude::bimap<std::uint16_t, std::uint32_t>::init_map_type{};
+  auto small = arude::small_bimap<std::uint16_t, std::uint32_t>{};
+  for (auto i = std::uint16_t{ 0 }; i < 48; ++i)
+  {
+    init.emplace(static_cast<std::uint16_t>(i * 7), 0x10000u + i);
+    small.insert(static_cast<std::uint16_t>(i * 7), 0x10000u + i);
+  }
+
+  const auto tree = arude::bimap<std::uint16_t, std::uint32_t>{ init };
+  const auto flat = arude::flat_bimap<std::uint16_t, std::uint32_t>{ init };
+
+  auto lkeys = std::vector<std::uint16_t>(lookups);
+  auto rkeys = std::vector<std::uint32_t>(lookups);
+  auto dist = std::uniform_int_distribution<std::uint16_t>{ 0, 47 };
+  for (auto i = std::size_t{ 0 }; i < lookups; ++i)
+  {
+    const auto j = dist(rng);
+    lkeys[i] = static_cast<std::uint16_t>(j * 7);
+    rkeys[i] = 0x10000u + j;
+  }
+
+  std::cout << "n=48 (small)\n";
+  std::cout << "  bimap       left->right " << measure(lkeys, [&tree](std::uint16_t k) { return tree.map(k); }) << " ns\n";
+  std::cout << "  flat_bimap  left->right " << measure(lkeys, [&flat](std::uint16_t k) { return flat.map(k); }) << " ns\n";
+  std::cout << "  small_bimap left->right " << measure(lkeys, [&small](std::uint16_t k) { return small.map(k); }) << " ns\n";
+  std::cout << "  bimap       right->left " << measure(rkeys, [&tree](std::uint32_t k) { return tree.map(k); }) << " ns\n";
+  std::cout << "  flat_bimap  right->left " << measure(rkeys, [&flat](std::uint32_t k) { return flat.map(k); }) << " ns\n";
+  std::cout << "  small_bimap right->left " << measure(rkeys, [&small](std::uint32_t k) { return small.map(k); }) << " ns\n";
+}
+
+} // namespace
+
+int main()
+{
+  run_small(1u << 22);
+
+  for (const auto n : { std::size_t{ 1 } << 10, std::size_t{ 1 } << 16, std::size_t{ 1 } << 22 })
+  {
+    run(n, 1u << 22);
+  }
+
+  return 0;
+}
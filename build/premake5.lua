@@ -1,6 +1,7 @@
 workspace "libarude"
   flags { "MultiProcessorCompile", "NoPCH", "ShadowedVariables", "Unicode" }
   editandcontinue "Off"
+  cppdialect "C++17"
 
   configurations { "debug", "release" }
   filter "configuration:debug"
@@ -52,4 +53,17 @@ project "libarude_test"
     "../"
   }
 
-  files { "../test/**.hpp", "../test/**.cpp" }
\ No newline at end of file
+  files { "../test/**.hpp", "../test/**.cpp" }
+
+project "libarude_bench"
+  kind "ConsoleApp"
+  language "C++"
+  targetdir "../bin/%{cfg.buildcfg}"
+  links { "libarude" }
+
+  includedirs
+  {
+    "../"
+  }
+
+  files { "../bench/**.cpp" }
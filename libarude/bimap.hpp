@@ -30,7 +30,18 @@
 
 #include "libarude/exception.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <initializer_list>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 namespace arude
@@ -46,6 +57,15 @@ struct nomapping_exception : virtual exception {};
 ///
 struct nonuniquemapping_exception : virtual exception {};
 
+///
+/// Error information containing all non unique mappings found while bulk loading a bimap.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+///
+template<typename LT, typename RT>
+using errinfo_nonunique_mappings = boost::error_info<struct tag_nonunique_mappings, std::vector<std::pair<LT, RT>>>;
+
 ///
 /// The bimapper is a bi directinal map to map between different types.
 /// It is used to map between two id's or maps of different type.
@@ -53,10 +73,14 @@ struct nonuniquemapping_exception : virtual exception {};
 /// The bimapper is initialized on construction and immutable afterwards.
 /// See example at the bottom of this file!
 ///
+/// All nodes of both maps are allocated through the allocator, e.g. a std::pmr::polymorphic_allocator on a monotonic arena which is released at
+/// once, see pmr::bimap. For string keys consider std::string_view keys interned in a string_pool.
+///
 /// \tparam LT Left map type
 /// \tparam RT Right map type
+/// \tparam A Allocator, rebound for the nodes of both maps
 ///
-template<typename LT, typename RT>
+template<typename LT, typename RT, typename A = std::allocator<std::pair<const LT, const RT>>>
 class bimap
 {
   static_assert(!std::is_same<LT, RT>::value, "bimap can't map between equal left and right type");
@@ -66,9 +90,13 @@ public:
   using left_type = LT; ///< Left bimap type
   using right_type = RT; ///< Right bimap type
   using init_map_type = std::map<const left_type, right_type>; ///< Left map type;
-  using left_map_type = std::map<const left_type, const right_type>; ///< Left map type
-  using right_map_type = std::map<std::reference_wrapper<const right_type>, std::reference_wrapper<const left_type>, std::less<right_type>>; ///< Right map type
-  using size_type = left_map_type::size_type; ///< Size type
+  using allocator_type = A; ///< Allocator type
+  using left_map_type = std::map<const left_type, const right_type, std::less<const left_type>,
+    typename std::allocator_traits<allocator_type>::template rebind_alloc<std::pair<const left_type, const right_type>>>; ///< Left map type
+  using right_map_type = std::map<std::reference_wrapper<const right_type>, std::reference_wrapper<const left_type>, std::less<right_type>,
+    typename std::allocator_traits<allocator_type>::template rebind_alloc<
+      std::pair<const std::reference_wrapper<const right_type>, std::reference_wrapper<const left_type>>>>; ///< Right map type
+  using size_type = typename left_map_type::size_type; ///< Size type
 
 // Structors
 public:
@@ -77,17 +105,24 @@ public:
   ///
   bimap() = default;
 
+  ///
+  /// Ctor.
+  /// \param alloc Allocator
+  ///
+  explicit bimap(const allocator_type& alloc)
+    : m_lmap{ typename left_map_type::allocator_type{ alloc } }
+    , m_rmap{ typename right_map_type::allocator_type{ alloc } }
+  {
+  }
+
   ///
   /// Ctor.
   /// \param init Initializer list with mappings to initialize the bimap
+  /// \param alloc Allocator
   ///
-  bimap(std::initializer_list<typename left_map_type::value_type> init)
-    : m_lmap{ init }
+  bimap(std::initializer_list<typename left_map_type::value_type> init, const allocator_type& alloc = allocator_type{})
+    : bimap(std::begin(init), std::end(init), alloc)
   {
-    for (const auto& i : m_lmap)
-    {
-      m_rmap.emplace(std::cref(i.second), std::cref(i.first));
-    }
   }
 
   ///
@@ -95,34 +130,174 @@ public:
   /// \param rhs Rhs instance
   ///
   bimap(const bimap& rhs)
-    : m_lmap{ rhs.m_lmap }
+    : bimap(rhs, std::allocator_traits<allocator_type>::select_on_container_copy_construction(rhs.get_allocator()))
   {
-    for (const auto& i : m_lmap)
+  }
+
+  ///
+  /// Copy ctor.
+  /// \param rhs Rhs instance
+  /// \param alloc Allocator
+  ///
+  bimap(const bimap& rhs, const allocator_type& alloc)
+    : bimap(alloc)
+  {
+    // Both sides of rhs are sorted already
+    for (const auto& i : rhs.m_lmap)
+    {
+      m_lmap.emplace_hint(std::end(m_lmap), i.first, i.second);
+    }
+
+    for (const auto& i : rhs.m_rmap)
     {
-      m_rmap.emplace(std::cref(i.second), std::cref(i.first));
+      const auto node = m_lmap.find(i.second.get());
+      m_rmap.emplace_hint(std::end(m_rmap), std::cref(node->second), std::cref(node->first));
     }
   }
 
+  ///
+  /// Move ctor.
+  /// The nodes are taken over, so the right map keeps referring to valid left nodes.
+  /// \param rhs Rhs instance
+  ///
+  bimap(bimap&& rhs) = default;
+
   ///
   /// Ctor.
   /// 
   /// \param init Map to initialize the bimap with
+  /// \param alloc Allocator
   ///
-  bimap(const init_map_type& init)
+  bimap(const init_map_type& init, const allocator_type& alloc = allocator_type{})
+    : bimap(std::begin(init), std::end(init), alloc)
   {
-    for (const auto& i : init)
+  }
+
+  ///
+  /// Ctor.
+  /// Bulk loads the bimap from an unsorted range of mappings.
+  ///
+  /// Both projections are sorted, concurrently for large ranges, and checked for duplicates in one linear pass each. If there are duplicates,
+  /// a nonuniquemapping_exception is thrown carrying all offending mappings as errinfo_nonunique_mappings. Otherwise both maps are built in
+  /// linear time from the sorted sequences.
+  ///
+  /// error_info: errinfo_nonunique_mappings
+  ///
+  /// \tparam InputIt Input iterator with pair like values
+  /// \param first First mapping
+  /// \param last Past the end mapping
+  /// \param alloc Allocator
+  ///
+  template<typename InputIt>
+  bimap(InputIt first, InputIt last, const allocator_type& alloc = allocator_type{})
+    : bimap(alloc)
+  {
+    using pair_type = std::pair<left_type, right_type>;
+
+    auto mappings = std::vector<pair_type>{};
+    for (; first != last; ++first)
     {
-      const auto retval = m_lmap.emplace(i.first, i.second);
-      if (retval->second)
+      mappings.emplace_back(first->first, first->second);
+    }
+    const auto n = mappings.size();
+
+    // Sort both projections, the right one asynchronously if worth it
+    const auto lless = [&mappings](size_type a, size_type b) { return std::less<left_type>{}(mappings[a].first, mappings[b].first); };
+    const auto rless = [&mappings](size_type a, size_type b) { return std::less<right_type>{}(mappings[a].second, mappings[b].second); };
+    auto lorder = std::vector<size_type>(n);
+    auto rorder = std::vector<size_type>(n);
+    std::iota(std::begin(lorder), std::end(lorder), size_type{ 0 });
+    std::iota(std::begin(rorder), std::end(rorder), size_type{ 0 });
+
+    const auto sort = [](std::vector<size_type>& order, const auto& comp) {
+      if (!std::is_sorted(std::begin(order), std::end(order), comp))
+      {
+        std::sort(std::begin(order), std::end(order), comp);
+      }
+    };
+    if (n >= bulk_parallel_threshold)
+    {
+      auto rsorted = std::async(std::launch::async, [&sort, &rorder, &rless] { sort(rorder, rless); });
+      sort(lorder, lless);
+      rsorted.get();
+    }
+    else
+    {
+      sort(lorder, lless);
+      sort(rorder, rless);
+    }
+
+    // Collect all duplicates of both sides in one pass each
+    auto nonunique = std::vector<pair_type>{};
+    const auto collect = [&mappings, &nonunique](const std::vector<size_type>& order, const auto& comp) {
+      for (auto i = size_type{ 1 }; i < order.size(); ++i)
       {
-        if (m_rmap.emplace(std::cref(retval->first->second), std::cref(retval->first->first)).second)
+        if (!comp(order[i - 1], order[i]))
         {
-          continue;
+          if (i == 1 || comp(order[i - 2], order[i - 1]))
+          {
+            nonunique.push_back(mappings[order[i - 1]]);
+          }
+          nonunique.push_back(mappings[order[i]]);
         }
       }
+    };
+    collect(lorder, lless);
+    collect(rorder, rless);
+    if (!nonunique.empty())
+    {
+      using errinfo_type = errinfo_nonunique_mappings<left_type, right_type>;
+      BOOST_THROW_EXCEPTION(nonuniquemapping_exception{} << errinfo_type{ std::move(nonunique) });
+    }
 
-      BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
+    // Build both trees from sorted input, each insertion at the end hint is amortized constant
+    auto nodes = std::vector<typename left_map_type::const_iterator>(n);
+    for (const auto i : lorder)
+    {
+      nodes[i] = m_lmap.emplace_hint(std::end(m_lmap), std::move(mappings[i].first), std::move(mappings[i].second));
+    }
+    for (const auto i : rorder)
+    {
+      m_rmap.emplace_hint(std::end(m_rmap), std::cref(nodes[i]->second), std::cref(nodes[i]->first));
+    }
+  }
+
+// Operators
+public:
+  ///
+  /// Copy assignment.
+  /// Rebuilds the right map on the copied left nodes, never referring to the nodes of \a rhs.
+  /// \param rhs Rhs instance
+  /// \return This instance
+  ///
+  bimap& operator=(const bimap& rhs)
+  {
+    if (this != &rhs)
+    {
+      using traits = std::allocator_traits<allocator_type>;
+      *this = bimap(rhs, traits::propagate_on_container_copy_assignment::value ? rhs.get_allocator() : get_allocator());
+    }
+    return *this;
+  }
+
+  ///
+  /// Move assignment.
+  /// The nodes are taken over if the allocator allows, else they are copied into this allocator.
+  /// \param rhs Rhs instance
+  /// \return This instance
+  ///
+  bimap& operator=(bimap&& rhs)
+  {
+    using traits = std::allocator_traits<allocator_type>;
+    if (!traits::propagate_on_container_move_assignment::value && get_allocator() != rhs.get_allocator())
+    {
+      return *this = bimap(rhs, get_allocator());
     }
+
+    // Both maps move their nodes as a whole, the references between them stay valid
+    m_rmap = std::move(rhs.m_rmap);
+    m_lmap = std::move(rhs.m_lmap);
+    return *this;
   }
 
 // Accessors
@@ -132,16 +307,15 @@ public:
   /// \param v First type value
   /// \return Second type value
   ///
-  right_type map(left_type v) const
+  right_type map(const left_type& v) const
   {
-    try
-    {
-      return m_lmap.at(v);
-    }
-    catch (...)
+    const auto p = find(v);
+    if (p == nullptr)
     {
-      BOOST_THROW_EXCEPTION(nomapping_exception{} << boost::errinfo_nested_exception(boost::current_exception()));
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
     }
+
+    return *p;
   }
 
   ///
@@ -149,16 +323,91 @@ public:
   /// \param v Second type value
   /// \return First type value
   ///
-  left_type map(right_type v) const
+  left_type map(const right_type& v) const
   {
-    try
+    const auto p = find(v);
+    if (p == nullptr)
     {
-      return m_rmap.at(v);
-    }
-    catch (...)
-    {
-      BOOST_THROW_EXCEPTION(nomapping_exception{} << boost::errinfo_nested_exception(boost::current_exception()));
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
     }
+
+    return *p;
+  }
+
+  ///
+  /// Looks up the second type value of a first type value. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Pointer to the second type value or nullptr if not mapped
+  ///
+  const right_type* find(const left_type& v) const
+  {
+    const auto iter = m_lmap.find(v);
+    return iter == std::end(m_lmap) ? nullptr : &iter->second;
+  }
+
+  ///
+  /// Looks up the first type value of a second type value. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return Pointer to the first type value or nullptr if not mapped
+  ///
+  const left_type* find(const right_type& v) const
+  {
+    const auto iter = m_rmap.find(std::cref(v));
+    return iter == std::end(m_rmap) ? nullptr : &iter->second.get();
+  }
+
+  ///
+  /// Map first to second type. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Second type value or empty if not mapped
+  ///
+  std::optional<right_type> try_map(const left_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<right_type>{} : std::optional<right_type>{ *p };
+  }
+
+  ///
+  /// Map second to first type. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return First type value or empty if not mapped
+  ///
+  std::optional<left_type> try_map(const right_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<left_type>{} : std::optional<left_type>{ *p };
+  }
+
+  ///
+  /// Maps a batch of first type values to the second type.
+  ///
+  /// The batch is sorted once and resolved in key order, large batches in a single merge pass over the map. This keeps the walk through the
+  /// tree cache friendly and avoids any exception on misses.
+  ///
+  /// \param in First type values to map
+  /// \param n Number of values
+  /// \param out Receives the second type values, untouched where not mapped
+  /// \param missing Resized to \a n, set where a value is not mapped
+  /// \return Number of values not mapped
+  ///
+  size_type map_n(const left_type* in, size_type n, right_type* out, std::vector<bool>& missing) const
+  {
+    return map_n_impl(m_lmap, in, n, out, missing);
+  }
+
+  ///
+  /// Maps a batch of second type values to the first type.
+  /// \see map_n
+  ///
+  /// \param in Second type values to map
+  /// \param n Number of values
+  /// \param out Receives the first type values, untouched where not mapped
+  /// \param missing Resized to \a n, set where a value is not mapped
+  /// \return Number of values not mapped
+  ///
+  size_type map_n(const right_type* in, size_type n, left_type* out, std::vector<bool>& missing) const
+  {
+    return map_n_impl(m_rmap, in, n, out, missing);
   }
 
   ///
@@ -179,6 +428,15 @@ public:
     return m_rmap;
   }
 
+  ///
+  /// Returns the allocator.
+  /// \return Allocator
+  ///
+  allocator_type get_allocator() const
+  {
+    return allocator_type{ m_lmap.get_allocator() };
+  }
+
   ///
   /// Returns the size of the bimap.
   /// \return Size
@@ -190,16 +448,27 @@ public:
 
 // Modifiers
 public:
+  ///
+  /// Inserts a new mapping.
+  ///
+  /// \tparam ILT Left value type to allow perfect forwarding
+  /// \tparam IRT Right value type to allow perfect forwarding
+  /// \param ilv Left value
+  /// \param irv Right value
+  ///
   template<typename ILT, typename IRT>
   void insert(ILT&& ilv, IRT&& irv)
   {
+    const left_type lv{ std::forward<ILT>(ilv) };
+    const right_type rv{ std::forward<IRT>(irv) };
+
     // Check for the possibility to mess up uniqueness
-    if (m_lmap.count(ilv) != 0 || m_rmap.count(irv) != 0)
+    if (m_lmap.count(lv) != 0 || m_rmap.count(std::cref(rv)) != 0)
     {
       BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
     }
 
-    const auto iter = m_lmap.emplace(std::cref(i.first), std::cref(i.second)).first;
+    const auto iter = m_lmap.emplace(lv, rv).first;
     m_rmap.emplace(std::cref(iter->second), std::cref(iter->first));
   }
 
@@ -214,12 +483,85 @@ public:
     m_rmap.clear();
   }
 
+// Implementation
+private:
+  ///
+  /// Batch lookup in one of the maps.
+  /// \see map_n
+  ///
+  template<typename M, typename K, typename V>
+  static size_type map_n_impl(const M& m, const K* in, size_type n, V* out, std::vector<bool>& missing)
+  {
+    missing.assign(n, false);
+
+    const auto comp = m.key_comp();
+    auto order = std::vector<size_type>(n);
+    std::iota(std::begin(order), std::end(order), size_type{ 0 });
+    std::sort(std::begin(order), std::end(order), [in, &comp](size_type a, size_type b) { return comp(in[a], in[b]); });
+
+    // Merge against the whole map if that is cheaper than a tree walk per value
+    auto depth = size_type{ 1 };
+    for (auto s = m.size(); s > 1; s >>= 1)
+    {
+      ++depth;
+    }
+    const auto merge = n * depth >= m.size();
+
+    auto misses = size_type{ 0 };
+    auto iter = std::begin(m);
+    for (const auto i : order)
+    {
+      if (merge)
+      {
+        while (iter != std::end(m) && comp(iter->first, in[i]))
+        {
+          ++iter;
+        }
+      }
+      else
+      {
+        iter = m.lower_bound(in[i]);
+      }
+
+      if (iter != std::end(m) && !comp(in[i], iter->first))
+      {
+        out[i] = iter->second;
+      }
+      else
+      {
+        missing[i] = true;
+        ++misses;
+      }
+    }
+
+    return misses;
+  }
+
+// Constants
+private:
+  static constexpr size_type bulk_parallel_threshold = 1 << 16; ///< Number of mappings from which bulk loading sorts concurrently
+
 // Variables
 private:
   left_map_type m_lmap; ///< Left map
   right_map_type m_rmap; ///< Right map
 };
 
+namespace pmr
+{
+
+///
+/// Bimap allocating all nodes from a memory resource.
+///
+/// Example:
+/// std::pmr::monotonic_buffer_resource arena;
+/// arude::pmr::bimap<int, std::string_view> b(&arena);
+///
+template<typename LT, typename RT>
+using bimap = arude::bimap<LT, RT, std::pmr::polymorphic_allocator<std::pair<const LT, const RT>>>;
+
+} // namespace pmr
+
 } // namespace arude
 
 #endif // #ifndef INC_ARUDE_BIMAP_HPP
\ No newline at end of file
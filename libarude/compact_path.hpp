@@ -0,0 +1,411 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_COMPACT_PATH_HPP
+#define INC_ARUDE_COMPACT_PATH_HPP
+
+#include "libarude/path_components.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace arude
+{
+
+///
+/// Compact normalized path, usable as path type of the includexclude_pathlist and the filesystem_walker.
+///
+/// The path string is normalized when assigned: repeated and trailing separators and "." components are dropped, so "/foo//bar/./" is held
+/// as "/foo/bar". Short paths are held in an inline buffer together with the offsets of their components, longer ones in a single heap block.
+/// The hash is computed once when assigning. All accessors return views into the path, so testing, hashing and splitting a path does not
+/// allocate. Paths compare by components like boost::filesystem::path.
+///
+/// Example:
+/// arude::compact_path p{ "/data//photos/./2016/img.jpg" };
+/// p.string(); // "/data/photos/2016/img.jpg"
+/// p.stem(); // "img"
+///
+class compact_path final
+{
+// Typedefs
+public:
+  using value_type = char; ///< Character type
+  using size_type = std::uint32_t; ///< Size type
+  static constexpr std::size_t inline_capacity = 96; ///< Bytes of the inline buffer, shared by characters and component offsets
+  static constexpr value_type preferred_separator = '/'; ///< Separator used when normalizing
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  compact_path() noexcept;
+
+  ///
+  /// Ctor.
+  /// \param s Path string
+  ///
+  compact_path(std::string_view s);
+
+  ///
+  /// Ctor.
+  /// \param s Null terminated path string
+  ///
+  compact_path(const value_type* s);
+
+  ///
+  /// Ctor, converting from another path type like boost::filesystem::path.
+  /// \param p Path
+  ///
+  template<typename P, typename = std::enable_if_t<!std::is_convertible<const P&, std::string_view>::value>,
+    typename = decltype(std::declval<const P&>().native())>
+  explicit compact_path(const P& p)
+    : compact_path{}
+  {
+    const auto& p_str = path_string(p);
+    assign(p_str);
+  }
+
+  compact_path(const compact_path& rhs);
+  compact_path(compact_path&& rhs) noexcept;
+
+  ///
+  /// Dtor.
+  ///
+  ~compact_path();
+
+// Operators
+public:
+  compact_path& operator=(const compact_path& rhs);
+  compact_path& operator=(compact_path&& rhs) noexcept;
+
+  ///
+  /// Appends a relative path.
+  /// \param s Path string to append, separators between are added
+  /// \return This path
+  ///
+  compact_path& operator/=(std::string_view s);
+
+// Accessors
+public:
+  ///
+  /// Returns the normalized path string.
+  /// \return View of the path string
+  ///
+  std::string_view native() const noexcept
+  {
+    return { data_, size_ };
+  }
+
+  ///
+  /// Returns the normalized path string.
+  /// \return View of the path string
+  ///
+  std::string_view string() const noexcept
+  {
+    return native();
+  }
+
+  ///
+  /// Returns the normalized path string.
+  /// \return Null terminated path string
+  ///
+  const value_type* c_str() const noexcept
+  {
+    return data_;
+  }
+
+  ///
+  /// Returns the length of the path string.
+  /// \return Size
+  ///
+  size_type size() const noexcept
+  {
+    return size_;
+  }
+
+  ///
+  /// Says if the path is empty.
+  /// \return True if empty
+  ///
+  bool empty() const noexcept
+  {
+    return size_ == 0;
+  }
+
+  ///
+  /// Says if the path starts at the root.
+  /// \return True if absolute
+  ///
+  bool is_absolute() const noexcept
+  {
+    return size_ > 0 && is_path_separator(data_[0]);
+  }
+
+  ///
+  /// Says if the path is relative.
+  /// \return True if relative
+  ///
+  bool is_relative() const noexcept
+  {
+    return !is_absolute();
+  }
+
+  ///
+  /// Returns the number of components, the root is no component.
+  /// \return Number of components
+  ///
+  size_type depth() const noexcept
+  {
+    return depth_;
+  }
+
+  ///
+  /// Returns a component.
+  /// \param i Position of the component, less than depth()
+  /// \return View of the component
+  ///
+  std::string_view component(size_type i) const noexcept;
+
+  ///
+  /// Returns the path up to a component.
+  /// \param n Number of components to keep, at most depth()
+  /// \return View of the leading part of the path string
+  ///
+  std::string_view prefix(size_type n) const noexcept;
+
+  ///
+  /// Returns the path without its last component.
+  /// \return View of the parent path string
+  ///
+  std::string_view parent_path() const noexcept
+  {
+    return prefix(depth_ == 0 ? 0 : depth_ - 1);
+  }
+
+  ///
+  /// Returns the last component.
+  /// \return View of the file name, empty if the path has no components
+  ///
+  std::string_view filename() const noexcept
+  {
+    return depth_ == 0 ? std::string_view{} : component(depth_ - 1);
+  }
+
+  ///
+  /// Returns the file name without its extension.
+  /// \return View of the stem
+  ///
+  std::string_view stem() const noexcept;
+
+  ///
+  /// Returns the extension of the file name, including the dot.
+  /// \return View of the extension, empty if none
+  ///
+  std::string_view extension() const noexcept;
+
+  bool has_filename() const noexcept
+  {
+    return depth_ != 0;
+  }
+
+  bool has_stem() const noexcept
+  {
+    return !stem().empty();
+  }
+
+  bool has_extension() const noexcept
+  {
+    return !extension().empty();
+  }
+
+  ///
+  /// Returns the hash of the path string, computed when assigned.
+  /// \return Hash
+  ///
+  std::size_t hash() const noexcept
+  {
+    return hash_;
+  }
+
+  ///
+  /// Compares by components.
+  /// \param rhs Path to compare with
+  /// \return Less than, equal to or greater than zero like std::string::compare
+  ///
+  int compare(const compact_path& rhs) const noexcept;
+
+// Modifiers
+public:
+  ///
+  /// Assigns a path string.
+  /// \param s Path string
+  ///
+  void assign(std::string_view s);
+
+  ///
+  /// Removes the last component.
+  ///
+  void remove_filename() noexcept;
+
+  ///
+  /// Clears the path, keeping the buffer.
+  ///
+  void clear() noexcept;
+
+  ///
+  /// Swaps two paths.
+  /// \param rhs Path to swap with
+  ///
+  void swap(compact_path& rhs) noexcept;
+
+// Implementation
+private:
+  ///
+  /// Returns the component offsets which follow the null terminated path string.
+  /// \return Component offsets
+  ///
+  size_type* offsets() const noexcept;
+
+  ///
+  /// Returns the number of bytes needed for a path string and its component offsets.
+  ///
+  /// \param size Length of the path string
+  /// \param depth Number of components
+  /// \return Bytes
+  ///
+  static std::size_t storage_size(std::size_t size, std::size_t depth) noexcept;
+
+  ///
+  /// Makes sure the buffer holds a number of bytes, the contents are lost.
+  /// \param bytes Bytes needed
+  ///
+  void reserve(std::size_t bytes);
+
+  ///
+  /// Says if the heap block is used.
+  /// \return True if on the heap
+  ///
+  bool on_heap() const noexcept
+  {
+    return data_ != inline_;
+  }
+
+  ///
+  /// Computes the hash of the path string.
+  ///
+  void rehash() noexcept;
+
+// Variables
+private:
+  value_type* data_; ///< Path string followed by the component offsets, points to inline_ or a heap block
+  size_type size_ = 0; ///< Length of the path string
+  size_type depth_ = 0; ///< Number of components
+  size_type capacity_ = inline_capacity; ///< Bytes of the buffer
+  std::size_t hash_ = 0; ///< Hash of the path string
+  alignas(size_type) value_type inline_[inline_capacity]; ///< Inline buffer
+};
+
+inline bool operator==(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return lhs.hash() == rhs.hash() && lhs.native() == rhs.native();
+}
+
+inline bool operator!=(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+inline bool operator<(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return lhs.compare(rhs) < 0;
+}
+
+inline bool operator>(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return rhs < lhs;
+}
+
+inline bool operator<=(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return !(rhs < lhs);
+}
+
+inline bool operator>=(const compact_path& lhs, const compact_path& rhs) noexcept
+{
+  return !(lhs < rhs);
+}
+
+///
+/// Joins two paths.
+///
+/// \param lhs Path
+/// \param rhs Relative path string to append
+/// \return Joined path
+///
+inline compact_path operator/(compact_path lhs, std::string_view rhs)
+{
+  lhs /= rhs;
+  return lhs;
+}
+
+///
+/// Writes the path string.
+///
+/// \param os Stream to write to
+/// \param p Path
+/// \return Stream
+///
+std::ostream& operator<<(std::ostream& os, const compact_path& p);
+
+inline void swap(compact_path& lhs, compact_path& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace arude
+
+namespace std
+{
+
+template<>
+struct hash<arude::compact_path>
+{
+  std::size_t operator()(const arude::compact_path& p) const noexcept
+  {
+    return p.hash();
+  }
+};
+
+} // namespace std
+
+#endif // #ifndef INC_ARUDE_COMPACT_PATH_HPP
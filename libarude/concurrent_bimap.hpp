@@ -0,0 +1,242 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_CONCURRENT_BIMAP_HPP
+#define INC_ARUDE_CONCURRENT_BIMAP_HPP
+
+
+#include "libarude/bimap.hpp"
+#include "libarude/noncopyable.hpp"
+#include "libarude/rcu_ptr.hpp"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Read mostly bimap for concurrent use.
+///
+/// Readers work on an immutable snapshot taken without any lock, see rcu_ptr. Writers stage modifications which are applied to a copy of the
+/// current snapshot and published as a new version by publish(). Readers therefore scale with the number of cores while the mappings change
+/// rarely, each publish() costs a full copy of the bimap.
+/// Staged modifications are not visible before publish(), readers see either the old or the new version as a whole.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+/// \tparam B Underlying bimap type, must be copy constructible and provide insert() and find()
+///
+template<typename LT, typename RT, typename B = bimap<LT, RT>>
+class concurrent_bimap final : noncopyable
+{
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using bimap_type = B; ///< Underlying bimap type
+  using size_type = typename bimap_type::size_type; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param init Initial content
+  ///
+  explicit concurrent_bimap(bimap_type init = bimap_type{})
+    : m_current{ std::make_unique<const bimap_type>(std::move(init)) }
+  {
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  right_type map(const left_type& v) const
+  {
+    return map_impl(v);
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  left_type map(const right_type& v) const
+  {
+    return map_impl(v);
+  }
+
+  ///
+  /// Map first to second type. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Second type value or empty if not mapped
+  ///
+  std::optional<right_type> try_map(const left_type& v) const
+  {
+    return try_map_impl(v);
+  }
+
+  ///
+  /// Map second to first type. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return First type value or empty if not mapped
+  ///
+  std::optional<left_type> try_map(const right_type& v) const
+  {
+    return try_map_impl(v);
+  }
+
+  ///
+  /// Calls a function with the current snapshot, e.g. to do several lookups on the same version.
+  /// References into the snapshot must not escape the function.
+  ///
+  /// \param f Function taking a const bimap_type&
+  /// \return Result of \a f
+  ///
+  template<typename F>
+  decltype(auto) read(F&& f) const
+  {
+    const auto snapshot = m_current.read();
+    return std::forward<F>(f)(*snapshot);
+  }
+
+  ///
+  /// Returns the size of the current snapshot.
+  /// \return Size
+  ///
+  size_type size() const
+  {
+    return m_current.read()->size();
+  }
+
+// Modifiers
+public:
+  ///
+  /// Stages a new mapping, visible after the next publish().
+  ///
+  /// \tparam ILT Left value type to allow perfect forwarding
+  /// \tparam IRT Right value type to allow perfect forwarding
+  /// \param ilv Left value
+  /// \param irv Right value
+  ///
+  template<typename ILT, typename IRT>
+  void insert(ILT&& ilv, IRT&& irv)
+  {
+    std::lock_guard<decltype(m_mtx)> lock{ m_mtx };
+    m_pending.emplace_back(std::forward<ILT>(ilv), std::forward<IRT>(irv));
+  }
+
+  ///
+  /// Stages clearing all mappings, including the ones staged before. Visible after the next publish().
+  ///
+  void clear()
+  {
+    std::lock_guard<decltype(m_mtx)> lock{ m_mtx };
+    m_pending.clear();
+    m_cleared = true;
+  }
+
+  ///
+  /// Publishes all staged modifications as a new version.
+  ///
+  /// If a staged mapping is not unique, nonuniquemapping_exception is thrown, nothing is published and the staged modifications are discarded.
+  ///
+  void publish()
+  {
+    std::lock_guard<decltype(m_mtx)> lock{ m_mtx };
+    if (m_pending.empty() && !m_cleared)
+    {
+      return;
+    }
+
+    auto pending = std::move(m_pending);
+    const auto cleared = m_cleared;
+    m_pending.clear();
+    m_cleared = false;
+
+    auto next = cleared ? std::make_unique<bimap_type>() : std::make_unique<bimap_type>(*m_current.read());
+    for (auto& i : pending)
+    {
+      next->insert(std::move(i.first), std::move(i.second));
+    }
+
+    m_current.publish(std::move(next));
+  }
+
+  ///
+  /// Replaces the whole content, discarding staged modifications.
+  /// \param b New content
+  ///
+  void assign(bimap_type b)
+  {
+    std::lock_guard<decltype(m_mtx)> lock{ m_mtx };
+    m_pending.clear();
+    m_cleared = false;
+    m_current.publish(std::make_unique<const bimap_type>(std::move(b)));
+  }
+
+// Implementation
+private:
+  template<typename T>
+  auto map_impl(const T& v) const
+  {
+    const auto snapshot = m_current.read();
+    const auto p = snapshot->find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  template<typename T>
+  auto try_map_impl(const T& v) const
+  {
+    const auto snapshot = m_current.read();
+    const auto p = snapshot->find(v);
+    return p == nullptr ? std::optional<std::decay_t<decltype(*p)>>{} : std::optional<std::decay_t<decltype(*p)>>{ *p };
+  }
+
+// Variables
+private:
+  rcu_ptr<bimap_type> m_current; ///< Current snapshot
+  std::mutex m_mtx; ///< Mutex to serialize writers
+  std::vector<std::pair<left_type, right_type>> m_pending; ///< Staged mappings
+  bool m_cleared = false; ///< Says if clearing is staged
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_CONCURRENT_BIMAP_HPP
@@ -0,0 +1,141 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_CONCURRENT_PATHLIST_HPP
+#define INC_ARUDE_CONCURRENT_PATHLIST_HPP
+
+#include "libarude/includeexclude_pathlist.hpp"
+#include "libarude/noncopyable.hpp"
+#include "libarude/rcu_ptr.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+
+namespace arude
+{
+
+///
+/// Path list shared between threads which is reloaded at runtime.
+///
+/// Holds the current compiled_pathlist in an rcu_ptr. Readers like the filesystem_walker get the current snapshot without taking a lock, a
+/// reload compiles the new list on the calling thread and swaps it in atomically. Readers never block and see either the old or the new list as a
+/// whole, the old snapshot is freed once its last reader is gone.
+///
+/// Example:
+/// auto shared = std::make_shared<arude::concurrent_pathlist<boost::filesystem::path>>(load_config());
+/// arude::filesystem_walker<boost::filesystem::path> walker{ shared };
+/// ...
+/// shared->publish(load_config()); // Picked up by the running walker
+///
+/// \tparam P Path type
+///
+template<typename P>
+class concurrent_pathlist final : noncopyable
+{
+// Typedefs
+public:
+  using path_type = P; ///< Path type
+  using pathlist_type = includexclude_pathlist<P>; ///< Path list type used to build snapshots
+  using snapshot_type = compiled_pathlist<P>; ///< Snapshot type
+  using read_guard = typename rcu_ptr<snapshot_type>::read_guard; ///< Read access to a snapshot
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param init Initial path list
+  ///
+  explicit concurrent_pathlist(const pathlist_type& init = pathlist_type{})
+    : current_{ init.compile() }
+  {
+  }
+
+// Accessors
+public:
+  ///
+  /// Returns read access to the current snapshot.
+  /// Several lookups on the returned guard see the same version. The guard should not be held for long, it delays freeing old snapshots.
+  ///
+  /// \return Guard holding the snapshot
+  ///
+  read_guard read() const noexcept
+  {
+    return current_.read();
+  }
+
+  ///
+  /// Says if a path is excluded in the current snapshot.
+  /// \param p Path to test for exclusion
+  /// \return True if excluded
+  ///
+  bool excluded(const path_type& p) const
+  {
+    return read()->excluded(p);
+  }
+
+  ///
+  /// Says if a path given as string is excluded in the current snapshot.
+  /// \param p Path string to test for exclusion
+  /// \return True if excluded
+  ///
+  bool excluded(std::string_view p) const noexcept
+  {
+    return read()->excluded(p);
+  }
+
+// Modifiers
+public:
+  ///
+  /// Compiles a path list and publishes it as the current snapshot.
+  /// \param l New path list
+  ///
+  void publish(const pathlist_type& l)
+  {
+    publish(l.compile());
+  }
+
+  ///
+  /// Publishes a compiled snapshot.
+  /// \param s New snapshot
+  ///
+  void publish(std::unique_ptr<const snapshot_type> s)
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    current_.publish(std::move(s));
+  }
+
+// Variables
+private:
+  rcu_ptr<snapshot_type> current_; ///< Current snapshot
+  std::mutex mtx_; ///< Mutex to serialize writers
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_CONCURRENT_PATHLIST_HPP
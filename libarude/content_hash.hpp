@@ -0,0 +1,115 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_CONTENT_HASH_HPP
+#define INC_ARUDE_CONTENT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace arude
+{
+
+///
+/// Fast 64 bit hash of file contents, the XXH64 algorithm.
+///
+/// Data is consumed in stripes of 32 bytes by four independent accumulators, so the multiplications of a stripe overlap in the pipeline and
+/// the hash runs at memory speed. It is not a cryptographic hash; it tells contents apart, not tampered ones.
+/// Data may be added in pieces of any size; the digest equals the one of all pieces added at once. Words are read in host byte order, so
+/// the digests match the reference implementation on little endian hosts only.
+///
+/// Example:
+/// arude::content_hash h;
+/// h.update(buffer, n);
+/// const auto digest = h.digest();
+///
+class content_hash final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param seed Seed, hashes with different seeds are unrelated
+  ///
+  explicit content_hash(std::uint64_t seed = 0) noexcept;
+
+// Accessors
+public:
+  ///
+  /// Returns the hash of the data added so far.
+  /// \return Digest
+  ///
+  std::uint64_t digest() const noexcept;
+
+// Modifiers
+public:
+  ///
+  /// Adds data.
+  ///
+  /// \param data Data to hash
+  /// \param n Number of bytes
+  ///
+  void update(const void* data, size_type n) noexcept;
+
+  ///
+  /// Restarts the hash.
+  /// \param seed Seed
+  ///
+  void reset(std::uint64_t seed = 0) noexcept;
+
+// Operations
+public:
+  ///
+  /// Hashes data at once.
+  ///
+  /// \param data Data to hash
+  /// \param n Number of bytes
+  /// \param seed Seed
+  /// \return Digest
+  ///
+  static std::uint64_t of(const void* data, size_type n, std::uint64_t seed = 0) noexcept;
+
+// Constants
+private:
+  static constexpr size_type stripe_size = 32; ///< Bytes consumed by the four accumulators at once
+
+// Variables
+private:
+  std::uint64_t seed_; ///< Seed
+  std::uint64_t acc_[4]; ///< Accumulators
+  std::uint64_t total_ = 0; ///< Bytes added
+  unsigned char stripe_[stripe_size]; ///< Bytes not yet making up a whole stripe
+  size_type buffered_ = 0; ///< Number of bytes in stripe_
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_CONTENT_HASH_HPP
@@ -0,0 +1,179 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_DETAIL_BINARY_IO_HPP
+#define INC_ARUDE_DETAIL_BINARY_IO_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+
+namespace arude
+{
+namespace detail
+{
+
+///
+/// Binary files of the library, e.g. snapshots and checkpoints.
+///
+/// A file starts with a magic of 4 bytes and a format version, the values follow in host byte order. Errors throw std::runtime_error with the
+/// kind of the file in the message.
+///
+struct binary_file
+{
+  const char* kind; ///< Kind of the file for messages, e.g. "Snapshot"
+  char magic[4]; ///< Start of the file
+  std::uint32_t version; ///< Format version
+
+  ///
+  /// Throws a std::runtime_error.
+  /// \param what Rest of the message following the kind of the file
+  ///
+  [[noreturn]] void fail(const char* what) const
+  {
+    throw std::runtime_error{ std::string{ kind } + " file " + what };
+  }
+};
+
+///
+/// Writes a value in host byte order.
+///
+/// \param os Stream to write to
+/// \param v Value
+///
+template<typename T>
+void write(std::ostream& os, T v)
+{
+  os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+///
+/// Writes a string with its length.
+///
+/// \param os Stream to write to
+/// \param s String
+///
+inline void write(std::ostream& os, const std::string& s)
+{
+  write(os, static_cast<std::uint32_t>(s.size()));
+  os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+///
+/// Reads a value in host byte order.
+/// \param f File format
+/// \param is Stream to read from
+/// \return Value
+///
+template<typename T>
+T read(const binary_file& f, std::istream& is)
+{
+  auto v = T{};
+  if (!is.read(reinterpret_cast<char*>(&v), sizeof(v)))
+  {
+    f.fail("is truncated.");
+  }
+  return v;
+}
+
+///
+/// Reads a string with its length.
+/// \param f File format
+/// \param is Stream to read from
+/// \return String
+///
+inline std::string read_string(const binary_file& f, std::istream& is)
+{
+  auto s = std::string(read<std::uint32_t>(f, is), '\0');
+  if (!is.read(&s[0], static_cast<std::streamsize>(s.size())))
+  {
+    f.fail("is truncated.");
+  }
+  return s;
+}
+
+///
+/// Saves a file, writing it aside and renaming it, so a crash never leaves a torn file.
+///
+/// \param f File format
+/// \param file Path of the file
+/// \param body Function writing the values after the magic and the version to a std::ostream
+///
+template<typename F>
+void save(const binary_file& f, const std::string& file, F body)
+{
+  const auto tmp = file + ".tmp";
+  {
+    auto os = std::ofstream{ tmp, std::ios::binary | std::ios::trunc };
+    os.write(f.magic, sizeof(f.magic));
+    write(os, f.version);
+    body(os);
+
+    if (!os.flush())
+    {
+      f.fail("can't be written.");
+    }
+  }
+
+  if (std::rename(tmp.c_str(), file.c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    f.fail("can't be written.");
+  }
+}
+
+///
+/// Opens a file for loading and checks its magic and version.
+/// \param f File format
+/// \param file Path of the file
+/// \return Stream positioned after the version
+///
+inline std::ifstream open(const binary_file& f, const std::string& file)
+{
+  auto is = std::ifstream{ file, std::ios::binary };
+  if (!is)
+  {
+    f.fail("can't be read.");
+  }
+
+  char m[sizeof(f.magic)];
+  if (!is.read(m, sizeof(m)) || !std::equal(std::begin(m), std::end(m), std::begin(f.magic)) || read<std::uint32_t>(f, is) != f.version)
+  {
+    f.fail("has an unknown format.");
+  }
+
+  return is;
+}
+
+} // namespace detail
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_DETAIL_BINARY_IO_HPP
@@ -0,0 +1,163 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_DIRECTORY_READER_HPP
+#define INC_ARUDE_DIRECTORY_READER_HPP
+
+#include "libarude/file_metadata.hpp"
+#include "libarude/noncopyable.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__)
+#define ARUDE_DIRECTORY_READER_GETDENTS
+#else
+#include <boost/filesystem/operations.hpp>
+#endif
+
+
+namespace arude
+{
+
+///
+/// Reads the entries of one directory after the other with a reused buffer.
+///
+/// On Linux a directory is opened with openat and read in large getdents64 blocks. The type of an entry is taken from d_type, fstatat relative
+/// to the directory is only called if the filesystem does not report it. Entry names are views into the buffer, so reading does not allocate.
+/// On other platforms a boost::filesystem::directory_iterator is used.
+/// Symbolic links are not followed. "." and ".." are skipped.
+///
+/// Example:
+/// arude::directory_reader reader;
+/// auto e = arude::directory_reader::entry{};
+/// for (auto ok = reader.open("/data"); ok && reader.next(e);) { ... }
+///
+class directory_reader final : noncopyable
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+  static constexpr size_type buffer_size = 64 * 1024; ///< Bytes read at once
+
+  ///
+  /// Type of an entry.
+  ///
+  enum class file_type
+  {
+    directory,
+    regular,
+    symlink,
+    other
+  };
+
+  ///
+  /// Directory entry.
+  ///
+  struct entry
+  {
+    std::string_view name; ///< Name, valid until the next call to next()
+    file_type type; ///< Type, symbolic links are not followed
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  directory_reader();
+
+  ///
+  /// Dtor.
+  ///
+  ~directory_reader();
+
+// Accessors
+public:
+  ///
+  /// Reads the metadata of the open directory.
+  /// \param out Receives the metadata
+  /// \return False if the metadata can't be read
+  ///
+  bool status(file_metadata& out) const;
+
+  ///
+  /// Reads the metadata of an entry, relative to the open directory.
+  ///
+  /// \param e Entry returned by the last call to next()
+  /// \param out Receives the metadata
+  /// \return False if the metadata can't be read, e.g. as the entry was removed
+  ///
+  bool status(const entry& e, file_metadata& out) const;
+
+  ///
+  /// Returns the bytes of directory data read since the directory was opened, the size of the names read on other platforms than Linux.
+  /// \return Bytes
+  ///
+  size_type bytes_read() const noexcept;
+
+// Modifiers
+public:
+  ///
+  /// Opens a directory, closing the former one.
+  /// A symlink to a directory is followed, so symlinked roots can be read. Symlinks found inside a directory are reported as file_type::symlink.
+  /// \param path Directory path
+  /// \return False if the directory can't be read, e.g. for missing permissions or if it is no directory
+  ///
+  bool open(std::string_view path);
+
+  ///
+  /// Reads the next entry.
+  /// \param e Receives the entry
+  /// \return False at the end of the directory or on errors
+  ///
+  bool next(entry& e);
+
+  ///
+  /// Closes the directory.
+  ///
+  void close() noexcept;
+
+// Variables
+private:
+  std::string path_; ///< Null terminated path of the directory
+  size_type bytes_ = 0; ///< Bytes read since the directory was opened
+#if defined(ARUDE_DIRECTORY_READER_GETDENTS)
+  int fd_ = -1; ///< Directory file descriptor
+  std::unique_ptr<char[]> buffer_; ///< getdents64 buffer
+  size_type offset_ = 0; ///< Offset of the next record in the buffer
+  size_type size_ = 0; ///< Bytes in the buffer
+#else
+  boost::filesystem::directory_iterator iter_; ///< Iterator over the directory
+  std::string name_; ///< Name of the current entry
+#endif
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_DIRECTORY_READER_HPP
@@ -0,0 +1,160 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_DIRECTORY_SNAPSHOT_HPP
+#define INC_ARUDE_DIRECTORY_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Listings of directories as seen by a walk, used by the filesystem_walker to rescan incrementally.
+///
+/// Each directory is recorded with its inode, its modification time and its entries, which are the files with their size and modification
+/// time and the sub directories. As adding, removing or renaming an entry changes the modification time of the directory, the listing of a
+/// directory with the same inode and modification time needs not to be read again.
+/// A snapshot is saved to and loaded from a compact binary file.
+/// This class is as thread safe as a std::vector.
+///
+class directory_snapshot final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+
+  ///
+  /// Type of an entry.
+  ///
+  enum class entry_type : std::uint8_t
+  {
+    file,
+    directory
+  };
+
+  ///
+  /// Entry of a directory.
+  ///
+  struct entry
+  {
+    std::string name; ///< Name
+    entry_type type; ///< Type
+    std::uint64_t size; ///< Size in bytes, 0 for directories
+    std::int64_t mtime; ///< Modification time in nanoseconds since the epoch, 0 for directories
+  };
+
+  ///
+  /// Listing of a directory.
+  ///
+  struct record
+  {
+    std::uint64_t inode = 0; ///< Inode number of the directory
+    std::int64_t mtime = 0; ///< Modification time of the directory in nanoseconds since the epoch, 0 forces reading it again
+    std::vector<entry> entries; ///< Entries, sorted by name
+  };
+
+// Accessors
+public:
+  ///
+  /// Finds the listing of a directory.
+  /// \param dir Directory path
+  /// \return Listing or nullptr if not recorded
+  ///
+  const record* find(const std::string& dir) const;
+
+  ///
+  /// Returns the number of recorded directories.
+  /// \return Size
+  ///
+  size_type size() const;
+
+  ///
+  /// Says if no directory is recorded.
+  /// \return True if empty
+  ///
+  bool empty() const;
+
+  ///
+  /// Saves the snapshot, replacing the file at once.
+  /// \param file Path of the snapshot file
+  ///
+  void save(const std::string& file) const;
+
+// Modifiers
+public:
+  ///
+  /// Records the listing of a directory, replacing a former one.
+  ///
+  /// \param dir Directory path
+  /// \param r Listing
+  ///
+  void insert(std::string dir, record r);
+
+  ///
+  /// Removes the listings of all directories not in a set, in place.
+  /// \param dirs Directories to keep
+  ///
+  void retain(const std::unordered_set<std::string_view>& dirs);
+
+  ///
+  /// Removes the listing of a directory, NOOP if not recorded.
+  /// \param dir Directory path
+  ///
+  void erase(const std::string& dir);
+
+  ///
+  /// Loads a snapshot saved before, replacing all listings.
+  /// \param file Path of the snapshot file
+  ///
+  void load(const std::string& file);
+
+  ///
+  /// Removes all listings.
+  ///
+  void clear();
+
+  ///
+  /// Swaps two snapshots.
+  /// \param rhs Snapshot to swap with
+  ///
+  void swap(directory_snapshot& rhs) noexcept;
+
+// Variables
+private:
+  std::unordered_map<std::string, record> records_; ///< Listings by directory path
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_DIRECTORY_SNAPSHOT_HPP
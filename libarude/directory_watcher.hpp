@@ -0,0 +1,145 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_DIRECTORY_WATCHER_HPP
+#define INC_ARUDE_DIRECTORY_WATCHER_HPP
+
+#include "libarude/noncopyable.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#define ARUDE_DIRECTORY_WATCHER_INOTIFY
+#endif
+
+
+namespace arude
+{
+
+///
+/// Watches directories for changes of their entries.
+///
+/// On Linux each directory gets an inotify watch, changes of its entries and of the contents of its files are reported with the path of the
+/// directory, and the removal or move of the directory itself with an empty name. Sub directories are not watched implicitly. If the kernel queue overflows, events are lost and an overflow is reported
+/// instead, the watched directories need to be compared with their former state then.
+/// On other platforms, or if inotify can't be initialized, no directory can be watched.
+/// Adding and removing watches is thread safe, reading events must be done by one thread.
+///
+class directory_watcher final : noncopyable
+{
+// Typedefs
+public:
+  ///
+  /// Kind of an event.
+  ///
+  enum class event_type
+  {
+    created, ///< Entry created or moved into the directory
+    modified, ///< File written or attributes changed
+    removed, ///< Entry removed or moved out of the directory
+    overflow ///< Events were lost, all watched directories may have changed
+  };
+
+  ///
+  /// Event of a watched directory.
+  ///
+  struct event
+  {
+    std::string dir; ///< Path of the watched directory, empty on overflow
+    std::string name; ///< Name of the entry, empty if the directory itself changed
+    event_type type; ///< Kind of event
+    bool directory; ///< True if the entry is a directory
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  directory_watcher();
+
+  ///
+  /// Dtor.
+  ///
+  ~directory_watcher();
+
+// Accessors
+public:
+  ///
+  /// Says if directories can be watched.
+  /// \return True if available
+  ///
+  bool available() const noexcept;
+
+  ///
+  /// Returns the number of watched directories.
+  /// \return Size
+  ///
+  std::size_t size() const;
+
+// Modifiers
+public:
+  ///
+  /// Watches a directory, NOOP if already watched.
+  /// \param dir Directory path
+  /// \return False if the directory can't be watched, e.g. as the limit of watches is reached
+  ///
+  bool add(std::string_view dir);
+
+  ///
+  /// Stops watching a directory, NOOP if not watched.
+  /// \param dir Directory path
+  ///
+  void remove(std::string_view dir);
+
+  ///
+  /// Reads the pending events, waiting for the first one.
+  /// Without inotify, just waits for the timeout.
+  ///
+  /// \param out Receives the events, cleared before
+  /// \param timeout Time to wait for the first event
+  /// \return False if the timeout elapsed without events
+  ///
+  bool read(std::vector<event>& out, std::chrono::milliseconds timeout);
+
+// Variables
+private:
+  int fd_ = -1; ///< inotify file descriptor
+  mutable std::mutex mtx_; ///< Serializes access to the watches
+  std::unordered_map<int, std::string> dirs_; ///< Watched directory paths by watch descriptor
+  std::unordered_map<std::string, int> wds_; ///< Watch descriptors by directory path
+  std::unique_ptr<char[]> buffer_; ///< Event buffer
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_DIRECTORY_WATCHER_HPP
@@ -0,0 +1,252 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_DUPLICATE_FINDER_HPP
+#define INC_ARUDE_DUPLICATE_FINDER_HPP
+
+#include "libarude/io_governor.hpp"
+#include "libarude/noncopyable.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Finds files with equal contents among the files found by a walk.
+///
+/// Files are compared in stages, each reading only the files still having a twin after the stage before:
+/// - files are grouped by size, which needs no reading at all,
+/// - the first and last few KB of each file are hashed, which sorts out most files of equal size like media with equal headers,
+/// - the files of each group of equal hashes are compared byte for byte, so a hash collision never makes files equal.
+/// The comparison reads the files of a group side by side in large blocks, splitting the group where they differ, so no file is read whole
+/// twice. It can be turned off, then the whole contents of the remaining files are hashed by the content_hash instead, trusting equal 64 bit
+/// hashes. Files not larger than the head and tail read are not hashed whole. Each stage runs on a pool of threads, whose reads can be
+/// throttled by an io_governor.
+/// Hard links of one file count as one file, reported by the first of their paths; where the inode is unknown, e.g. on other platforms than
+/// Linux, they are reported as duplicates. Files which can't be read or changed size meanwhile are left out.
+/// Files are added by any number of threads at once, e.g. by the handler of a walk. An instance must not be used by several threads at once
+/// otherwise.
+///
+/// Example:
+/// arude::duplicate_finder finder;
+/// arude::filesystem_walker<boost::filesystem::path> walker{ l, [&finder](const boost::filesystem::path& p, const arude::file_metadata& md) {
+///   if (md.valid) finder.add(p.string(), md.size); return false; } };
+/// walker.run([](boost::filesystem::path) {}, 4);
+/// walker.wait();
+/// for (const auto& group : finder.find()) ...
+///
+class duplicate_finder final : noncopyable
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+  using group_type = std::vector<std::string>; ///< Paths of files with equal contents
+
+  ///
+  /// Options of the search.
+  ///
+  struct options
+  {
+    size_type threads = 4; ///< Threads hashing
+    size_type edge_size = 4096; ///< Bytes hashed at the head and at the tail of each file
+    size_type buffer_size = 1 << 20; ///< Bytes read at once while hashing whole files
+    std::uint64_t min_size = 1; ///< Smaller files are ignored, by default empty ones
+    bool verify = true; ///< Compares the files of a group byte for byte, else the files are hashed whole and equal hashes are trusted
+    std::shared_ptr<io_governor> governor; ///< Throttles the reads, none if empty
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor, with the default options.
+  ///
+  duplicate_finder();
+
+  ///
+  /// Ctor.
+  /// \param o Options
+  ///
+  explicit duplicate_finder(options o);
+
+// Accessors
+public:
+  ///
+  /// Returns the number of files added.
+  /// \return Number of files
+  ///
+  size_type size() const;
+
+  ///
+  /// Returns the bytes read by the last search.
+  /// \return Bytes read
+  ///
+  std::uint64_t bytes_read() const noexcept;
+
+// Modifiers
+public:
+  ///
+  /// Adds a file. Thread safe.
+  ///
+  /// \param path Path of the file
+  /// \param size Size of the file
+  ///
+  void add(std::string path, std::uint64_t size);
+
+  ///
+  /// Adds a file whose size is read by the search. Thread safe.
+  /// \param path Path of the file
+  ///
+  void add(std::string path);
+
+  ///
+  /// Removes all files added.
+  ///
+  void clear();
+
+// Operations
+public:
+  ///
+  /// Searches the files added for equal contents.
+  /// \return Groups of at least two files with equal contents, the paths of a group and the groups sorted
+  ///
+  std::vector<group_type> find();
+
+// Types
+private:
+  ///
+  /// File added.
+  ///
+  struct candidate
+  {
+    std::string path; ///< Path
+    std::uint64_t size; ///< Size
+    std::uint64_t hash; ///< Hash of the last stage
+    std::uint64_t device; ///< Device number, read with the head and tail
+    std::uint64_t inode; ///< Inode number, read with the head and tail, 0 where unknown
+  };
+
+// Implementation
+private:
+  ///
+  /// Reads the sizes of the files added without.
+  ///
+  void fetch_sizes();
+
+  ///
+  /// Keeps the files having a twin of equal size and hash, sorted by both.
+  /// \param files Files
+  ///
+  static void keep_twins(std::vector<candidate>& files);
+
+  ///
+  /// Keeps the first path of the hard links of one file among files of equal size and hash.
+  /// \param files Files sorted by size, hash and path
+  ///
+  static void drop_links(std::vector<candidate>& files);
+
+  ///
+  /// Hashes files on the thread pool, dropping those failing to be read.
+  ///
+  /// \param files Files, their hash is replaced
+  /// \param whole True to hash the whole files, false for the head and tail
+  ///
+  void hash(std::vector<candidate>& files, bool whole);
+
+  ///
+  /// Hashes the head and tail of a file.
+  ///
+  /// \param c File, its hash is replaced
+  /// \param buffer Buffer to read into
+  /// \return False if the file can't be read
+  ///
+  bool hash_edges(candidate& c, std::vector<unsigned char>& buffer);
+
+  ///
+  /// Hashes the whole contents of a file.
+  ///
+  /// \param c File, its hash is replaced
+  /// \param buffer Buffer to read into
+  /// \return False if the file can't be read
+  ///
+  bool hash_whole(candidate& c, std::vector<unsigned char>& buffer);
+
+  ///
+  /// Compares files of equal hashes byte for byte.
+  ///
+  /// \param group Files of equal size and hash, sorted by path
+  /// \param buffer Buffer to read into
+  /// \param reference Buffer to read the file compared with into
+  /// \return Groups of at least two files with equal contents
+  ///
+  std::vector<group_type> confirm(std::vector<candidate>& group, std::vector<unsigned char>& buffer, std::vector<unsigned char>& reference);
+
+  ///
+  /// Compares files with a reference file, reading them alongside.
+  ///
+  /// \param ref Reference file
+  /// \param start Offset to compare from, the files being equal to \a ref before
+  /// \param files Files of the size of \a ref
+  /// \param n Number of files
+  /// \param same Receives the paths of the files equal to \a ref
+  /// \param differing Receives the files differing from \a ref with the offset of the first differing block
+  /// \param buffer Buffer to read into
+  /// \param reference Buffer to read \a ref into
+  /// \return False if \a ref can't be read
+  ///
+  bool compare(const candidate& ref, std::uint64_t start, const candidate* files, size_type n, group_type& same,
+    std::vector<std::pair<std::uint64_t, candidate>>& differing, std::vector<unsigned char>& buffer, std::vector<unsigned char>& reference);
+
+  ///
+  /// Charges bytes read to the governor and waits as it says.
+  /// \param bytes Bytes read
+  ///
+  void charge(std::uint64_t bytes);
+
+// Constants
+private:
+  static constexpr std::uint64_t unknown_size = ~std::uint64_t{}; ///< Size of a file still to be read
+  static constexpr size_type compare_fanout = 32; ///< Files compared with a reference file at once, each holding a descriptor
+
+// Variables
+private:
+  const options options_; ///< Options
+  mutable std::mutex mtx_; ///< Guards files_ while adding
+  std::vector<candidate> files_; ///< Files added
+  std::atomic<std::uint64_t> bytes_{ 0 }; ///< Bytes read by the last search
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_DUPLICATE_FINDER_HPP
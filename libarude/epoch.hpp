@@ -0,0 +1,196 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_EPOCH_HPP
+#define INC_ARUDE_EPOCH_HPP
+
+#include "libarude/noncopyable.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Epoch based reclamation for read mostly data structures.
+///
+/// Readers announce themselves by publishing the current epoch in a reader slot of their own, which lives on a separate cache line. Entering and
+/// leaving a read side critical section takes no lock and writes no shared cache line.
+/// Writers exchange a published pointer and retire the old object, which is deleted as soon as no reader entered before the exchange is still
+/// inside its critical section.
+/// There is one process wide domain, every thread claims a reader slot on its first read and gives it back on thread exit.
+///
+class epoch_domain final : noncopyable
+{
+// Structors
+public:
+  ///
+  /// Dtor.
+  /// Deletes all objects still retired.
+  ///
+  ~epoch_domain();
+
+// Accessors
+public:
+  ///
+  /// Returns the process wide domain.
+  /// \return Domain
+  ///
+  static epoch_domain& global();
+
+// Operations
+public:
+  ///
+  /// Enters a read side critical section. Can be nested.
+  ///
+  void enter() noexcept;
+
+  ///
+  /// Leaves a read side critical section.
+  ///
+  void leave() noexcept;
+
+  ///
+  /// Retires an object no longer reachable by new readers. It is deleted once all readers which could still see it are gone.
+  ///
+  /// \param p Object to retire
+  /// \param deleter Function deleting the object
+  ///
+  void retire(void* p, void (*deleter)(void*));
+
+  ///
+  /// Retires an object allocated by new.
+  /// \see retire
+  ///
+  /// \tparam T Object type
+  /// \param p Object to retire
+  ///
+  template<typename T>
+  void retire(const T* p)
+  {
+    retire(const_cast<T*>(p), [](void* q) { delete static_cast<T*>(q); });
+  }
+
+  ///
+  /// Blocks until all retired objects are deleted.
+  /// Must not be called inside a read side critical section.
+  ///
+  void synchronize();
+
+// Implementation
+private:
+  ///
+  /// Reader slot, one per thread and cache line.
+  ///
+  struct alignas(64) slot
+  {
+    std::atomic<std::uint64_t> epoch{ 0 }; ///< Epoch the reader entered in, 0 if not reading
+    std::atomic<bool> claimed{ false }; ///< Says if a thread owns this slot
+  };
+
+  ///
+  /// Object waiting for deletion.
+  ///
+  struct retired
+  {
+    void* p; ///< Retired object
+    void (*deleter)(void*); ///< Function deleting the object
+    std::uint64_t epoch; ///< Epoch the object was retired in
+  };
+
+  ///
+  /// Thread local reader state.
+  ///
+  struct reader;
+
+  ///
+  /// Ctor.
+  ///
+  epoch_domain();
+
+  ///
+  /// Claims a free reader slot for the calling thread.
+  /// \return Slot
+  ///
+  slot* claim() noexcept;
+
+  ///
+  /// Deletes all retired objects no reader can see anymore. The mutex must be held.
+  ///
+  void reclaim();
+
+  ///
+  /// Returns the thread local reader state.
+  /// \return Reader state
+  ///
+  static reader& local() noexcept;
+
+// Variables
+private:
+  static constexpr std::size_t max_readers = 1024; ///< Maximum number of threads reading at the same time
+
+  std::atomic<std::uint64_t> epoch_; ///< Global epoch
+  std::atomic<std::size_t> used_; ///< Number of slots ever claimed, upper bound for scans
+  std::unique_ptr<slot[]> slots_; ///< Reader slots
+  std::mutex mtx_; ///< Mutex to serialize writers
+  std::vector<retired> retired_; ///< Objects waiting for deletion
+};
+
+///
+/// Read side critical section of the global epoch domain for the lifetime of the guard.
+///
+class epoch_guard final : noncopyable
+{
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// Enters the critical section.
+  ///
+  epoch_guard() noexcept
+  {
+    epoch_domain::global().enter();
+  }
+
+  ///
+  /// Dtor.
+  /// Leaves the critical section.
+  ///
+  ~epoch_guard()
+  {
+    epoch_domain::global().leave();
+  }
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_EPOCH_HPP
@@ -0,0 +1,50 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_FILE_METADATA_HPP
+#define INC_ARUDE_FILE_METADATA_HPP
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace arude
+{
+
+///
+/// Metadata of a file.
+///
+struct file_metadata
+{
+  std::uint64_t size = 0; ///< Size in bytes
+  std::chrono::system_clock::time_point mtime; ///< Time of the last modification
+  std::uint64_t inode = 0; ///< Inode number, 0 where unknown
+  bool valid = false; ///< False if the metadata could not be read, e.g. as the file was removed
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_FILE_METADATA_HPP
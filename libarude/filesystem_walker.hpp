@@ -27,53 +27,134 @@
 #ifndef INC_ARUDE_FILESYSTEM_WALKER_HPP
 #define INC_ARUDE_FILESYSTEM_WALKER_HPP
 
+#include "libarude/concurrent_pathlist.hpp"
+#include "libarude/directory_reader.hpp"
+#include "libarude/directory_snapshot.hpp"
+#include "libarude/directory_watcher.hpp"
 #include "libarude/includeexclude_pathlist.hpp"
+#include "libarude/io_governor.hpp"
+#include "libarude/metadata_fetcher.hpp"
+#include "libarude/noncopyable.hpp"
+#include "libarude/ring_buffer.hpp"
+#include "libarude/walk_checkpoint.hpp"
 
-#include <boost/filesystem.hpp>
-
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 
 namespace arude
 {
 
 ///
-/// ???
+/// Asynchronous walker over the directory trees of the include paths of a path list.
+///
+/// Directories and files excluded by the path list are stepped over, all other files passing the filter predicate are handed to the file found
+/// handler on the walker thread. The path list is read through a concurrent_pathlist, so it can be reloaded while walking: each exclusion test
+/// uses the snapshot current at that moment, without a lock. The include paths are taken when a walk is started.
+/// A walk can run on several threads: directories are work items in a deque per thread, each thread lists its own directories depth first and
+/// idle threads steal the oldest directories of the others. Then the filter predicate and the file found handler are called concurrently.
+/// Directories are listed with a directory_reader, so entry types come without a stat call on Linux, and exclusion is tested on a reused path
+/// string: a path_type is only built for queued directories and for files handed to the filter predicate.
+/// With a metadata filter predicate, the files are collected in batches per thread whose metadata is read by a metadata_fetcher, so many
+/// requests are in flight instead of one synchronous stat per file in the predicate. Without io_uring the pool threads of the fetchers are
+/// shared out among the walking threads, so a walk does not start more of them than a single fetcher would.
+/// A batched run hands the files found through a ring_buffer to a consumer thread, which calls the handler with batches of them, so the walk
+/// and the processing run in parallel and a slow handler only stalls the walk once the buffer is full.
+/// Walks handing files can save their progress to a walk_checkpoint file periodically and when stopped, a later walk resumes from it.
+/// An io_governor limits the rates of directories and entries read, and backs off while the latency of opening directories is too high.
+/// A rescan compares the trees with a directory_snapshot of the former walk and reports the added, removed and modified files only. Listings
+/// of directories whose inode and modification time did not change are taken from the snapshot instead of being read. So a file rewritten in
+/// place, which leaves the listing of its directory alone, is not reported as modified until its directory is read again for another reason.
+/// A watch does a rescan and then waits for the changes: each directory listed is watched by a directory_watcher, and only the directories
+/// it reports are listed again. The watcher reports writes to files too, so a watch does find files rewritten in place.
+///
+/// \tparam P Path type, e.g. boost::filesystem::path or compact_path which tests without allocating
 ///
 template<typename P>
-class filesystem_walker final
+class filesystem_walker final : noncopyable
 {
 // Typedefs
 public:
   using path_type = P; ///< Path type
+  using pathlist_type = concurrent_pathlist<path_type>; ///< Shared path list type
   using filter_func_type = std::function<bool(const path_type&)>; ///< Filter predicat function type
+  using metadata_filter_func_type = std::function<bool(const path_type&, const file_metadata&)>; ///< Filter predicate taking metadata function type
   using filefound_func_type = std::function<void(path_type)>; ///< File found handler function type
+  using batch_func_type = std::function<void(std::vector<path_type>&)>; ///< Handler of a batch of found files function type
+
+  ///
+  /// Kind of change found by a rescan.
+  ///
+  enum class change
+  {
+    added, ///< File not in the snapshot
+    removed, ///< File of the snapshot gone
+    modified ///< File whose size or modification time differs, only found in directories whose listing changed, see rescan()
+  };
+
+  using change_func_type = std::function<void(path_type, change)>; ///< Change handler function type
 
 // Structors
 public:
   ///
   /// Ctor.
   ///
-  /// \tparam IEPL Pathlist type to allow perfect forwarding
-  /// \param iepl Include path list to traverse
+  /// \param iepl Include path list to traverse, compiled into a path list owned by the walker
+  /// \param ff Filter function acting as predicate to detect files, all files are taken if empty
+  ///
+  explicit filesystem_walker(const includexclude_pathlist<path_type>& iepl, filter_func_type ff = {});
+
+  ///
+  /// Ctor.
+  ///
+  /// \param iepl Shared include path list to traverse, reloads are picked up while walking
+  /// \param ff Filter function acting as predicate to detect files, all files are taken if empty
+  ///
+  explicit filesystem_walker(std::shared_ptr<const pathlist_type> iepl, filter_func_type ff = {});
+
+  ///
+  /// Ctor.
+  ///
+  /// \param iepl Include path list to traverse, compiled into a path list owned by the walker
+  /// \param mf Filter function acting as predicate to detect files, given the metadata of each file
   ///
-  template<typename IEPL>
-  filesystem_walker(IEPL&& iepl);
+  filesystem_walker(const includexclude_pathlist<path_type>& iepl, metadata_filter_func_type mf);
 
   ///
   /// Ctor.
   ///
-  /// \tparam IEPL Pathlist type to allow perfect forwarding
-  /// \param iepl Include path list to traverse
-  /// \param ff Filter function acting as predicate to detect files
+  /// \param iepl Shared include path list to traverse, reloads are picked up while walking
+  /// \param mf Filter function acting as predicate to detect files, given the metadata of each file
+  ///
+  filesystem_walker(std::shared_ptr<const pathlist_type> iepl, metadata_filter_func_type mf);
+
+  ///
+  /// Dtor.
+  /// Stops the walker and waits for it.
   ///
-  template<typename IEPL>
-  filesystem_walker(IEPL&& iepl, filter_func_type ff);
+  ~filesystem_walker();
 
 // Accessors
 public:
@@ -81,36 +162,113 @@ public:
   /// Says if a asynchronous file walker is running.
   /// \return True if running
   ///
-  bool running() noexecpt const;
+  bool running() const noexcept;
 
   ///
   /// Says if a asynchronous file walker is paused.
   /// \return True if running
   ///
-  bool paused() noexecpt const;
+  bool paused() const noexcept;
+
+// Modifiers
+public:
+  ///
+  /// Saves the progress of the walks of run() and run_batched() to a checkpoint file.
+  ///
+  /// A walk started while the checkpoint file exists resumes from it instead of starting at the include paths, the path list is to be the
+  /// same then. The checkpoint is saved every interval, for which the walking threads wait at the next entry, and when the walk is stopped.
+  /// It is removed when the walk is done. Files handed after the last checkpoint, e.g. before a crash, may be handed again when resuming.
+  /// Must not be called while running.
+  ///
+  /// \param file Path of the checkpoint file, empty to disable checkpoints
+  /// \param interval Time between checkpoints
+  ///
+  void checkpoint(std::string file, std::chrono::milliseconds interval = std::chrono::seconds{ 30 });
+
+  ///
+  /// Limits the I/O of all walks.
+  ///
+  /// Each directory listed is charged with its entries and the bytes of directory data read, the walking thread waits as the governor tells,
+  /// and the time opening it is measured as syscall latency. The governor may be shared by several walkers to limit them together, and may
+  /// be charged by the handlers with the bytes they read. Must not be called while running.
+  ///
+  /// \param governor Governor, nullptr for no limits
+  ///
+  void throttle(std::shared_ptr<io_governor> governor);
 
 // Operations
 public:
   ///
-  /// Runs a asynchrnous file walker.
-  /// If a slow walker is needed, just place a sleep inside the filefound handler which is synchronous to the walker.
-  /// NOOP if already running.
+  /// Runs a asynchrnous file walker over all include paths once.
+  /// To keep the walk from hurting other I/O, throttle() it.
+  /// Resumes a paused walker, NOOP if already running.
+  ///
+  /// \param filefound_func File found handler function, called concurrently if more than one thread walks
+  /// \param threads Number of threads walking, 0 for one per hardware thread
+  ///
+  void run(filefound_func_type filefound_func, std::size_t threads = 1);
+
+  ///
+  /// Runs a asynchronous file walker over all include paths once, handing the files found in batches on a thread of their own.
+  /// The walking threads wait while the buffer is full. Resumes a paused walker, NOOP if already running.
+  ///
+  /// \param batch_func Handler of a batch of found files, the files may be moved out of the batch
+  /// \param threads Number of threads walking, 0 for one per hardware thread
+  /// \param capacity Number of files buffered at most
+  ///
+  void run_batched(batch_func_type batch_func, std::size_t threads = 1, std::size_t capacity = 4096);
+
+  ///
+  /// Runs a asynchronous rescan over all include paths, reporting the changes since the walk recorded in a snapshot.
+  ///
+  /// Files are compared by size and modification time. Only directories whose listing changed are read and their files stat'ed, so a file
+  /// rewritten in place, which leaves the listing of its directory alone, is only found as modified once its directory is read again.
+  /// If the rescan is not stopped, the snapshot is replaced by the current listings when it ends. An empty snapshot reports all files as
+  /// added. The snapshot must not be accessed until the rescan ended, and it holds the files as filtered by the path list and the filter
+  /// predicate, so it is to be rebuilt from an empty one after changing these.
+  /// Resumes a paused walker, NOOP if already running.
+  ///
+  /// \param snapshot Listings of the former walk
+  /// \param change_func Change handler function, called concurrently if more than one thread walks
+  /// \param threads Number of threads walking, 0 for one per hardware thread
+  ///
+  void rescan(directory_snapshot& snapshot, change_func_type change_func, std::size_t threads = 1);
+
+  ///
+  /// Runs a asynchronous rescan like rescan() and then reports the changes as they happen until stopped.
   ///
-  /// \param filterfound_func File found handler function
+  /// Each directory listed is watched, changes reported for a directory are collected for a short while and then the changed directories
+  /// are listed again, including their files, which finds files rewritten in place too. Directories created are walked with all their sub
+  /// directories. If changes were lost, as the event queue overflowed, all directories are listed again. If a directory can't be watched,
+  /// e.g. as the limit of watches is reached or watching is not supported, all include paths are rescanned every interval in addition.
+  /// The snapshot is kept up to date and must not be accessed until the watch ended.
+  /// Resumes a paused walker, NOOP if already running.
   ///
-  void run(filefound_func_type filterfound_func);
+  /// \param snapshot Listings of the former walk
+  /// \param change_func Change handler function, called concurrently if more than one thread walks
+  /// \param threads Number of threads walking, 0 for one per hardware thread
+  /// \param interval Time between rescans if not all directories are watched
+  ///
+  void watch(directory_snapshot& snapshot, change_func_type change_func, std::size_t threads = 1,
+    std::chrono::milliseconds interval = std::chrono::seconds{ 10 });
 
   ///
   /// Pauses the walker after the next file was found (no matter if it fits the predicate).
   /// NOOP if already paused or idle.
   ///
-  void pause() noexecpt;
+  void pause() noexcept;
 
   ///
   /// Stops the walker after the next file was found (no matter if it fits the predicate).
   /// NOOP if already stopped.
   ///
-  void stop() noexecpt;
+  void stop() noexcept;
+
+  ///
+  /// Waits until the walker is done or stopped.
+  /// Exceptions thrown by the handlers are rethrown here.
+  ///
+  void wait();
 
 // Enums
 private:
@@ -121,123 +279,1621 @@ private:
     paused
   };
 
+// Constants
+private:
+  static constexpr std::size_t metadata_batch_size = 256; ///< Number of files whose metadata is read at once
+  static constexpr std::size_t metadata_queue_depth = 64; ///< Metadata requests in flight per thread on an io_uring
+  static constexpr std::size_t metadata_pool_threads = 8; ///< Threads reading metadata without io_uring, shared out among the walking threads
+  static constexpr std::size_t result_batch_size = 256; ///< Number of files handed to a batch handler at most
+  static constexpr std::chrono::milliseconds watch_timeout{ 100 }; ///< Time waiting for changes before testing if stopped
+  static constexpr std::chrono::milliseconds settle_timeout{ 20 }; ///< Time waiting for further changes of a burst
+  static constexpr std::chrono::milliseconds settle_limit{ 1000 }; ///< Longest time collecting the changes of a burst
+
+// Types
+private:
+  ///
+  /// Files of one thread waiting for their metadata.
+  ///
+  struct metadata_batch
+  {
+    ///
+    /// Ctor.
+    /// \param threads Number of walking threads, with as many or more the walking threads read the metadata themselves without io_uring
+    ///
+    explicit metadata_batch(std::size_t threads)
+      : fetcher{ metadata_queue_depth, metadata_pool_threads / threads }
+    {
+    }
+
+    metadata_fetcher fetcher; ///< Reads the metadata
+    std::vector<std::string> paths = std::vector<std::string>(metadata_batch_size); ///< Paths, the strings are reused
+    std::vector<file_metadata> metadata = std::vector<file_metadata>(metadata_batch_size); ///< Metadata of the paths
+    std::vector<std::uint64_t> indices = std::vector<std::uint64_t>(metadata_batch_size); ///< Entries read up to each path, only with checkpoints
+    std::size_t size = 0; ///< Number of files in the batch
+  };
+
+  ///
+  /// Directories still to be listed by one thread.
+  ///
+  struct work_queue
+  {
+    std::mutex mtx; ///< Serializes the owner and thieves
+    std::deque<path_type> dirs; ///< Directories, the owner works at the back, thieves take from the front
+  };
+
+  ///
+  /// Progress of a walk shared with the thread saving checkpoints.
+  ///
+  struct checkpoint_state
+  {
+    std::unordered_map<std::string, walk_checkpoint::entry> resumed; ///< Directories being listed when the checkpoint resumed was saved
+    std::vector<work_queue> queues; ///< Work queues of the walk
+    const std::atomic<std::size_t>* handled = nullptr; ///< Number of buffered files handled, nullptr if unbuffered
+    std::atomic<bool> requested{ false }; ///< Asks the walking threads to wait at a safe point, changed only while holding the mutex
+    std::size_t parked = 0; ///< Number of walking threads waiting at a safe point
+    std::size_t active = 0; ///< Number of walking threads not done yet
+  };
+
+  ///
+  /// State of one thread of a walk handing found files.
+  ///
+  struct file_lister
+  {
+    const filefound_func_type* filefound_func = nullptr; ///< File found handler function, unused if buffered
+    ring_buffer<path_type>* results = nullptr; ///< Buffer of the files found, nullptr to call the handler
+    directory_reader reader; ///< Reads the directories
+    std::string name; ///< Path of the current entry, the string is reused
+    std::unique_ptr<metadata_batch> batch; ///< Files waiting for their metadata, empty without metadata filter predicate
+    checkpoint_state* checkpoint = nullptr; ///< Progress shared with the checkpoints, nullptr without checkpoints
+    std::string dir; ///< Directory being listed, only with checkpoints
+    std::uint64_t index = 0; ///< Number of entries of the directory read before the current one
+    std::uint64_t position = 0; ///< Number of entries of the directory handled, files waiting for their metadata are not, sub directories are
+    std::int64_t mtime = 0; ///< Modification time of the directory when its listing started
+    std::size_t pushed = 0; ///< Number of files pushed to the buffer
+  };
+
+  ///
+  /// Directories reported changed by a watch.
+  ///
+  struct changed_dirs
+  {
+    std::unordered_set<std::string> dirty; ///< Directories whose listing or files changed
+    std::unordered_set<std::string> created; ///< Directories created or moved in
+  };
+
+  ///
+  /// State of one thread of a rescan.
+  ///
+  struct change_lister
+  {
+    const change_func_type* change_func = nullptr; ///< Change handler function
+    const directory_snapshot* snapshot = nullptr; ///< Listings of the former walk
+    const changed_dirs* changed = nullptr; ///< Directories to list again, nullptr to walk the whole trees
+    directory_watcher* watcher = nullptr; ///< Watches the directories listed, nullptr if not watching
+    bool forced = false; ///< Lists directories even if unchanged since the former walk
+    bool unwatched = false; ///< Set if a directory could not be watched
+    directory_reader reader; ///< Reads the directories
+    std::string name; ///< Path of the current entry, the string is reused
+    std::vector<std::pair<std::string, directory_snapshot::record>> records; ///< Listings read
+    std::vector<std::string> unchanged; ///< Directories whose listing in the snapshot is still current
+    std::vector<std::string> erased; ///< Directories found removed
+  };
+
 // Implementation
 private:
+  ///
+  /// Starts a asynchronous task on the walker thread, or resumes a paused walker.
+  /// \param task Task to run
+  ///
+  template<typename F>
+  void start(F task);
+
+  ///
+  /// Walks directory trees, run on the walker thread.
+  ///
+  /// \tparam L Lister type, file_lister or change_lister
+  /// \param listers State of each walking thread
+  /// \param roots Directories to start from
+  /// \param cp Progress shared with the checkpoints, nullptr without checkpoints
+  /// \return False if stopped before all directories were listed
+  ///
+  template<typename L>
+  bool walk(std::vector<L>& listers, std::vector<path_type> roots, checkpoint_state* cp = nullptr);
+
+  ///
+  /// Walks all include paths handing files, or resumes from the checkpoint, saving checkpoints if set, run on the walker thread.
+  ///
+  /// \param listers State of each walking thread
+  /// \param handled Number of buffered files handled, nullptr if unbuffered
+  ///
+  void walk_files(std::vector<file_lister>& listers, const std::atomic<std::size_t>* handled);
+
+  ///
+  /// Waits for the checkpoint interval and saves a checkpoint, run on a thread of its own.
+  ///
+  /// \param cp Progress of the walk
+  /// \param listers State of each walking thread
+  /// \param finished Set when the walk ended, read while holding the mutex
+  /// \return False if the walk ended
+  ///
+  bool save_checkpoint(checkpoint_state& cp, const std::vector<file_lister>& listers, const bool& finished);
+
+  ///
+  /// Collects the frontier of a walk, whose threads wait at a safe point or ended.
+  ///
+  /// \param cp Progress of the walk
+  /// \param listers State of each walking thread
+  /// \return Checkpoint
+  ///
+  static walk_checkpoint frontier(checkpoint_state& cp, const std::vector<file_lister>& listers);
+
+  ///
+  /// Opens a directory, measuring the latency for the governor.
+  ///
+  /// \param reader Reader to open the directory with
+  /// \param dir Directory path
+  /// \return False if the directory can't be read
+  ///
+  bool open(directory_reader& reader, std::string_view dir);
+
+  ///
+  /// Charges a directory listed to the governor and waits as it tells.
+  ///
+  /// \param entries Entries read
+  /// \param bytes Bytes of directory data read
+  /// \return False if the walker was stopped
+  ///
+  bool govern(std::uint64_t entries, std::uint64_t bytes);
+
+  ///
+  /// Waits while a checkpoint is saved, files waiting for their metadata are handed before.
+  /// \param l State of this thread
+  /// \return False if the walker was stopped
+  ///
+  bool park(file_lister& l);
+
+  ///
+  /// NOOP, rescans save no checkpoints.
+  /// \return True
+  ///
+  bool park(change_lister&);
+
+  ///
+  /// Takes the include paths of the current path list.
+  /// \return Include paths
+  ///
+  std::vector<path_type> roots() const;
+
+  ///
+  /// Compares the trees, or the changed directories, with a snapshot and updates it, run on the walker thread.
+  ///
+  /// \param listers State of each walking thread
+  /// \param snapshot Listings of the former walk, updated unless stopped
+  /// \param changed Directories to list again, nullptr to walk all include paths
+  /// \param forced Lists directories even if unchanged since the former walk
+  /// \return False if a directory could not be watched
+  ///
+  bool update(std::vector<change_lister>& listers, directory_snapshot& snapshot, const changed_dirs* changed, bool forced);
+
+  ///
+  /// Lists directories until all are done or the walker is stopped, run on each walking thread.
+  ///
+  /// \tparam L Lister type, file_lister or change_lister
+  /// \param lister State of this thread
+  /// \param queues Work queues of all threads
+  /// \param self Position of the queue of this thread
+  /// \param pending Number of directories queued or being listed
+  ///
+  template<typename L>
+  void work(L& lister, std::vector<work_queue>& queues, std::size_t self, std::atomic<std::size_t>& pending);
+
+  ///
+  /// Takes a directory, the newest of the own queue or else the oldest of another one.
+  ///
+  /// \param queues Work queues of all threads
+  /// \param self Position of the queue of this thread
+  /// \param dir Receives the directory
+  /// \return False if all queues are empty
+  ///
+  static bool take(std::vector<work_queue>& queues, std::size_t self, path_type& dir);
+
+  ///
+  /// Lists a directory, handing the files found.
+  ///
+  /// \param l State of this thread
+  /// \param dir Directory
+  /// \param push Function queueing a sub directory
+  /// \return False if the walker was stopped
+  ///
+  template<typename F>
+  bool list(file_lister& l, const path_type& dir, const F& push);
+
+  ///
+  /// Lists a directory, or takes its listing from the snapshot if unchanged, handing the changes found.
+  ///
+  /// \param l State of this thread
+  /// \param dir Directory
+  /// \param push Function queueing a sub directory
+  /// \return False if the walker was stopped
+  ///
+  template<typename F>
+  bool list(change_lister& l, const path_type& dir, const F& push);
+
+  ///
+  /// Hands the files waiting in a lister, called when a thread runs out of directories.
+  /// \param l State of this thread
+  /// \return False if the walker was stopped
+  ///
+  bool flush(file_lister& l);
+
+  ///
+  /// Hands the files waiting in a lister, called when a thread runs out of directories.
+  /// \param l State of this thread
+  /// \return False if the walker was stopped
+  ///
+  bool flush(change_lister& l);
+
+  ///
+  /// Reads the metadata of the batch of a lister and hands the files passing the metadata filter predicate on.
+  /// \param l State of this thread, the batch is empty afterwards
+  /// \return False if the walker was stopped
+  ///
+  bool deliver(file_lister& l);
+
+  ///
+  /// Hands a file found to the file found handler, or to the buffer, waiting while it is full.
+  ///
+  /// \param l State of this thread
+  /// \param p File path
+  /// \return False if the walker was stopped
+  ///
+  bool found(file_lister& l, path_type p);
+
+  ///
+  /// Reports all files of a directory and its sub directories recorded in the snapshot as removed.
+  ///
+  /// \param l State of this thread
+  /// \param dir Directory path
+  /// \param r Listing of the directory
+  /// \return False if the walker was stopped
+  ///
+  bool removed(change_lister& l, const std::string& dir, const directory_snapshot::record& r);
+
+  ///
+  /// Says if a directory or one of its parents is in a set.
+  ///
+  /// \param dir Directory path
+  /// \param dirs Directory paths
+  /// \return True if found
+  ///
+  static bool beneath(const std::string& dir, const std::unordered_set<std::string>& dirs);
+
+  ///
+  /// Says if a file passes the filter predicates.
+  ///
+  /// \param p File path
+  /// \param md Metadata of the file
+  /// \return True if taken
+  ///
+  bool taken(const path_type& p, const file_metadata& md) const;
+
+  ///
+  /// Converts a time point to nanoseconds since the epoch.
+  /// \param t Time point
+  /// \return Nanoseconds
+  ///
+  static std::int64_t to_nanoseconds(std::chrono::system_clock::time_point t);
 
+  ///
+  /// Waits while paused.
+  /// \return False if the walker was stopped
+  ///
+  bool proceed();
 
 // Variables
 private:
-  std::unique_ptr<std::async> async_; ///< Uptr to async instance for asynchronous walking
-  includeexclude_pathlist pathlist_; ///< Include/exclude path list
+  std::future<void> async_; ///< Future of the asynchronous walk
+  std::string checkpoint_file_; ///< Checkpoint file of the walks handing files, empty without checkpoints
+  std::chrono::milliseconds checkpoint_interval_{ 0 }; ///< Time between checkpoints
+  std::shared_ptr<io_governor> governor_; ///< Limits the I/O, empty for no limits
+  std::shared_ptr<const pathlist_type> pathlist_; ///< Include/exclude path list
   filter_func_type filter_predicate_func_; ///< File filter predicate function
-  state state_; ///< Current state of walker
-  std::mutex mtx_; ///< Mutex to serialize access to state and condition variable
+  metadata_filter_func_type metadata_filter_func_; ///< File filter predicate function taking metadata
+  std::atomic<state> state_; ///< Current state of walker, changed only while holding the mutex
+  mutable std::mutex mtx_; ///< Mutex to serialize access to state and condition variable
   std::condition_variable condition_; ///< Condition variable
 };
 
 
 template<typename P>
-template<typename IEPL>
-filesystem_walker<P>::filesystem_walker(IEPL&& iepl)
-  : pathlist_{ std::forward<IEPL>(iepl) }
+filesystem_walker<P>::filesystem_walker(const includexclude_pathlist<path_type>& iepl, filter_func_type ff)
+  : filesystem_walker{ std::make_shared<const pathlist_type>(iepl), std::move(ff) }
+{
+}
+
+template<typename P>
+filesystem_walker<P>::filesystem_walker(std::shared_ptr<const pathlist_type> iepl, filter_func_type ff)
+  : pathlist_{ std::move(iepl) }
+  , filter_predicate_func_{ std::move(ff) }
   , state_{ state::idle }
 {
-  static_assert(std::is_same<IEPL, decltype(pathlist_)::value, "First argument to the filesystem walker ctor must be a includeexclude_pathlist.");
+  if (!pathlist_)
+  {
+    throw std::runtime_error{ "Path list must be initialized." };
+  }
+}
+
+template<typename P>
+filesystem_walker<P>::filesystem_walker(const includexclude_pathlist<path_type>& iepl, metadata_filter_func_type mf)
+  : filesystem_walker{ std::make_shared<const pathlist_type>(iepl), std::move(mf) }
+{
+}
+
+template<typename P>
+filesystem_walker<P>::filesystem_walker(std::shared_ptr<const pathlist_type> iepl, metadata_filter_func_type mf)
+  : filesystem_walker{ std::move(iepl) }
+{
+  if (!mf)
+  {
+    throw std::runtime_error{ "Metadata filter function must be initialized." };
+  }
+  metadata_filter_func_ = std::move(mf);
 }
 
 template<typename P>
-template<typename IEPL>
-filesystem_walker<P>::filesystem_walker(IEPL&& iepl, filter_func_type ff)
-  : filesystem_walker{ std::forward<IEPL>(iepl) }
-  , filter_predicate_func_{ ff }
+filesystem_walker<P>::~filesystem_walker()
 {
+  stop();
+  if (async_.valid())
+  {
+    async_.wait();
+  }
 }
 
 template<typename P>
-bool filesystem_walker<P>::running() const
+bool filesystem_walker<P>::running() const noexcept
 {
   std::lock_guard<decltype(mtx_)> lock{ mtx_ };
   return state_ == state::running;
 }
 
 template<typename P>
-bool filesystem_walker<P>::paused() const
+bool filesystem_walker<P>::paused() const noexcept
 {
   std::lock_guard<decltype(mtx_)> lock{ mtx_ };
   return state_ == state::paused;
 }
 
 template<typename P>
-void filesystem_walker<P>::run(filefound_func_type filterfound_func)
+void filesystem_walker<P>::run(filefound_func_type filefound_func, std::size_t threads)
 {
-  if (!running())
+  if (!filefound_func)
+  {
+    throw std::runtime_error{ "File found function must be initialized." };
+  }
+
+  if (threads == 0)
   {
-    if (!fff)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  start([this, filefound_func = std::move(filefound_func), threads]
+  {
+    auto listers = std::vector<file_lister>(threads);
+    for (auto& i : listers)
     {
-      throw std::runtime_error{ "File found function must be initialized." };
+      i.filefound_func = &filefound_func;
+      if (metadata_filter_func_)
+      {
+        i.batch = std::make_unique<metadata_batch>(threads);
+      }
     }
+    walk_files(listers, nullptr);
+  });
+}
+
+template<typename P>
+void filesystem_walker<P>::run_batched(batch_func_type batch_func, std::size_t threads, std::size_t capacity)
+{
+  if (!batch_func)
+  {
+    throw std::runtime_error{ "Batch function must be initialized." };
+  }
 
-    async_ = std::make_unique<std::async>(std::launch::async, [this, filterfound_func]
+  if (threads == 0)
+  {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  start([this, batch_func = std::move(batch_func), threads, capacity]
+  {
+    auto results = ring_buffer<path_type>{ capacity };
+    auto handled = std::atomic<std::size_t>{ 0 };
+    auto listers = std::vector<file_lister>(threads);
+    for (auto& i : listers)
     {
-      state_ = state::running;
+      i.results = &results;
+      if (metadata_filter_func_)
+      {
+        i.batch = std::make_unique<metadata_batch>(threads);
+      }
+    }
 
-      for (;;)
+    // An error of the handler stops the walk, and is rethrown after those of the walk
+    auto error = std::exception_ptr{};
+    auto consumer = std::thread{ [this, &batch_func, &results, &handled, &error]
+    {
+      try
       {
-        { // Exit if state is idle
-          std::lock_guard<decltype(mtx_)> lock{ mtx_ };
-          if (state_ == state::idle)
+        auto batch = std::vector<path_type>{};
+        batch.reserve(result_batch_size);
+        for (auto idle = 0u; proceed();)
+        {
+          // Closed before popping, so nothing pushed before closing is left behind
+          const auto last = results.closed();
+          if (results.try_pop(std::back_inserter(batch), result_batch_size) > 0)
+          {
+            idle = 0;
+            batch_func(batch);
+            handled += batch.size();
+            batch.clear();
+          }
+          else if (last)
           {
             return;
           }
-        }
-
-        // Loop over all base include list
-        namespace fs = boost::filesystem;
-        for (const auto& i : pathlist_)
-        {
-          // Traverse path recursively
-          const auto iterEnd = fs::recursive_directory_iterator{};
-          for (auto iter = fs::recursive_directory_iterator{ i }; iter != iterEnd; ++iter)
+          else if (++idle < 64)
           {
-            if (fs::is_directory(*iter) && pathlist_.excluded(*iter))
-            {
-              iter.no_push();
-            }
-            else if (filter_predicate_func_(*iter))
-            {
-              filterfound_func(*iter);
-            }
-
-            // Check if paused and wait till it isn't anymore
-            std::unique_lock<decltype(mtx_)> lock{ mtx_ };
-            condition_.wait(lock, [] { return running() || !paused(); });
+            std::this_thread::yield();
+          }
+          else
+          {
+            std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
           }
         }
       }
-    });
-  }
+      catch (...)
+      {
+        error = std::current_exception();
+        stop();
+      }
+    } };
+
+    try
+    {
+      walk_files(listers, &handled);
+    }
+    catch (...)
+    {
+      stop();
+      consumer.join();
+      throw;
+    }
+    results.close();
+    consumer.join();
+
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  });
 }
 
 template<typename P>
-void filesystem_walker<P>::pause()
+void filesystem_walker<P>::rescan(directory_snapshot& snapshot, change_func_type change_func, std::size_t threads)
 {
+  if (!change_func)
   {
-    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
-    state_ = state::paused;
+    throw std::runtime_error{ "Change function must be initialized." };
   }
-  condition_.notify_one();
+
+  if (threads == 0)
+  {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  start([this, &snapshot, change_func = std::move(change_func), threads]
+  {
+    auto listers = std::vector<change_lister>(threads);
+    for (auto& i : listers)
+    {
+      i.change_func = &change_func;
+    }
+    update(listers, snapshot, nullptr, false);
+  });
 }
 
 template<typename P>
-void filesystem_walker<P>::stop()
+void filesystem_walker<P>::watch(directory_snapshot& snapshot, change_func_type change_func, std::size_t threads,
+  std::chrono::milliseconds interval)
 {
+  if (!change_func)
   {
-    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
-    state_ = state::idle;
+    throw std::runtime_error{ "Change function must be initialized." };
   }
-  condition_.notify_one();
+
+  if (threads == 0)
+  {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  start([this, &snapshot, change_func = std::move(change_func), threads, interval]
+  {
+    auto watcher = directory_watcher{};
+    auto listers = std::vector<change_lister>(threads);
+    for (auto& i : listers)
+    {
+      i.change_func = &change_func;
+      i.watcher = &watcher;
+    }
+
+    auto polling = !update(listers, snapshot, nullptr, false);
+    auto polled = std::chrono::steady_clock::now();
+    auto changed = changed_dirs{};
+    auto events = std::vector<directory_watcher::event>{};
+    while (proceed())
+    {
+      // Collect a burst of changes, so a directory changed many times is listed once
+      changed.dirty.clear();
+      changed.created.clear();
+      auto overflow = false;
+      const auto begin = std::chrono::steady_clock::now();
+      for (auto timeout = watch_timeout; watcher.read(events, timeout); timeout = settle_timeout)
+      {
+        for (const auto& i : events)
+        {
+          if (i.type == directory_watcher::event_type::overflow)
+          {
+            overflow = true;
+            continue;
+          }
+
+          changed.dirty.insert(i.dir);
+          if (i.directory && i.type == directory_watcher::event_type::created)
+          {
+            auto sub = i.dir;
+            if (sub.empty() || !is_path_separator(sub.back()))
+            {
+              sub.push_back('/');
+            }
+            changed.created.insert(sub.append(i.name));
+          }
+        }
+        if (std::chrono::steady_clock::now() - begin >= settle_limit)
+        {
+          break;
+        }
+      }
+
+      // Lost changes may be anywhere, as may be those of directories not watched
+      const auto now = std::chrono::steady_clock::now();
+      if (overflow || (polling && now - polled >= interval))
+      {
+        polling = !update(listers, snapshot, nullptr, overflow);
+        polled = now;
+      }
+      else if (!changed.dirty.empty() && !update(listers, snapshot, &changed, true))
+      {
+        polling = true;
+      }
+    }
+  });
+}
+
+template<typename P>
+void filesystem_walker<P>::checkpoint(std::string file, std::chrono::milliseconds interval)
+{
+  checkpoint_file_ = std::move(file);
+  checkpoint_interval_ = interval;
+}
+
+template<typename P>
+void filesystem_walker<P>::throttle(std::shared_ptr<io_governor> governor)
+{
+  governor_ = std::move(governor);
+}
+
+template<typename P>
+void filesystem_walker<P>::pause() noexcept
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  if (state_ == state::running)
+  {
+    state_ = state::paused;
+  }
+}
+
+template<typename P>
+void filesystem_walker<P>::stop() noexcept
+{
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    state_ = state::idle;
+  }
+  condition_.notify_all();
+}
+
+template<typename P>
+void filesystem_walker<P>::wait()
+{
+  if (async_.valid())
+  {
+    async_.get();
+  }
+}
+
+template<typename P>
+template<typename F>
+void filesystem_walker<P>::start(F task)
+{
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    if (state_ == state::paused)
+    {
+      state_ = state::running;
+      condition_.notify_all();
+      return;
+    }
+    if (state_ == state::running)
+    {
+      return;
+    }
+  }
+
+  // A former walk is stopped, wait for its thread before starting over
+  if (async_.valid())
+  {
+    async_.wait();
+  }
+
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    state_ = state::running;
+  }
+  async_ = std::async(std::launch::async, [this, task = std::move(task)]
+  {
+    try
+    {
+      task();
+    }
+    catch (...)
+    {
+      stop();
+      throw;
+    }
+    stop();
+  });
+}
+
+template<typename P>
+template<typename L>
+bool filesystem_walker<P>::walk(std::vector<L>& listers, std::vector<path_type> roots, checkpoint_state* cp)
+{
+  // With checkpoints, the queues are shared to be saved
+  const auto threads = listers.size();
+  auto own = std::vector<work_queue>{};
+  auto& queues = cp != nullptr ? cp->queues : own;
+  queues = std::vector<work_queue>(threads);
+  if (cp != nullptr)
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    cp->active = threads;
+  }
+  auto pending = std::atomic<std::size_t>{ roots.size() };
+  for (auto i = std::size_t{ 0 }; i < roots.size(); ++i)
+  {
+    queues[i % threads].dirs.push_back(std::move(roots[i]));
+  }
+
+  // The first error stops all threads and is rethrown
+  auto error = std::exception_ptr{};
+  auto error_mtx = std::mutex{};
+  const auto worker = [this, &listers, &queues, &pending, &error, &error_mtx, cp](std::size_t self)
+  {
+    // Without permission the walk keeps its priority
+    if (governor_)
+    {
+      governor_->enter_thread();
+    }
+
+    try
+    {
+      work(listers[self], queues, self, pending);
+    }
+    catch (...)
+    {
+      {
+        std::lock_guard<decltype(error_mtx)> lock{ error_mtx };
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+      stop();
+    }
+
+    // A checkpoint waits for the threads still walking only
+    if (cp != nullptr)
+    {
+      {
+        std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+        --cp->active;
+      }
+      condition_.notify_all();
+    }
+  };
+
+  auto helpers = std::vector<std::thread>{};
+  for (auto i = std::size_t{ 1 }; i < threads; ++i)
+  {
+    helpers.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto& i : helpers)
+  {
+    i.join();
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+
+  return pending == 0;
+}
+
+template<typename P>
+void filesystem_walker<P>::walk_files(std::vector<file_lister>& listers, const std::atomic<std::size_t>* handled)
+{
+  if (checkpoint_file_.empty())
+  {
+    walk(listers, roots());
+    return;
+  }
+
+  // Resume from the last checkpoint if there is one
+  auto cp = checkpoint_state{};
+  cp.handled = handled;
+  auto dirs = std::vector<path_type>{};
+  if (std::ifstream{ checkpoint_file_ })
+  {
+    auto last = walk_checkpoint{};
+    last.load(checkpoint_file_);
+    for (const auto& i : last.dirs())
+    {
+      dirs.emplace_back(i.dir);
+      if (i.position > 0)
+      {
+        cp.resumed.emplace(i.dir, i);
+      }
+    }
+  }
+  else
+  {
+    dirs = roots();
+  }
+  for (auto& i : listers)
+  {
+    i.checkpoint = &cp;
+  }
+
+  auto finished = false;
+  auto error = std::exception_ptr{};
+  auto saver = std::thread{ [this, &cp, &listers, &finished, &error]
+  {
+    try
+    {
+      while (save_checkpoint(cp, listers, finished))
+      {
+      }
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+      stop();
+    }
+  } };
+  const auto join = [this, &saver, &finished]
+  {
+    {
+      std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+      finished = true;
+    }
+    condition_.notify_all();
+    saver.join();
+  };
+
+  auto done = false;
+  try
+  {
+    done = walk(listers, std::move(dirs), &cp);
+  }
+  catch (...)
+  {
+    join();
+    throw;
+  }
+  join();
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+
+  // A walk done starts over next time, a stopped one resumes where it stopped
+  if (done)
+  {
+    std::remove(checkpoint_file_.c_str());
+  }
+  else
+  {
+    frontier(cp, listers).save(checkpoint_file_);
+  }
+}
+
+template<typename P>
+bool filesystem_walker<P>::save_checkpoint(checkpoint_state& cp, const std::vector<file_lister>& listers, const bool& finished)
+{
+  auto saved = walk_checkpoint{};
+  auto taken = false;
+  {
+    std::unique_lock<decltype(mtx_)> lock{ mtx_ };
+    if (condition_.wait_for(lock, checkpoint_interval_, [&finished] { return finished; }))
+    {
+      return false;
+    }
+
+    // All walking threads wait at a safe point, then the files buffered before are handled
+    cp.requested = true;
+    condition_.wait(lock, [this, &cp, &finished] { return finished || state_ == state::idle || cp.parked == cp.active; });
+    const auto pushed = [&listers]
+    {
+      auto n = std::size_t{ 0 };
+      for (const auto& i : listers)
+      {
+        n += i.pushed;
+      }
+      return n;
+    };
+    while (!finished && state_ != state::idle && cp.handled != nullptr && *cp.handled != pushed())
+    {
+      lock.unlock();
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+      lock.lock();
+    }
+
+    if (!finished && state_ != state::idle && cp.active > 0)
+    {
+      saved = frontier(cp, listers);
+      taken = true;
+    }
+    cp.requested = false;
+  }
+  condition_.notify_all();
+
+  if (taken)
+  {
+    saved.save(checkpoint_file_);
+  }
+  return true;
+}
+
+template<typename P>
+walk_checkpoint filesystem_walker<P>::frontier(checkpoint_state& cp, const std::vector<file_lister>& listers)
+{
+  auto saved = walk_checkpoint{};
+  for (const auto& i : listers)
+  {
+    if (!i.dir.empty())
+    {
+      saved.add(i.dir, i.position, i.mtime);
+    }
+  }
+  // Directories resumed but not listed again yet keep their position
+  for (auto& i : cp.queues)
+  {
+    std::lock_guard<decltype(i.mtx)> lock{ i.mtx };
+    for (const auto& j : i.dirs)
+    {
+      auto dir = std::string{ path_string(j) };
+      const auto resumed = cp.resumed.find(dir);
+      if (resumed != std::end(cp.resumed))
+      {
+        saved.add(std::move(dir), resumed->second.position, resumed->second.mtime);
+      }
+      else
+      {
+        saved.add(std::move(dir));
+      }
+    }
+  }
+
+  return saved;
+}
+
+template<typename P>
+bool filesystem_walker<P>::open(directory_reader& reader, std::string_view dir)
+{
+  if (!governor_)
+  {
+    return reader.open(dir);
+  }
+
+  const auto start = io_governor::clock::now();
+  const auto opened = reader.open(dir);
+  governor_->measured(io_governor::clock::now() - start);
+  return opened;
+}
+
+template<typename P>
+bool filesystem_walker<P>::govern(std::uint64_t entries, std::uint64_t bytes)
+{
+  if (!governor_)
+  {
+    return true;
+  }
+
+  // Waits in slices, so pausing and stopping take effect
+  for (auto delay = governor_->charge(1, entries, bytes); delay.count() > 0;)
+  {
+    if (!proceed())
+    {
+      return false;
+    }
+    const auto slice = std::min<std::chrono::nanoseconds>(delay, std::chrono::milliseconds{ 100 });
+    std::this_thread::sleep_for(slice);
+    delay -= slice;
+  }
+
+  return true;
+}
+
+template<typename P>
+bool filesystem_walker<P>::park(file_lister& l)
+{
+  if (l.checkpoint == nullptr || !l.checkpoint->requested.load(std::memory_order_acquire))
+  {
+    return true;
+  }
+
+  // Files waiting for their metadata are handed first, so the position covers them
+  if (l.batch && l.batch->size > 0)
+  {
+    if (!deliver(l))
+    {
+      return false;
+    }
+    l.position = l.index;
+  }
+
+  std::unique_lock<decltype(mtx_)> lock{ mtx_ };
+  ++l.checkpoint->parked;
+  condition_.notify_all();
+  condition_.wait(lock, [this, &l] { return !l.checkpoint->requested || state_ == state::idle; });
+  --l.checkpoint->parked;
+  return state_ != state::idle;
+}
+
+template<typename P>
+bool filesystem_walker<P>::park(change_lister&)
+{
+  return true;
+}
+
+template<typename P>
+std::vector<typename filesystem_walker<P>::path_type> filesystem_walker<P>::roots() const
+{
+  // Take the roots of the current snapshot, exclusions are always tested against the latest one
+  const auto snapshot = pathlist_->read();
+  return std::vector<path_type>(std::begin(*snapshot), std::end(*snapshot));
+}
+
+template<typename P>
+bool filesystem_walker<P>::update(std::vector<change_lister>& listers, directory_snapshot& snapshot, const changed_dirs* changed,
+  bool forced)
+{
+  for (auto& i : listers)
+  {
+    i.snapshot = &snapshot;
+    i.changed = changed;
+    i.forced = forced;
+    i.unwatched = false;
+    i.records.clear();
+    i.unchanged.clear();
+    i.erased.clear();
+  }
+
+  auto done = false;
+  if (changed == nullptr)
+  {
+    done = walk(listers, roots());
+  }
+  else
+  {
+    // Directories below created ones are walked from these
+    auto dirs = std::vector<path_type>{};
+    for (const auto& i : changed->dirty)
+    {
+      if (!beneath(i, changed->created) && !pathlist_->excluded(std::string_view{ i }))
+      {
+        dirs.emplace_back(i);
+      }
+    }
+    done = walk(listers, std::move(dirs));
+  }
+
+  // A stopped walk did not see all directories, its changes are reported again next time
+  if (!done)
+  {
+    return true;
+  }
+
+  auto watched = true;
+  if (changed == nullptr)
+  {
+    // Directories not visited are gone, unless every recorded one was visited
+    auto visited = std::size_t{ 0 };
+    for (const auto& i : listers)
+    {
+      visited += i.unchanged.size();
+      visited += static_cast<std::size_t>(std::count_if(std::begin(i.records), std::end(i.records),
+        [&snapshot](const auto& j) { return snapshot.find(j.first) != nullptr; }));
+    }
+    if (visited != snapshot.size())
+    {
+      auto keep = std::unordered_set<std::string_view>{};
+      keep.reserve(visited);
+      for (const auto& i : listers)
+      {
+        keep.insert(std::begin(i.unchanged), std::end(i.unchanged));
+        for (const auto& j : i.records)
+        {
+          keep.insert(j.first);
+        }
+      }
+      snapshot.retain(keep);
+    }
+
+    for (auto& i : listers)
+    {
+      for (auto& j : i.records)
+      {
+        snapshot.insert(std::move(j.first), std::move(j.second));
+      }
+    }
+  }
+  else
+  {
+    for (const auto& i : listers)
+    {
+      for (const auto& j : i.erased)
+      {
+        snapshot.erase(j);
+      }
+    }
+    for (auto& i : listers)
+    {
+      for (auto& j : i.records)
+      {
+        snapshot.insert(std::move(j.first), std::move(j.second));
+      }
+    }
+  }
+  for (const auto& i : listers)
+  {
+    // Moved directories keep their watches, which would report changes under the former paths
+    if (i.watcher != nullptr)
+    {
+      for (const auto& j : i.erased)
+      {
+        i.watcher->remove(j);
+      }
+    }
+    watched = watched && !i.unwatched;
+  }
+
+  return watched;
+}
+
+template<typename P>
+template<typename L>
+void filesystem_walker<P>::work(L& lister, std::vector<work_queue>& queues, std::size_t self, std::atomic<std::size_t>& pending)
+{
+  auto& own = queues[self];
+  const auto push = [&own, &pending](const std::string& dir)
+  {
+    ++pending;
+    std::lock_guard<decltype(own.mtx)> lock{ own.mtx };
+    own.dirs.emplace_back(dir);
+  };
+
+  auto idle = 0u;
+  for (auto dir = path_type{};;)
+  {
+    if (!take(queues, self, dir))
+    {
+      // Others may still list directories and queue new ones, so back off until all are done
+      if (!proceed() || !flush(lister) || !park(lister) || pending == 0)
+      {
+        return;
+      }
+      if (++idle < 64)
+      {
+        std::this_thread::yield();
+      }
+      else
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+      }
+      continue;
+    }
+    idle = 0;
+
+    if (!list(lister, dir, push))
+    {
+      return;
+    }
+    --pending;
+  }
+}
+
+template<typename P>
+bool filesystem_walker<P>::take(std::vector<work_queue>& queues, std::size_t self, path_type& dir)
+{
+  // Depth first on the own queue keeps it short, the oldest directories of others are the largest pieces of work
+  for (auto i = std::size_t{ 0 }; i < queues.size(); ++i)
+  {
+    auto& q = queues[(self + i) % queues.size()];
+    std::lock_guard<decltype(q.mtx)> lock{ q.mtx };
+    if (!q.dirs.empty())
+    {
+      if (i == 0)
+      {
+        dir = std::move(q.dirs.back());
+        q.dirs.pop_back();
+      }
+      else
+      {
+        dir = std::move(q.dirs.front());
+        q.dirs.pop_front();
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<typename P>
+template<typename F>
+bool filesystem_walker<P>::list(file_lister& l, const path_type& dir, const F& push)
+{
+  // Unreadable directories are skipped
+  if (!open(l.reader, path_string(dir)))
+  {
+    return true;
+  }
+
+  l.name.assign(path_string(dir));
+  if (l.name.empty() || !is_path_separator(l.name.back()))
+  {
+    l.name.push_back('/');
+  }
+  const auto base = l.name.size();
+
+  // A directory being listed when the checkpoint resumed was saved skips the entries handled, unless it changed
+  auto skip = std::uint64_t{ 0 };
+  if (l.checkpoint != nullptr)
+  {
+    auto md = file_metadata{};
+    l.dir.assign(path_string(dir));
+    l.index = 0;
+    l.position = 0;
+    l.mtime = l.reader.status(md) ? to_nanoseconds(md.mtime) : 0;
+    const auto resumed = l.checkpoint->resumed.find(l.dir);
+    if (resumed != std::end(l.checkpoint->resumed) && resumed->second.mtime == l.mtime && l.mtime != 0)
+    {
+      skip = resumed->second.position;
+      l.position = skip;
+    }
+  }
+
+  auto entries = std::uint64_t{ 0 };
+  for (auto e = directory_reader::entry{}; l.reader.next(e); ++entries)
+  {
+    // Check if paused and wait till it isn't anymore
+    if (!proceed())
+    {
+      return false;
+    }
+
+    // Safe point for checkpoints, all entries before are handled
+    if (l.checkpoint != nullptr)
+    {
+      if (l.index < skip)
+      {
+        ++l.index;
+        continue;
+      }
+      if (!l.batch || l.batch->size == 0)
+      {
+        l.position = l.index;
+      }
+      if (!park(l))
+      {
+        return false;
+      }
+      ++l.index;
+    }
+
+    l.name.resize(base);
+    l.name.append(e.name);
+    if (pathlist_->excluded(std::string_view{ l.name }))
+    {
+      continue;
+    }
+
+    if (e.type == directory_reader::file_type::directory)
+    {
+      // With checkpoints, the files before are handed first, so the position never stays before a queued sub directory
+      if (l.checkpoint != nullptr && l.batch && l.batch->size > 0 && !deliver(l))
+      {
+        return false;
+      }
+      push(l.name);
+    }
+    else if (l.batch)
+    {
+      l.batch->indices[l.batch->size] = l.index;
+      l.batch->paths[l.batch->size++].assign(l.name);
+      if (l.batch->size == metadata_batch_size && !deliver(l))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      auto p = path_type{ l.name };
+      if ((!filter_predicate_func_ || filter_predicate_func_(p)) && !found(l, std::move(p)))
+      {
+        return false;
+      }
+    }
+
+    // Handled at once, a sub directory queued again when resuming would be walked twice
+    if (l.checkpoint != nullptr && (!l.batch || l.batch->size == 0))
+    {
+      l.position = l.index;
+    }
+  }
+  l.reader.close();
+
+  // With checkpoints, the directory is done once its files waiting for their metadata are handed
+  if (l.checkpoint != nullptr)
+  {
+    if (l.batch && l.batch->size > 0 && !deliver(l))
+    {
+      return false;
+    }
+    l.dir.clear();
+  }
+
+  return govern(entries, l.reader.bytes_read());
+}
+
+template<typename P>
+template<typename F>
+bool filesystem_walker<P>::list(change_lister& l, const path_type& dir, const F& push)
+{
+  using snapshot_type = directory_snapshot;
+
+  const auto dir_str = std::string{ path_string(dir) };
+  const auto former = l.snapshot->find(dir_str);
+  if (!open(l.reader, dir_str))
+  {
+    // Removed or unreadable, so are all files recorded below, unless reported when listing the changed parent
+    const auto sep = std::find_if(dir_str.rbegin(), dir_str.rend(), is_path_separator);
+    if (former == nullptr || (l.changed != nullptr && sep != dir_str.rend() &&
+      l.changed->dirty.count(std::string(dir_str.begin(), sep.base() - 1)) != 0))
+    {
+      return true;
+    }
+    return removed(l, dir_str, *former);
+  }
+
+  // Watched before the listing is read, so no later change is missed
+  if (l.watcher != nullptr && !l.watcher->add(dir_str))
+  {
+    l.unwatched = true;
+  }
+
+  auto md = file_metadata{};
+  if (!l.reader.status(md))
+  {
+    l.reader.close();
+    return former == nullptr || removed(l, dir_str, *former);
+  }
+
+  l.name.assign(dir_str);
+  if (l.name.empty() || !is_path_separator(l.name.back()))
+  {
+    l.name.push_back('/');
+  }
+  const auto base = l.name.size();
+
+  auto r = snapshot_type::record{};
+  r.inode = md.inode;
+  r.mtime = to_nanoseconds(md.mtime);
+  if (!l.forced && former != nullptr && former->inode == r.inode && former->mtime == r.mtime && r.mtime != 0)
+  {
+    // Unchanged listing, only the sub directories are visited
+    l.reader.close();
+    for (const auto& i : former->entries)
+    {
+      l.name.resize(base);
+      l.name.append(i.name);
+      if (i.type == snapshot_type::entry_type::directory && !pathlist_->excluded(std::string_view{ l.name }))
+      {
+        push(l.name);
+      }
+    }
+    l.unchanged.push_back(dir_str);
+    return govern(0, 0);
+  }
+
+  // Listing changed directories again, only new directories are walked, or all below a created one
+  const auto deep = l.changed == nullptr || beneath(dir_str, l.changed->created);
+  auto entries = std::uint64_t{ 0 };
+  for (auto e = directory_reader::entry{}; l.reader.next(e); ++entries)
+  {
+    // Check if paused and wait till it isn't anymore
+    if (!proceed())
+    {
+      return false;
+    }
+
+    l.name.resize(base);
+    l.name.append(e.name);
+    if (pathlist_->excluded(std::string_view{ l.name }))
+    {
+      continue;
+    }
+
+    if (e.type == directory_reader::file_type::directory)
+    {
+      r.entries.push_back(snapshot_type::entry{ std::string{ e.name }, snapshot_type::entry_type::directory, 0, 0 });
+      if (deep || l.snapshot->find(l.name) == nullptr)
+      {
+        push(l.name);
+      }
+    }
+    else
+    {
+      // Files removed meanwhile are left out
+      auto file_md = file_metadata{};
+      if (l.reader.status(e, file_md) && taken(path_type{ l.name }, file_md))
+      {
+        r.entries.push_back(snapshot_type::entry{ std::string{ e.name }, snapshot_type::entry_type::file, file_md.size,
+          to_nanoseconds(file_md.mtime) });
+      }
+    }
+  }
+  l.reader.close();
+
+  std::sort(std::begin(r.entries), std::end(r.entries), [](const auto& a, const auto& b) { return a.name < b.name; });
+
+  // A listing changed within the timestamp granularity may change again unnoticed, so it is read again next time
+  if (std::chrono::system_clock::now() - md.mtime < std::chrono::seconds{ 2 })
+  {
+    r.mtime = 0;
+  }
+
+  // Compare with the former listing, both are sorted by name
+  static const auto none = snapshot_type::record{};
+  const auto& before = former != nullptr ? *former : none;
+  auto i = std::begin(before.entries);
+  auto j = std::begin(r.entries);
+  const auto report = [&l, base](std::string_view n, change c)
+  {
+    l.name.resize(base);
+    l.name.append(n);
+    (*l.change_func)(path_type{ l.name }, c);
+  };
+  while (i != std::end(before.entries) || j != std::end(r.entries))
+  {
+    if (!proceed())
+    {
+      return false;
+    }
+
+    const auto c = i == std::end(before.entries) ? 1 : (j == std::end(r.entries) ? -1 : i->name.compare(j->name));
+    const auto is_file = [](const auto& e) { return e.type == snapshot_type::entry_type::file; };
+
+    // Entries gone or replaced by another type, files of former directories are removed with their listing
+    if (c < 0 || (c == 0 && i->type != j->type))
+    {
+      if (is_file(*i))
+      {
+        report(i->name, change::removed);
+      }
+      else
+      {
+        l.name.resize(base);
+        l.name.append(i->name);
+        const auto sub = std::string{ l.name };
+        const auto sub_record = l.snapshot->find(sub);
+        if (sub_record != nullptr && !removed(l, sub, *sub_record))
+        {
+          return false;
+        }
+      }
+    }
+
+    // New entries, files of new directories are reported when listing them
+    if ((c > 0 || (c == 0 && i->type != j->type)) && is_file(*j))
+    {
+      report(j->name, change::added);
+    }
+
+    if (c == 0 && i->type == j->type && is_file(*i) && (i->size != j->size || i->mtime != j->mtime))
+    {
+      report(j->name, change::modified);
+    }
+
+    i += c <= 0 ? 1 : 0;
+    j += c >= 0 ? 1 : 0;
+  }
+
+  l.records.emplace_back(dir_str, std::move(r));
+  return govern(entries, l.reader.bytes_read());
+}
+
+template<typename P>
+bool filesystem_walker<P>::flush(file_lister& l)
+{
+  return !l.batch || deliver(l);
+}
+
+template<typename P>
+bool filesystem_walker<P>::flush(change_lister&)
+{
+  return true;
+}
+
+template<typename P>
+bool filesystem_walker<P>::deliver(file_lister& l)
+{
+  auto& batch = *l.batch;
+  batch.fetcher.fetch(batch.paths.data(), batch.size, batch.metadata.data());
+  const auto size = batch.size;
+  batch.size = 0;
+  for (auto i = std::size_t{ 0 }; i < size; ++i)
+  {
+    if (!proceed())
+    {
+      return false;
+    }
+
+    auto p = path_type{ batch.paths[i] };
+    if (metadata_filter_func_(p, batch.metadata[i]) && !found(l, std::move(p)))
+    {
+      return false;
+    }
+
+    // Stopped while delivering, the position covers the files handed so far
+    if (l.checkpoint != nullptr)
+    {
+      l.position = batch.indices[i];
+    }
+  }
+
+  return true;
+}
+
+template<typename P>
+bool filesystem_walker<P>::found(file_lister& l, path_type p)
+{
+  if (l.results == nullptr)
+  {
+    (*l.filefound_func)(std::move(p));
+    return true;
+  }
+
+  // Backpressure, the consumer is behind
+  for (auto idle = 0u; !l.results->try_push(std::move(p));)
+  {
+    if (!proceed())
+    {
+      return false;
+    }
+    if (++idle < 64)
+    {
+      std::this_thread::yield();
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+    }
+  }
+  ++l.pushed;
+
+  return true;
+}
+
+template<typename P>
+bool filesystem_walker<P>::removed(change_lister& l, const std::string& dir, const directory_snapshot::record& r)
+{
+  l.erased.push_back(dir);
+  for (const auto& i : r.entries)
+  {
+    if (!proceed())
+    {
+      return false;
+    }
+
+    auto p = dir;
+    if (p.empty() || !is_path_separator(p.back()))
+    {
+      p.push_back('/');
+    }
+    p.append(i.name);
+    if (i.type == directory_snapshot::entry_type::file)
+    {
+      (*l.change_func)(path_type{ p }, change::removed);
+    }
+    else
+    {
+      const auto sub_record = l.snapshot->find(p);
+      if (sub_record != nullptr && !removed(l, p, *sub_record))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+template<typename P>
+bool filesystem_walker<P>::beneath(const std::string& dir, const std::unordered_set<std::string>& dirs)
+{
+  if (dirs.empty())
+  {
+    return false;
+  }
+
+  for (auto n = dir.size(); n > 0; --n)
+  {
+    if ((n == dir.size() || is_path_separator(dir[n])) && dirs.count(dir.substr(0, n)) != 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<typename P>
+bool filesystem_walker<P>::taken(const path_type& p, const file_metadata& md) const
+{
+  return (!filter_predicate_func_ || filter_predicate_func_(p)) && (!metadata_filter_func_ || metadata_filter_func_(p, md));
+}
+
+template<typename P>
+std::int64_t filesystem_walker<P>::to_nanoseconds(std::chrono::system_clock::time_point t)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+template<typename P>
+bool filesystem_walker<P>::proceed()
+{
+  if (state_.load(std::memory_order_acquire) == state::running)
+  {
+    return true;
+  }
+
+  std::unique_lock<decltype(mtx_)> lock{ mtx_ };
+  condition_.wait(lock, [this] { return state_ != state::paused; });
+  return state_ == state::running;
 }
 
 } // namespace arude
 
-#endif // #ifndef INC_ARUDE_FILESYSTEM_WALKER_HPP
\ No newline at end of file
+#endif // #ifndef INC_ARUDE_FILESYSTEM_WALKER_HPP
@@ -0,0 +1,532 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_FLAT_BIMAP_HPP
+#define INC_ARUDE_FLAT_BIMAP_HPP
+
+
+#include "libarude/bimap.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace arude
+{
+namespace eytzinger
+{
+
+///
+/// Number of elements of type T fitting into one cache line.
+/// Used as prefetch distance, the descendants four levels down of a node are adjacent for 4 byte keys.
+///
+template<typename T>
+constexpr std::size_t cacheline_elements()
+{
+  return sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+}
+
+///
+/// Hints the CPU to load the cache line of the given address. NOOP on compilers without support.
+/// \param p Address to prefetch
+///
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+///
+/// Lays out a sorted sequence in Eytzinger (BFS) order.
+///
+/// The result is 1-based, element 0 is a copy of the first element and never used by the search.
+/// Every element is passed through \a proj before being stored, which allows to store indices alongside.
+///
+/// \param sorted Sorted input sequence
+/// \param out Output sequence, resized to sorted.size() + 1
+/// \param proj Projection applied to each element before storing it
+///
+template<typename T, typename U, typename F>
+void layout(const std::vector<T>& sorted, std::vector<U>& out, F proj)
+{
+  out.clear();
+  if (sorted.empty())
+  {
+    return;
+  }
+
+  out.assign(sorted.size() + 1, proj(sorted.front()));
+
+  // Iterative in-order walk of the implicit tree
+  auto i = std::size_t{ 0 };
+  auto k = std::size_t{ 1 };
+  const auto n = sorted.size();
+  for (;;)
+  {
+    while (k <= n)
+    {
+      k <<= 1;
+    }
+
+    // Go up while we came from the right child
+    while ((k & 1) != 0)
+    {
+      k >>= 1;
+    }
+    k >>= 1;
+    if (k == 0)
+    {
+      break;
+    }
+
+    out[k] = proj(sorted[i++]);
+    k = 2 * k + 1;
+  }
+}
+
+///
+/// Branchless lower bound search in an Eytzinger laid out sequence.
+///
+/// \param keys Keys in Eytzinger order (1-based)
+/// \param n Number of keys, without the unused element 0
+/// \param v Value to search
+/// \param comp Strict weak ordering
+/// \return Position of the first key not less than \a v, or 0 if there is none
+///
+template<typename T, typename V, typename C>
+std::size_t lower_bound(const T* keys, std::size_t n, const V& v, C comp)
+{
+  constexpr auto stride = cacheline_elements<T>();
+
+  auto k = std::size_t{ 1 };
+  while (k <= n)
+  {
+    if (std::is_trivially_copyable<T>::value)
+    {
+      prefetch(keys + std::min(k * stride, n));
+    }
+    k = 2 * k + static_cast<std::size_t>(comp(keys[k], v));
+  }
+
+  // Undo the trailing right turns plus the last left turn
+#if defined(__GNUC__) || defined(__clang__)
+  k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+#else
+  while ((k & 1) != 0)
+  {
+    k >>= 1;
+  }
+  k >>= 1;
+#endif
+
+  return k;
+}
+
+///
+/// Runs several branchless lower bound searches interleaved.
+///
+/// All searches advance one tree level per round, the cache line of each next probe is prefetched a round before it is touched.
+/// This overlaps the memory latency of independent searches, which makes batch lookups throughput bound instead of latency bound.
+///
+/// \param keys Keys in Eytzinger order (1-based)
+/// \param n Number of keys, without the unused element 0
+/// \param v Values to search
+/// \param count Number of values
+/// \param result Receives the position of the first key not less than each value, or 0 if there is none
+/// \param comp Strict weak ordering
+///
+template<typename T, typename V, typename C>
+void lower_bound_n(const T* keys, std::size_t n, const V* v, std::size_t count, std::size_t* result, C comp)
+{
+  for (auto j = std::size_t{ 0 }; j < count; ++j)
+  {
+    result[j] = 1;
+  }
+
+  for (auto level = n; level != 0; level >>= 1)
+  {
+    for (auto j = std::size_t{ 0 }; j < count; ++j)
+    {
+      const auto k = result[j];
+      if (k <= n)
+      {
+        const auto next = 2 * k + static_cast<std::size_t>(comp(keys[k], v[j]));
+        prefetch(keys + std::min(next, n));
+        result[j] = next;
+      }
+    }
+  }
+
+  for (auto j = std::size_t{ 0 }; j < count; ++j)
+  {
+    auto k = result[j];
+    while ((k & 1) != 0)
+    {
+      k >>= 1;
+    }
+    result[j] = k >> 1;
+  }
+}
+
+} // namespace eytzinger
+
+template<typename LT, typename RT>
+class mapped_bimap_builder;
+
+///
+/// Flat variant of the bimap.
+///
+/// Both directions are kept in contiguous arrays in Eytzinger layout, lookups run a branchless binary search with software prefetching.
+/// The left and right keys are stored once each (struct of arrays), a permutation index per side maps a key to the position of its counterpart.
+/// Compared to the bimap there are no node allocations and no pointer chasing, which makes it the better choice for large tables that are built
+/// once and read often.
+/// The flat bimap is initialized on construction and immutable afterwards.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+///
+template<typename LT, typename RT>
+class flat_bimap
+{
+  static_assert(!std::is_same<LT, RT>::value, "flat_bimap can't map between equal left and right type");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using value_type = std::pair<left_type, right_type>; ///< Mapping type
+  using init_map_type = std::map<const left_type, right_type>; ///< Init map type
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  flat_bimap() = default;
+
+  ///
+  /// Ctor.
+  /// \param init Initializer list with mappings to initialize the bimap
+  ///
+  flat_bimap(std::initializer_list<value_type> init)
+    : flat_bimap(std::begin(init), std::end(init))
+  {
+  }
+
+  ///
+  /// Ctor.
+  /// \param init Map to initialize the bimap with
+  ///
+  flat_bimap(const init_map_type& init)
+    : flat_bimap(std::begin(init), std::end(init))
+  {
+  }
+
+  ///
+  /// Ctor.
+  /// \param init Bimap to initialize the bimap with
+  ///
+  template<typename A>
+  flat_bimap(const bimap<left_type, right_type, A>& init)
+    : flat_bimap(std::begin(init.leftmap()), std::end(init.leftmap()))
+  {
+  }
+
+  ///
+  /// Ctor.
+  ///
+  /// \tparam InputIt Input iterator with pair like values
+  /// \param first First mapping
+  /// \param last Past the end mapping
+  ///
+  template<typename InputIt>
+  flat_bimap(InputIt first, InputIt last)
+  {
+    auto mappings = std::vector<value_type>{};
+    for (; first != last; ++first)
+    {
+      mappings.emplace_back(first->first, first->second);
+    }
+
+    build(mappings);
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  const right_type& map(const left_type& v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  const left_type& map(const right_type& v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Looks up the second type value of a first type value. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Pointer to the second type value or nullptr if not mapped
+  ///
+  const right_type* find(const left_type& v) const
+  {
+    const auto k = eytzinger::lower_bound(m_left.data(), size(), v, std::less<left_type>{});
+    return k == 0 || std::less<left_type>{}(v, m_left[k]) ? nullptr : &m_right[m_l2r[k]];
+  }
+
+  ///
+  /// Looks up the first type value of a second type value. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return Pointer to the first type value or nullptr if not mapped
+  ///
+  const left_type* find(const right_type& v) const
+  {
+    const auto k = eytzinger::lower_bound(m_right.data(), size(), v, std::less<right_type>{});
+    return k == 0 || std::less<right_type>{}(v, m_right[k]) ? nullptr : &m_left[m_r2l[k]];
+  }
+
+  ///
+  /// Map first to second type. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Second type value or empty if not mapped
+  ///
+  std::optional<right_type> try_map(const left_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<right_type>{} : std::optional<right_type>{ *p };
+  }
+
+  ///
+  /// Map second to first type. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return First type value or empty if not mapped
+  ///
+  std::optional<left_type> try_map(const right_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<left_type>{} : std::optional<left_type>{ *p };
+  }
+
+  ///
+  /// Maps a batch of first type values to the second type.
+  /// The searches run interleaved in groups with prefetching, see eytzinger::lower_bound_n.
+  ///
+  /// \param in First type values to map
+  /// \param n Number of values
+  /// \param out Receives the second type values, untouched where not mapped
+  /// \param missing Resized to \a n, set where a value is not mapped
+  /// \return Number of values not mapped
+  ///
+  size_type map_n(const left_type* in, size_type n, right_type* out, std::vector<bool>& missing) const
+  {
+    return map_n_impl(m_left, m_right, m_l2r, in, n, out, missing);
+  }
+
+  ///
+  /// Maps a batch of second type values to the first type.
+  /// \see map_n
+  ///
+  /// \param in Second type values to map
+  /// \param n Number of values
+  /// \param out Receives the first type values, untouched where not mapped
+  /// \param missing Resized to \a n, set where a value is not mapped
+  /// \return Number of values not mapped
+  ///
+  size_type map_n(const right_type* in, size_type n, left_type* out, std::vector<bool>& missing) const
+  {
+    return map_n_impl(m_right, m_left, m_r2l, in, n, out, missing);
+  }
+
+  ///
+  /// Returns the size of the bimap.
+  /// \return Size
+  ///
+  size_type size() const
+  {
+    return m_left.empty() ? 0 : m_left.size() - 1;
+  }
+
+  ///
+  /// Says if the bimap is empty.
+  /// \return True if empty
+  ///
+  bool empty() const
+  {
+    return m_left.empty();
+  }
+
+// Implementation
+private:
+  ///
+  /// Batch lookup from one side to the other.
+  /// \see map_n
+  ///
+  template<typename K, typename V>
+  size_type map_n_impl(const std::vector<K>& keys, const std::vector<V>& values, const std::vector<size_type>& perm, const K* in, size_type n, V* out,
+    std::vector<bool>& missing) const
+  {
+    constexpr auto group = size_type{ 16 };
+
+    missing.assign(n, false);
+
+    auto misses = size_type{ 0 };
+    size_type pos[group];
+    for (auto first = size_type{ 0 }; first < n; first += group)
+    {
+      const auto count = std::min(group, n - first);
+      eytzinger::lower_bound_n(keys.data(), size(), in + first, count, pos, std::less<K>{});
+
+      for (auto j = size_type{ 0 }; j < count; ++j)
+      {
+        const auto k = pos[j];
+        if (k == 0 || std::less<K>{}(in[first + j], keys[k]))
+        {
+          missing[first + j] = true;
+          ++misses;
+        }
+        else
+        {
+          out[first + j] = values[perm[k]];
+        }
+      }
+    }
+
+    return misses;
+  }
+
+  ///
+  /// Builds the Eytzinger arrays and permutation indices from an unsorted list of mappings.
+  /// \param mappings Mappings, reordered by this function
+  ///
+  void build(std::vector<value_type>& mappings)
+  {
+    const auto n = mappings.size();
+
+    // Left side, sorted by left value
+    std::sort(std::begin(mappings), std::end(mappings),
+      [](const value_type& a, const value_type& b) { return std::less<left_type>{}(a.first, b.first); });
+    check_unique(mappings, [](const value_type& a, const value_type& b) { return std::less<left_type>{}(a.first, b.first); });
+
+    // Right side as index into the left sorted mappings
+    auto rorder = std::vector<size_type>(n);
+    std::iota(std::begin(rorder), std::end(rorder), size_type{ 0 });
+    std::sort(std::begin(rorder), std::end(rorder),
+      [&mappings](size_type a, size_type b) { return std::less<right_type>{}(mappings[a].second, mappings[b].second); });
+    check_unique(rorder, [&mappings](size_type a, size_type b) { return std::less<right_type>{}(mappings[a].second, mappings[b].second); });
+
+    // Sorted position of every Eytzinger position and vice versa, equal for both sides
+    auto sorted = std::vector<size_type>(n);
+    std::iota(std::begin(sorted), std::end(sorted), size_type{ 0 });
+    auto pos = std::vector<size_type>{};
+    eytzinger::layout(sorted, pos, [](size_type i) { return i; });
+    auto inv = std::vector<size_type>(n + 1);
+    for (auto k = size_type{ 1 }; k <= n; ++k)
+    {
+      inv[pos[k]] = k;
+    }
+
+    // Sorted left index -> sorted right index
+    auto rsortedof = std::vector<size_type>(n);
+    for (auto i = size_type{ 0 }; i < n; ++i)
+    {
+      rsortedof[rorder[i]] = i;
+    }
+
+    // Fill the key arrays and the permutation indices
+    eytzinger::layout(mappings, m_left, [](const value_type& m) { return m.first; });
+    eytzinger::layout(rorder, m_right, [&mappings](size_type i) { return mappings[i].second; });
+    m_l2r.assign(n + 1, 0);
+    m_r2l.assign(n + 1, 0);
+    for (auto k = size_type{ 1 }; k <= n; ++k)
+    {
+      m_l2r[k] = inv[rsortedof[pos[k]]];
+      m_r2l[k] = inv[rorder[pos[k]]];
+    }
+  }
+
+  ///
+  /// Throws if two neighbouring elements of a sorted sequence are equal.
+  /// \param sorted Sorted sequence
+  /// \param comp Strict weak ordering the sequence is sorted by
+  ///
+  template<typename T, typename C>
+  static void check_unique(const std::vector<T>& sorted, C comp)
+  {
+    const auto iter = std::adjacent_find(std::begin(sorted), std::end(sorted), [&comp](const T& a, const T& b) { return !comp(a, b); });
+    if (iter != std::end(sorted))
+    {
+      BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
+    }
+  }
+
+// Friends
+private:
+  friend class mapped_bimap_builder<left_type, right_type>; ///< Writes the arrays to a file
+
+// Variables
+private:
+  std::vector<left_type> m_left; ///< Left keys in Eytzinger order
+  std::vector<right_type> m_right; ///< Right keys in Eytzinger order
+  std::vector<size_type> m_l2r; ///< Position of the right key for each left key
+  std::vector<size_type> m_r2l; ///< Position of the left key for each right key
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_FLAT_BIMAP_HPP
@@ -27,13 +27,27 @@
 #ifndef INC_ARUDE_INCLUDEEXCLUDE_PATHLIST_HPP
 #define INC_ARUDE_INCLUDEEXCLUDE_PATHLIST_HPP
 
+#include "libarude/path_components.hpp"
+#include "libarude/path_pattern_set.hpp"
+#include "libarude/path_prefix_index.hpp"
+#include "libarude/path_trie.hpp"
+
 #include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 
 namespace arude
 {
 
+template<typename P>
+class compiled_pathlist;
+
 ///
 /// Path list containing paths that should be included and paths that should be excluded.
 /// This allows to for deep directory trees to exclude distinct directories.
@@ -42,9 +56,18 @@ namespace arude
 /// This class is not meant to hold a simple list of paths, a vector of paths would suit this situation better.
 ///
 /// To correctly fill this class from a list, first add all include paths and then all exclude paths.
+/// Paths are compared by components, trailing separators and "." components are ignored. The include paths form a root table, exclude paths are
+/// held relative to the deepest include path above them. Both are also held in path_tries, so testing a path for exclusion is O(depth)
+/// regardless of the number of exclude paths and does not allocate.
+/// Besides paths, exclude patterns like "**/node_modules" or "*.tmp" can be added, see path_pattern_set for the syntax. All patterns are compiled
+/// into one automaton, so they are matched in a single pass as well.
+/// Large blocks of paths are best tested at once with excluded_n(), which resolves them in one merge pass over a sorted path_prefix_index.
+/// Large lists are best loaded with assign() and combined with set_union(), set_intersection() and set_difference(), all sorting the paths once
+/// and merging them in a single pass.
 /// This container is optimized for access, not for modification. This container is as thread safe as a std::vector.
+/// For concurrent readers, compile() the list into an immutable compiled_pathlist and share that, see concurrent_pathlist.
 ///
-/// \tparam P Path type
+/// \tparam P Path type, e.g. boost::filesystem::path or compact_path which tests without allocating
 ///
 template<typename P>
 class includexclude_pathlist final
@@ -52,12 +75,31 @@ class includexclude_pathlist final
 // Typedefs
 public:
   using path_type = P; ///< Path type
+  using size_type = std::size_t; ///< Size type
+  using root_id = path_prefix_index::root_id; ///< Root id type, 0 for none and the position in the include path list plus one otherwise
+
+  ///
+  /// Exclude path relative to the deepest include path above it.
+  ///
+  struct rooted_path
+  {
+    root_id root; ///< Root id
+    std::string suffix; ///< Remainder of the path string after the root
+  };
+
   using path_includelist_type = std::vector<path_type>; ///< Type used to hold the path include list
-  using path_excludelist_type = std::vector<path_type>; ///< Type used to hold the path exclude list
-  using iterator = path_includelist_type::iterator; ///< Iterator type for include list access
-  using const_iterator = path_includelist_type::const_iterator; ///< Iterator type for const include list access
-  using reverse_iterator = path_includelist_type::reverse_iterator; ///< Iterator type for reverse include list access
-  using const_reverse_iterator = path_includelist_type::const_reverse_iterator; ///< Iterator type for reverse const include list access
+  using path_excludelist_type = std::vector<rooted_path>; ///< Type used to hold the path exclude list
+  using iterator = typename path_includelist_type::iterator; ///< Iterator type for include list access
+  using const_iterator = typename path_includelist_type::const_iterator; ///< Iterator type for const include list access
+  using reverse_iterator = typename path_includelist_type::reverse_iterator; ///< Iterator type for reverse include list access
+  using const_reverse_iterator = typename path_includelist_type::const_reverse_iterator; ///< Iterator type for reverse const include list access
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  includexclude_pathlist();
 
 // Accessors
 public:
@@ -141,13 +183,62 @@ public:
   ///
   bool excluded(const path_type& p) const;
 
+  ///
+  /// Says if a path given as string is excluded.
+  ///
+  /// \param p Path string to test for exclusion
+  /// \return True if excluded
+  ///
+  bool excluded(std::string_view p) const noexcept;
+
+  ///
+  /// Says for a batch of path strings which ones are excluded.
+  ///
+  /// The batch is sorted once and merged against the sorted include and exclude paths in a single pass, the result equals calling excluded()
+  /// for each path.
+  ///
+  /// \param in Path strings to test for exclusion
+  /// \param n Number of paths
+  /// \param excluded Resized to \a n, set where a path is excluded
+  /// \return Number of excluded paths
+  ///
+  size_type excluded_n(const std::string_view* in, size_type n, std::vector<bool>& excluded) const;
+
+  ///
+  /// Says for a batch of paths which ones are excluded.
+  /// \see excluded_n
+  ///
+  /// \param in Paths to test for exclusion
+  /// \param n Number of paths
+  /// \param excluded Resized to \a n, set where a path is excluded
+  /// \return Number of excluded paths
+  ///
+  size_type excluded_n(const path_type* in, size_type n, std::vector<bool>& excluded) const;
+
+  ///
+  /// Returns the exclude patterns.
+  /// \return Exclude patterns
+  ///
+  const path_pattern_set& exclude_patterns() const;
+
+  ///
+  /// Compiles the list into an immutable snapshot.
+  ///
+  /// The snapshot holds a compacted copy of the list, nodes left unmarked by removed paths are dropped. It is meant to be shared between
+  /// threads, all of its members are const.
+  ///
+  /// \return Snapshot
+  ///
+  std::unique_ptr<const compiled_pathlist<P>> compile() const;
+
 // Modifiers
 public:
   ///
   /// Adds an include path.
   ///
-  /// No live filesystem access required. Filename and extensions are lost.
+  /// No live filesystem access required. The path is taken as directory.
   /// The path give must be an absolute path or an exception is thrown.
+  /// Include paths which are sub paths of \a p are dropped, as the walk of \a p covers them.
   ///
   /// \param p Path to include
   /// \param recursive If true, recursively removes all exclude paths which are sub paths of \a p
@@ -157,7 +248,7 @@ public:
   ///
   /// Adds an exclude path.
   ///
-  /// No live filesystem access required. Filename and extensions are lost.
+  /// No live filesystem access required. The path is taken as directory.
   /// The path give must be an absolute path or an exception is thrown.
   /// An exclude path must always be a sub path of an already registered include path or this operation has no effect.
   /// No recursive flag available as all sub paths are implicitely excluded as well. If this is not desired, the dedicated paths need to be included each.
@@ -166,6 +257,44 @@ public:
   ///
   void add_excludepath(const path_type& p);
 
+  ///
+  /// Adds an exclude pattern.
+  ///
+  /// Paths matching the pattern and all their sub paths are excluded, regardless of the include paths.
+  /// \see path_pattern_set
+  ///
+  /// \param pattern Pattern to exclude
+  ///
+  void add_excludepattern(std::string_view pattern);
+
+  ///
+  /// Adds a range of exclude patterns, compiling them once.
+  /// \see add_excludepattern
+  ///
+  /// \tparam InputIt Input iterator with a value type convertible to std::string_view
+  /// \param first First pattern
+  /// \param last Last pattern
+  ///
+  template<typename InputIt>
+  void add_excludepatterns(InputIt first, InputIt last);
+
+  ///
+  /// Replaces the include and exclude paths.
+  ///
+  /// The result equals clearing the paths, adding all include paths non recursively and then all exclude paths. The paths are sorted once and
+  /// redundant sub paths are dropped in a single merge pass, so this is O(n log n) while adding the paths one by one is quadratic.
+  /// The exclude patterns are kept. If a path is relative, an exception is thrown and the list is unchanged.
+  ///
+  /// \tparam IncludeIt Input iterator over include paths
+  /// \tparam ExcludeIt Input iterator over exclude paths
+  /// \param include_first First include path
+  /// \param include_last Last include path
+  /// \param exclude_first First exclude path
+  /// \param exclude_last Last exclude path
+  ///
+  template<typename IncludeIt, typename ExcludeIt>
+  void assign(IncludeIt include_first, IncludeIt include_last, ExcludeIt exclude_first, ExcludeIt exclude_last);
+
   ///
   /// Sorts the include and exclude lists by name.
   /// This might optimize access. (Simple ASCII based sort)
@@ -177,6 +306,9 @@ public:
   ///
   /// With "/foo/bar" as old root and "/foo/rab" as new root, "/foo/bar/blubb" becomes "/foo/rab/blubb".
   /// Only directories with the old root given as parent part are affected.
+  /// Exclude paths are stored relative to their include path, so if the old root is an include path or a parent of include paths only the moved
+  /// include paths are updated in the root table, regardless of the number of include and exclude paths. Otherwise, e.g. if the old root is
+  /// inside an include path, include paths start to nest or there are exclude paths below no include path, all paths are rewritten.
   ///
   /// \param old_root Old root to replace
   /// \param new_root New root to set
@@ -190,6 +322,56 @@ public:
 
 // Implementation
 private:
+  ///
+  /// Path with its key in a shared key buffer, see path_prefix_index.
+  ///
+  struct keyed_path
+  {
+    size_type offset; ///< Offset of the key
+    size_type size; ///< Size of the key
+    path_trie::mark m; ///< Mark of the path
+    const std::string* p; ///< Path string
+    unsigned side; ///< Operand the path belongs to
+  };
+
+  ///
+  /// Appends the keys of all path strings of a container.
+  ///
+  /// \param container Container holding the path strings
+  /// \param m Mark of the paths
+  /// \param side Operand the paths belong to
+  /// \param keys Key buffer to append to
+  /// \param out Receives the keyed paths
+  ///
+  static void append_keys(const std::vector<std::string>& container, path_trie::mark m, unsigned side, std::string& keys,
+    std::vector<keyed_path>& out);
+
+  ///
+  /// Sorts keyed paths by key, include marks first on equal keys.
+  /// \param keys Key buffer
+  /// \param v Keyed paths to sort
+  ///
+  static void sort_keys(std::string_view keys, std::vector<keyed_path>& v);
+
+  ///
+  /// Combines two path lists with a set operation in one merge pass.
+  ///
+  /// \param a First path list
+  /// \param b Second path list
+  /// \param op Function taking if a location is included in \a a and in \a b, returning if it is included in the result
+  /// \return Combined path list without exclude patterns
+  ///
+  template<typename F>
+  static includexclude_pathlist combine(const includexclude_pathlist& a, const includexclude_pathlist& b, F op);
+
+  ///
+  /// Says if a pattern set has all patterns of another one.
+  /// \param a Pattern set
+  /// \param b Pattern set whose patterns are searched in \a a
+  /// \return True if \a a has all patterns of \a b
+  ///
+  static bool has_patterns(const path_pattern_set& a, const path_pattern_set& b);
+
   ///
   /// Replaces all roots of paths in a range based for compatible container with another.
   /// \see reroot
@@ -198,102 +380,377 @@ private:
   /// \param old_root Old root to replace
   /// \param new_root New root to set
   ///
+  template<typename C>
+  static void reroot_container(C& container, std::string_view old_root, std::string_view new_root);
+
+  ///
+  /// Removes all paths which are sub paths of another path from a container.
+  ///
+  /// \param container Container to remove paths from
+  /// \param p Parent path string
+  /// \param self If true, \a p itself is removed as well
   ///
   template<typename C>
-  void reroot_container(C& container, const path_type& old_root, const path_type& new_root);
+  static void erase_subpaths(C& container, std::string_view p, bool self);
+
+  ///
+  /// Removes a path from a container.
+  ///
+  /// \param container Container to remove the path from
+  /// \param p Path string
+  ///
+  template<typename C>
+  static void erase_path(C& container, std::string_view p);
+
+  ///
+  /// Splits a path at its deepest include path.
+  /// \param p Path string
+  /// \return Root id of the deepest include path above or at \a p, 0 if none, and the offset of the remainder of \a p
+  ///
+  std::pair<root_id, size_type> split(std::string_view p) const noexcept;
+
+  ///
+  /// Says if a path is included, that is below an include path and not excluded by an exclude path.
+  /// \param p Path string
+  /// \return True if included
+  ///
+  bool included(std::string_view p) const noexcept;
+
+  ///
+  /// Returns the full path string of an exclude path.
+  /// \param e Exclude path
+  /// \return Path string
+  ///
+  std::string full_path(const rooted_path& e) const;
+
+  ///
+  /// Returns the full path strings of all exclude paths.
+  /// \return Path strings
+  ///
+  std::vector<std::string> exclude_strings() const;
+
+  ///
+  /// Rebuilds the root table, the exclude paths, the trie and the prefix index from the include paths and exclude path strings.
+  /// \param excludes Full path strings of all exclude paths
+  ///
+  void rebuild(const std::vector<std::string>& excludes);
 
 // Variables
 private:
-  path_includelist_type include_paths_; ///< Holds a list of all include paths
-  path_excludelist_type exclude_paths_; ///< Holds a list of all exclude paths
+  path_includelist_type include_paths_; ///< Holds a list of all include paths, which are the roots of the exclude paths
+  path_excludelist_type exclude_paths_; ///< Holds a list of all exclude paths relative to their root
+  path_trie roots_; ///< Root table, all include paths marked as include
+  std::vector<root_id> root_of_node_; ///< Root id of each node in roots_
+  size_type unrooted_excludes_ = 0; ///< Number of exclude paths below no include path, relative to root 0
+  path_trie trie_; ///< All exclude paths below the node of their root
+  std::vector<path_trie::node_id> root_nodes_; ///< Node of each root in trie_
+  path_prefix_index index_; ///< All exclude paths sorted by root and key, and the include paths as its roots
+  path_pattern_set exclude_patterns_; ///< Holds all exclude patterns
+
+// Friends
+private:
+  template<typename Q>
+  friend includexclude_pathlist<Q> set_union(const includexclude_pathlist<Q>& a, const includexclude_pathlist<Q>& b);
+  template<typename Q>
+  friend includexclude_pathlist<Q> set_intersection(const includexclude_pathlist<Q>& a, const includexclude_pathlist<Q>& b);
+  template<typename Q>
+  friend includexclude_pathlist<Q> set_difference(const includexclude_pathlist<Q>& a, const includexclude_pathlist<Q>& b);
 };
 
+///
+/// Returns the union of two path lists, including every location included by either list.
+///
+/// Sorts both lists once and merges them in a single pass, O(n log n). The exclude patterns of a list only exclude what that list includes, so
+/// the union can only be represented if both lists have the same exclude patterns, or one list includes nothing. Otherwise an exception is
+/// thrown.
+///
+/// \param a First path list
+/// \param b Second path list
+/// \return Union
+///
+template<typename P>
+includexclude_pathlist<P> set_union(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b);
 
+///
+/// Returns the intersection of two path lists, including every location included by both lists.
+///
+/// Sorts both lists once and merges them in a single pass, O(n log n). The exclude patterns of both lists apply to the result.
+///
+/// \param a First path list
+/// \param b Second path list
+/// \return Intersection
+///
 template<typename P>
-includexclude_pathlist<P>::iterator includexclude_pathlist<P>::begin()
+includexclude_pathlist<P> set_intersection(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b);
+
+///
+/// Returns the difference of two path lists, including every location included by the first but not by the second list.
+///
+/// Sorts both lists once and merges them in a single pass, O(n log n). The exclude patterns of the first list apply to the result. A location
+/// excluded by a pattern of the second list stays in the difference, which can only be represented if the first list has all exclude patterns
+/// of the second one, or the second list includes nothing. Otherwise an exception is thrown.
+///
+/// \param a First path list
+/// \param b Second path list
+/// \return Difference
+///
+template<typename P>
+includexclude_pathlist<P> set_difference(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b);
+
+///
+/// Immutable snapshot of an includexclude_pathlist, created by includexclude_pathlist::compile().
+///
+/// Offers all read accessors of the path list. Being immutable, a snapshot can be read from any number of threads without a lock.
+///
+/// \tparam P Path type
+///
+template<typename P>
+class compiled_pathlist final
+{
+// Typedefs
+public:
+  using pathlist_type = includexclude_pathlist<P>; ///< Path list type
+  using path_type = typename pathlist_type::path_type; ///< Path type
+  using size_type = typename pathlist_type::size_type; ///< Size type
+  using const_iterator = typename pathlist_type::const_iterator; ///< Iterator type for const include list access
+
+// Structors
+private:
+  ///
+  /// Ctor.
+  /// \param l Compacted path list
+  ///
+  explicit compiled_pathlist(pathlist_type l)
+    : list_{ std::move(l) }
+  {
+  }
+
+// Accessors
+public:
+  ///
+  /// Returns an iterator to the first element of the include path list.
+  /// \return Iterator
+  ///
+  const_iterator begin() const
+  {
+    return list_.begin();
+  }
+
+  ///
+  /// Returns an iterator to the element following the last element of the include path list.
+  /// \return Iterator
+  ///
+  const_iterator end() const
+  {
+    return list_.end();
+  }
+
+  ///
+  /// Says if a path is excluded.
+  /// \see includexclude_pathlist::excluded
+  ///
+  bool excluded(const path_type& p) const
+  {
+    return list_.excluded(p);
+  }
+
+  ///
+  /// Says if a path given as string is excluded.
+  /// \see includexclude_pathlist::excluded
+  ///
+  bool excluded(std::string_view p) const noexcept
+  {
+    return list_.excluded(p);
+  }
+
+  ///
+  /// Says for a batch of path strings which ones are excluded.
+  /// \see includexclude_pathlist::excluded_n
+  ///
+  size_type excluded_n(const std::string_view* in, size_type n, std::vector<bool>& excluded) const
+  {
+    return list_.excluded_n(in, n, excluded);
+  }
+
+  ///
+  /// Says for a batch of paths which ones are excluded.
+  /// \see includexclude_pathlist::excluded_n
+  ///
+  size_type excluded_n(const path_type* in, size_type n, std::vector<bool>& excluded) const
+  {
+    return list_.excluded_n(in, n, excluded);
+  }
+
+  ///
+  /// Returns the exclude patterns.
+  /// \return Exclude patterns
+  ///
+  const path_pattern_set& exclude_patterns() const
+  {
+    return list_.exclude_patterns();
+  }
+
+  ///
+  /// Returns the path list the snapshot was compiled from.
+  /// \return Path list
+  ///
+  const pathlist_type& pathlist() const
+  {
+    return list_;
+  }
+
+// Friends
+private:
+  friend class includexclude_pathlist<P>;
+
+// Variables
+private:
+  const pathlist_type list_; ///< Compacted path list
+};
+
+
+template<typename P>
+typename includexclude_pathlist<P>::iterator includexclude_pathlist<P>::begin()
 {
   return std::begin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::begin() const
+typename includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::begin() const
 {
   return std::begin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::cbegin() const
+typename includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::cbegin() const
 {
   return std::cbegin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::iterator includexclude_pathlist<P>::end()
+typename includexclude_pathlist<P>::iterator includexclude_pathlist<P>::end()
 {
   return std::end(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::end() const
+typename includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::end() const
 {
   return std::end(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::cend() const
+typename includexclude_pathlist<P>::const_iterator includexclude_pathlist<P>::cend() const
 {
   return std::cend(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::reverse_iterator includexclude_pathlist<P>::rbegin()
+typename includexclude_pathlist<P>::reverse_iterator includexclude_pathlist<P>::rbegin()
 {
   return std::rbegin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::rbegin() const
+typename includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::rbegin() const
 {
   return std::rbegin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::crbegin() const
+typename includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::crbegin() const
 {
   return std::crbegin(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::reverse_iterator includexclude_pathlist<P>::rend()
+typename includexclude_pathlist<P>::reverse_iterator includexclude_pathlist<P>::rend()
 {
   return std::rend(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::rend() const
+typename includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::rend() const
 {
   return std::rend(include_paths_);
 }
 
 template<typename P>
-includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::crend() const
+typename includexclude_pathlist<P>::const_reverse_iterator includexclude_pathlist<P>::crend() const
 {
   return std::crend(include_paths_);
 }
 
+template<typename P>
+includexclude_pathlist<P>::includexclude_pathlist()
+{
+  rebuild({});
+}
+
 template<typename P>
 bool includexclude_pathlist<P>::excluded(const path_type& p) const
 {
-  decltype(auto) p_str = p.has_stem() ? p.string() : decltype(p){ p }.remove_filename().string();
-  for (const auto& i : exclude_paths_)
+  const auto& p_str = path_string(p);
+  return excluded(std::string_view{ p_str });
+}
+
+template<typename P>
+bool includexclude_pathlist<P>::excluded(std::string_view p) const noexcept
+{
+  const auto s = split(p);
+  return trie_.lookup(p.substr(s.second), root_nodes_[s.first]) == path_trie::mark::exclude || exclude_patterns_.matches(p);
+}
+
+template<typename P>
+typename includexclude_pathlist<P>::size_type includexclude_pathlist<P>::excluded_n(const std::string_view* in, size_type n, std::vector<bool>& excluded) const
+{
+  // The index resolves the roots within the merge
+  auto marks = std::vector<path_trie::mark>(n);
+  index_.resolve_n(in, n, marks.data());
+
+  excluded.assign(n, false);
+  auto retval = size_type{ 0 };
+  for (auto i = size_type{ 0 }; i < n; ++i)
   {
-    if (i.string().find(p_str) == 0)
+    if (marks[i] == path_trie::mark::exclude || (!exclude_patterns_.empty() && exclude_patterns_.matches(in[i])))
     {
-      return true;
+      excluded[i] = true;
+      ++retval;
     }
   }
 
-  return false;
+  return retval;
+}
+
+template<typename P>
+typename includexclude_pathlist<P>::size_type includexclude_pathlist<P>::excluded_n(const path_type* in, size_type n, std::vector<bool>& excluded) const
+{
+  // Views only where the native format is narrow, owning strings otherwise
+  auto strings = std::vector<decltype(path_string(*in))>{};
+  strings.reserve(n);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    strings.push_back(path_string(in[i]));
+  }
+  const auto views = std::vector<std::string_view>(std::begin(strings), std::end(strings));
+
+  return excluded_n(views.data(), n, excluded);
+}
+
+template<typename P>
+const path_pattern_set& includexclude_pathlist<P>::exclude_patterns() const
+{
+  return exclude_patterns_;
+}
+
+template<typename P>
+std::unique_ptr<const compiled_pathlist<P>> includexclude_pathlist<P>::compile() const
+{
+  auto l = *this;
+  l.include_paths_.shrink_to_fit();
+  l.rebuild(exclude_strings());
+
+  return std::unique_ptr<const compiled_pathlist<P>>{ new compiled_pathlist<P>{ std::move(l) } };
 }
 
 template<typename P>
@@ -305,35 +762,28 @@ void includexclude_pathlist<P>::add_includepath(const path_type& p, bool recursi
     throw std::runtime_error{ "Include path must be absolute." };
   }
 
-  // Check if this is a sub path of a already included path
-  decltype(auto) p_str = p.has_stem() ? p.string() : decltype(p){ p }.remove_filename().string();
-  auto found = false;
-  for (const auto& i : include_paths_)
+  const auto& p_str = path_string(p);
+  const auto p_view = std::string_view{ p_str };
+  auto excludes = exclude_strings();
+
+  // Check if we have exclude path or sub paths of this new include path and remove them
+  if (recursive)
   {
-    if (i.string().string().find(old_root_str) == 0)
+    const auto size = excludes.size();
+    erase_subpaths(excludes, p_view, true);
+    if (excludes.size() != size)
     {
-      found = true;
-      break;
+      rebuild(excludes);
     }
   }
 
-  // If this is not a sub path of a already included path, add it
-  if (found)
+  // If this is not a sub path of an already included path, add it and drop the included sub paths of it
+  if (!included(p_view))
   {
-    include_paths_.push_back(p.has_stem() ? p : decltype(p){ p }.remove_filename());
-  }
-
-  // Check if we have exclude path or sub paths of this new include path and remove them
-  for (auto iter = std::cbegin(exclude_paths_); iter != std::cend(exclude_paths_);)
-  {
-    if (iter->string().find(p_str) == 0)
-    {
-      exclude_paths_.erase(iter++);
-    }
-    else
-    {
-      ++iter;
-    }
+    erase_subpaths(include_paths_, p_view, false);
+    erase_path(excludes, p_view);
+    include_paths_.push_back(p);
+    rebuild(excludes);
   }
 }
 
@@ -343,64 +793,537 @@ void includexclude_pathlist<P>::add_excludepath(const path_type& p)
   // Check for absolute path
   if (p.is_relative())
   {
-    throw std::runtime_error{ "Include path must be absolute." };
+    throw std::runtime_error{ "Exclude path must be absolute." };
   }
 
-  decltype(auto) my_p = p;
-  my_p.remove_filename();
+  // Only sub paths of included paths can be excluded, excluding below an excluded path has no effect
+  const auto& p_str = path_string(p);
+  const auto p_view = std::string_view{ p_str };
+  if (!included(p_view))
+  {
+    return;
+  }
 
-  // Check if we have exclude path or sub paths of this new include path and remove them
-  decltype(auto) p_str = my_p.string();
+  // Excluding an include path or a parent of one removes them, which changes the roots
+  if (std::any_of(std::begin(include_paths_), std::end(include_paths_), [p_view](const auto& i) { return is_subpath(p_view, path_string(i)); }))
+  {
+    auto excludes = exclude_strings();
+    erase_subpaths(excludes, p_view, true);
+    erase_subpaths(include_paths_, p_view, true);
+    excludes.emplace_back(p_view);
+    rebuild(excludes);
+    return;
+  }
+
+  // Check if we have exclude path or sub paths of this new exclude path and remove them
+  const auto s = split(p_view);
+  const auto suffix = p_view.substr(s.second);
   exclude_paths_.erase(
     std::remove_if(std::begin(exclude_paths_), std::end(exclude_paths_),
-    [&p_str](const auto& i) { return i.find(p_str) == 0; },
-    std::cend(exclude_paths_));
+    [&s, suffix](const rooted_path& i) { return i.root == s.first && is_subpath(suffix, i.suffix); }),
+    std::end(exclude_paths_));
+  trie_.clear_below(suffix, path_trie::mark::none, root_nodes_[s.first]);
+  index_.clear_below(suffix, path_trie::mark::none, s.first);
 
   // Add this exact path as exclude path
-  exclude_paths_.push_back(my_p);
+  exclude_paths_.push_back(rooted_path{ s.first, std::string{ suffix } });
+  trie_.set(suffix, path_trie::mark::exclude, root_nodes_[s.first]);
+  index_.set(suffix, path_trie::mark::exclude, s.first);
+}
+
+template<typename P>
+void includexclude_pathlist<P>::add_excludepattern(std::string_view pattern)
+{
+  exclude_patterns_.add(pattern);
+}
 
-  // Check if this is an include path or has include sub paths and remove them
-  include_paths_.erase(
-    std::remove_if(std::begin(include_paths_), std::end(include_paths_),
-    [&p_str](const auto& i) { return i.find(p_str) == 0; },
-    std::cend(include_paths_));
+template<typename P>
+template<typename InputIt>
+void includexclude_pathlist<P>::add_excludepatterns(InputIt first, InputIt last)
+{
+  exclude_patterns_.add(first, last);
+}
+
+template<typename P>
+template<typename IncludeIt, typename ExcludeIt>
+void includexclude_pathlist<P>::assign(IncludeIt include_first, IncludeIt include_last, ExcludeIt exclude_first, ExcludeIt exclude_last)
+{
+  const auto includes = path_includelist_type(include_first, include_last);
+  const auto excludes = path_includelist_type(exclude_first, exclude_last);
+  if (std::any_of(std::begin(includes), std::end(includes), [](const auto& i) { return i.is_relative(); }))
+  {
+    throw std::runtime_error{ "Include path must be absolute." };
+  }
+  if (std::any_of(std::begin(excludes), std::end(excludes), [](const auto& i) { return i.is_relative(); }))
+  {
+    throw std::runtime_error{ "Exclude path must be absolute." };
+  }
+
+  std::vector<std::string> strings[2];
+  for (const auto& i : includes)
+  {
+    strings[0].emplace_back(path_string(i));
+  }
+  for (const auto& i : excludes)
+  {
+    strings[1].emplace_back(path_string(i));
+  }
+
+  auto keys = std::string{};
+  auto paths = std::vector<keyed_path>{};
+  paths.reserve(includes.size() + excludes.size());
+  append_keys(strings[0], path_trie::mark::include, 0, keys, paths);
+  append_keys(strings[1], path_trie::mark::exclude, 0, keys, paths);
+  sort_keys(keys, paths);
+
+  // In key order all sub paths follow their parent, so the last kept include and exclude are the only candidates for a parent
+  const auto key = [&keys](const keyed_path* i) { return std::string_view{ keys }.substr(i->offset, i->size); };
+  const auto below = [&key](std::string_view k, const keyed_path* parent) { return parent != nullptr && k.substr(0, parent->size) == key(parent); };
+  auto kept = std::vector<const keyed_path*>{};
+  const keyed_path* include = nullptr;
+  const keyed_path* exclude = nullptr;
+  for (const auto& i : paths)
+  {
+    const auto k = key(&i);
+    include = below(k, include) ? include : nullptr;
+    exclude = below(k, exclude) ? exclude : nullptr;
+
+    if (i.m == path_trie::mark::include)
+    {
+      // Sub paths of included paths are redundant, sub paths of excluded paths removed
+      if (include == nullptr && exclude == nullptr)
+      {
+        kept.push_back(&i);
+        include = &i;
+      }
+    }
+    else if (include != nullptr && exclude == nullptr)
+    {
+      // Excluding an include path removes it
+      if (include->size == i.size && !kept.empty() && kept.back() == include)
+      {
+        kept.pop_back();
+      }
+      kept.push_back(&i);
+      exclude = &i;
+    }
+  }
+
+  include_paths_.clear();
+  auto kept_excludes = std::vector<std::string>{};
+  for (const auto i : kept)
+  {
+    if (i->m == path_trie::mark::include)
+    {
+      include_paths_.push_back(path_type{ *i->p });
+    }
+    else
+    {
+      kept_excludes.push_back(*i->p);
+    }
+  }
+  rebuild(kept_excludes);
 }
 
 template<typename P>
 void includexclude_pathlist<P>::sort()
 {
+  auto excludes = exclude_strings();
   std::sort(begin(), end());
-  std::sort(std::begin(exclude_paths_), std::end(exclude_paths_));
+  std::sort(std::begin(excludes), std::end(excludes));
+  rebuild(excludes);
 }
 
 template<typename P>
 void includexclude_pathlist<P>::reroot(const path_type& old_root, const path_type& new_root)
 {
-  reroot_container(include_paths_, old_root, new_root);
-  reroot_container(exclude_paths_, old_root, new_root);
+  const auto old_root_str = std::string{ path_string(old_root) };
+  const auto new_root_str = std::string{ path_string(new_root) };
+
+  // Whole include paths move if the old root is not strictly inside one of them and there is no exclude path without include path
+  const auto s = split(old_root_str);
+  const auto rest = path_components{ std::string_view{ old_root_str }.substr(s.second) };
+  auto fast = (s.first == 0 || std::begin(rest) == std::end(rest)) && unrooted_excludes_ == 0;
+
+  // The moved include paths are the marked nodes below the old root, they leave the root table
+  auto moved = std::vector<path_trie::node_id>{};
+  auto targets = std::vector<std::string>{};
+  const auto old_node = roots_.find(old_root_str);
+  if (fast && old_node != path_trie::npos)
+  {
+    moved = roots_.marked_subtree(old_node);
+    for (const auto n : moved)
+    {
+      targets.emplace_back(path_string(include_paths_[root_of_node_[n] - 1]));
+      roots_.set({}, path_trie::mark::none, n);
+    }
+  }
+  reroot_container(targets, old_root_str, new_root_str);
+
+  // The moved include paths must not nest with the others, as this changes the roots of exclude paths
+  for (auto i = std::begin(targets); fast && i != std::end(targets); ++i)
+  {
+    const auto n = roots_.find(*i);
+    fast = split(*i).first == 0 && (n == path_trie::npos || roots_.marked_subtree(n).empty());
+  }
+
+  if (!fast)
+  {
+    auto excludes = exclude_strings();
+    reroot_container(include_paths_, old_root_str, new_root_str);
+    reroot_container(excludes, old_root_str, new_root_str);
+    rebuild(excludes);
+    return;
+  }
+
+  // Update the root table only, the exclude paths refer to their roots by id. Sub trees first, so the nodes of the old paths are reused.
+  auto ids = std::vector<root_id>{};
+  for (const auto n : moved)
+  {
+    ids.push_back(root_of_node_[n]);
+  }
+  for (auto i = std::rbegin(moved); i != std::rend(moved); ++i)
+  {
+    roots_.prune(*i);
+  }
+  for (auto i = size_type{ 0 }; i < moved.size(); ++i)
+  {
+    const auto n = roots_.insert(targets[i]);
+    roots_.set({}, path_trie::mark::include, n);
+    root_of_node_.resize(roots_.size(), 0);
+    root_of_node_[n] = ids[i];
+    index_.set_root(ids[i], targets[i]);
+    include_paths_[ids[i] - 1] = path_type{ targets[i] };
+  }
 }
 
 template<typename P>
 void includexclude_pathlist<P>::clear()
 {
   include_paths_.clear();
-  exclude_paths_.clear();
+  rebuild({});
+  exclude_patterns_.clear();
+}
+
+template<typename P>
+void includexclude_pathlist<P>::append_keys(const std::vector<std::string>& container, path_trie::mark m, unsigned side, std::string& keys,
+  std::vector<keyed_path>& out)
+{
+  for (const auto& i : container)
+  {
+    const auto offset = keys.size();
+    path_prefix_index::append_key(i, keys);
+    out.push_back(keyed_path{ offset, keys.size() - offset, m, &i, side });
+  }
+}
+
+template<typename P>
+void includexclude_pathlist<P>::sort_keys(std::string_view keys, std::vector<keyed_path>& v)
+{
+  std::sort(std::begin(v), std::end(v), [keys](const keyed_path& a, const keyed_path& b)
+  {
+    const auto c = keys.substr(a.offset, a.size).compare(keys.substr(b.offset, b.size));
+    return c < 0 || (c == 0 && a.m < b.m);
+  });
+}
+
+template<typename P>
+template<typename F>
+includexclude_pathlist<P> includexclude_pathlist<P>::combine(const includexclude_pathlist& a, const includexclude_pathlist& b, F op)
+{
+  std::vector<std::string> strings[4];
+  for (const auto& i : a.include_paths_)
+  {
+    strings[0].emplace_back(path_string(i));
+  }
+  strings[1] = a.exclude_strings();
+  for (const auto& i : b.include_paths_)
+  {
+    strings[2].emplace_back(path_string(i));
+  }
+  strings[3] = b.exclude_strings();
+
+  auto keys = std::string{};
+  auto paths = std::vector<keyed_path>{};
+  paths.reserve(strings[0].size() + strings[1].size() + strings[2].size() + strings[3].size());
+  append_keys(strings[0], path_trie::mark::include, 0, keys, paths);
+  append_keys(strings[1], path_trie::mark::exclude, 0, keys, paths);
+  append_keys(strings[2], path_trie::mark::include, 1, keys, paths);
+  append_keys(strings[3], path_trie::mark::exclude, 1, keys, paths);
+  sort_keys(keys, paths);
+
+  // The marked parents of the current key in both operands and the result, the deepest on top
+  const auto key = [&keys](const keyed_path* i) { return std::string_view{ keys }.substr(i->offset, i->size); };
+  const auto below = [&key](std::string_view k, const keyed_path* parent) { return k.substr(0, parent->size) == key(parent); };
+  std::vector<const keyed_path*> parents[2];
+  auto result = std::vector<std::pair<const keyed_path*, bool>>{};
+  const auto included = [](const std::vector<const keyed_path*>& v) { return !v.empty() && v.back()->m == path_trie::mark::include; };
+
+  auto retval = includexclude_pathlist{};
+  auto excludes = std::vector<std::string>{};
+  for (auto iter = std::cbegin(paths); iter != std::cend(paths);)
+  {
+    const auto k = key(&*iter);
+    for (auto& i : parents)
+    {
+      while (!i.empty() && !below(k, i.back()))
+      {
+        i.pop_back();
+      }
+    }
+    while (!result.empty() && !below(k, result.back().first))
+    {
+      result.pop_back();
+    }
+
+    // All marks on this key, the exclude mark wins within one operand
+    const auto first = iter;
+    for (; iter != std::cend(paths) && key(&*iter) == k; ++iter)
+    {
+      auto& side = parents[iter->side];
+      if (side.empty() || side.back()->size != iter->size)
+      {
+        side.push_back(&*iter);
+      }
+      else
+      {
+        side.back() = &*iter;
+      }
+    }
+
+    // A mark is needed where the result changes
+    const auto in = op(included(parents[0]), included(parents[1]));
+    if (in != (!result.empty() && result.back().second))
+    {
+      result.emplace_back(&*first, in);
+      if (in)
+      {
+        retval.include_paths_.push_back(path_type{ *first->p });
+      }
+      else
+      {
+        excludes.push_back(*first->p);
+      }
+    }
+  }
+  retval.rebuild(excludes);
+
+  return retval;
 }
 
 template<typename P>
 template<typename C>
-void includexclude_pathlist<P>::reroot_container(C& container, const path_type& old_root, const path_type& new_root)
+void includexclude_pathlist<P>::reroot_container(C& container, std::string_view old_root, std::string_view new_root)
 {
   for (auto& i : container)
   {
-    decltype(auto) i_str = i.string();
-    decltype(auto) old_root_str = old_root.string();
+    const auto i_str = std::string{ path_string(i) };
+    if (is_subpath(old_root, i_str))
+    {
+      // Skip the components of the old root, the remainder is appended to the new root
+      const auto components = path_components{ i_str };
+      auto iter = std::begin(components);
+      auto offset = std::size_t{ 0 };
+      for (const auto& c : path_components{ old_root })
+      {
+        static_cast<void>(c);
+        offset = iter.end_offset(i_str);
+        ++iter;
+      }
+      const auto rest = std::string_view{ i_str }.substr(offset);
+      i = typename C::value_type{ std::string{ new_root } + std::string{ rest } };
+    }
+  }
+}
+
+template<typename P>
+template<typename C>
+void includexclude_pathlist<P>::erase_subpaths(C& container, std::string_view p, bool self)
+{
+  container.erase(
+    std::remove_if(std::begin(container), std::end(container),
+    [p, self](const auto& i)
+    {
+      const auto& i_str = path_string(i);
+      const auto i_view = std::string_view{ i_str };
+      return is_subpath(p, i_view) && (self || !is_subpath(i_view, p));
+    }),
+    std::end(container));
+}
+
+template<typename P>
+template<typename C>
+void includexclude_pathlist<P>::erase_path(C& container, std::string_view p)
+{
+  container.erase(
+    std::remove_if(std::begin(container), std::end(container),
+    [p](const auto& i)
+    {
+      const auto& i_str = path_string(i);
+      const auto i_view = std::string_view{ i_str };
+      return is_subpath(p, i_view) && is_subpath(i_view, p);
+    }),
+    std::end(container));
+}
+
+template<typename P>
+std::pair<typename includexclude_pathlist<P>::root_id, typename includexclude_pathlist<P>::size_type> includexclude_pathlist<P>::split(
+  std::string_view p) const noexcept
+{
+  // An include path "/" marks the root node itself
+  auto retval = std::pair<root_id, size_type>{ 0, 0 };
+  if (roots_.node_mark(path_trie::root) == path_trie::mark::include)
+  {
+    retval.first = root_of_node_[path_trie::root];
+  }
 
-    if (i_str.string().find(old_root_str) == 0)
+  auto n = path_trie::root;
+  const auto components = path_components{ p };
+  for (auto iter = std::begin(components); iter != std::end(components); ++iter)
+  {
+    n = roots_.child(n, *iter);
+    if (n == path_trie::npos)
+    {
+      break;
+    }
+    if (roots_.node_mark(n) == path_trie::mark::include)
     {
-      i = path_type{ i_str.replace(0, old_root_str.size(), new_root.string()) };
+      retval = { root_of_node_[n], iter.end_offset(p) };
     }
   }
+
+  return retval;
+}
+
+template<typename P>
+bool includexclude_pathlist<P>::included(std::string_view p) const noexcept
+{
+  const auto s = split(p);
+  return s.first != 0 && trie_.lookup(p.substr(s.second), root_nodes_[s.first]) != path_trie::mark::exclude;
+}
+
+template<typename P>
+std::string includexclude_pathlist<P>::full_path(const rooted_path& e) const
+{
+  return e.root == 0 ? e.suffix : std::string{ path_string(include_paths_[e.root - 1]) } + e.suffix;
+}
+
+template<typename P>
+std::vector<std::string> includexclude_pathlist<P>::exclude_strings() const
+{
+  auto retval = std::vector<std::string>{};
+  retval.reserve(exclude_paths_.size());
+  for (const auto& i : exclude_paths_)
+  {
+    retval.push_back(full_path(i));
+  }
+
+  return retval;
+}
+
+template<typename P>
+void includexclude_pathlist<P>::rebuild(const std::vector<std::string>& excludes)
+{
+  // Root table, root 0 stands for no include path
+  roots_.clear();
+  root_of_node_.assign(1, 0);
+  for (auto i = size_type{ 0 }; i < include_paths_.size(); ++i)
+  {
+    const auto& i_str = path_string(include_paths_[i]);
+    const auto n = roots_.insert(i_str);
+    roots_.set({}, path_trie::mark::include, n);
+    root_of_node_.resize(roots_.size(), 0);
+    root_of_node_[n] = static_cast<root_id>(i + 1);
+  }
+
+  trie_.clear();
+  root_nodes_.clear();
+  for (auto i = size_type{ 0 }; i <= include_paths_.size(); ++i)
+  {
+    root_nodes_.push_back(trie_.insert(std::to_string(i)));
+  }
+
+  // Exclude paths relative to their deepest include path
+  exclude_paths_.clear();
+  exclude_paths_.reserve(excludes.size());
+  unrooted_excludes_ = 0;
+  for (const auto& i : excludes)
+  {
+    const auto s = split(i);
+    exclude_paths_.push_back(rooted_path{ s.first, i.substr(s.second) });
+    unrooted_excludes_ += s.first == 0 ? 1 : 0;
+  }
+
+  auto marks = std::vector<path_prefix_index::marked_path>{};
+  marks.reserve(exclude_paths_.size());
+  for (const auto& i : exclude_paths_)
+  {
+    trie_.set(i.suffix, path_trie::mark::exclude, root_nodes_[i.root]);
+    marks.push_back(path_prefix_index::marked_path{ i.suffix, path_trie::mark::exclude, i.root });
+  }
+  index_.assign(marks);
+
+  auto strings = std::vector<std::string>{};
+  strings.reserve(include_paths_.size());
+  for (const auto& i : include_paths_)
+  {
+    strings.emplace_back(path_string(i));
+  }
+  index_.assign_roots(std::vector<std::string_view>(std::begin(strings), std::end(strings)));
+}
+
+template<typename P>
+bool includexclude_pathlist<P>::has_patterns(const path_pattern_set& a, const path_pattern_set& b)
+{
+  const auto& a_patterns = a.patterns();
+  return std::all_of(std::begin(b.patterns()), std::end(b.patterns()),
+    [&a_patterns](const auto& i) { return std::find(std::begin(a_patterns), std::end(a_patterns), i) != std::end(a_patterns); });
+}
+
+template<typename P>
+includexclude_pathlist<P> set_union(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b)
+{
+  using pathlist = includexclude_pathlist<P>;
+  const auto& patterns = b.include_paths_.empty() ? a.exclude_patterns_ : b.exclude_patterns_;
+  if (!a.include_paths_.empty() && !b.include_paths_.empty()
+    && !(pathlist::has_patterns(a.exclude_patterns_, b.exclude_patterns_) && pathlist::has_patterns(b.exclude_patterns_, a.exclude_patterns_)))
+  {
+    throw std::runtime_error{ "Union of path lists with different exclude patterns can't be represented." };
+  }
+
+  auto retval = pathlist::combine(a, b, [](bool in_a, bool in_b) { return in_a || in_b; });
+  retval.exclude_patterns_ = patterns;
+
+  return retval;
+}
+
+template<typename P>
+includexclude_pathlist<P> set_intersection(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b)
+{
+  auto retval = includexclude_pathlist<P>::combine(a, b, [](bool in_a, bool in_b) { return in_a && in_b; });
+
+  auto patterns = std::vector<std::string_view>(std::begin(a.exclude_patterns_.patterns()), std::end(a.exclude_patterns_.patterns()));
+  patterns.insert(std::end(patterns), std::begin(b.exclude_patterns_.patterns()), std::end(b.exclude_patterns_.patterns()));
+  std::sort(std::begin(patterns), std::end(patterns));
+  patterns.erase(std::unique(std::begin(patterns), std::end(patterns)), std::end(patterns));
+  retval.exclude_patterns_.add(std::begin(patterns), std::end(patterns));
+
+  return retval;
+}
+
+template<typename P>
+includexclude_pathlist<P> set_difference(const includexclude_pathlist<P>& a, const includexclude_pathlist<P>& b)
+{
+  using pathlist = includexclude_pathlist<P>;
+  if (!b.include_paths_.empty() && !pathlist::has_patterns(a.exclude_patterns_, b.exclude_patterns_))
+  {
+    throw std::runtime_error{ "Difference with a path list excluding patterns the first one does not can't be represented." };
+  }
+
+  auto retval = pathlist::combine(a, b, [](bool in_a, bool in_b) { return in_a && !in_b; });
+  retval.exclude_patterns_ = a.exclude_patterns_;
+
+  return retval;
 }
 
 } // namespace arude
@@ -0,0 +1,168 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_IO_GOVERNOR_HPP
+#define INC_ARUDE_IO_GOVERNOR_HPP
+
+#include "libarude/noncopyable.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__linux__)
+#define ARUDE_IO_GOVERNOR_IOPRIO
+#endif
+
+
+namespace arude
+{
+
+///
+/// Limits the I/O of a walk, so it does not hurt other work on the same disks.
+///
+/// Directories listed, entries read and bytes read are limited per second by token buckets, which hold the budget of a short burst. A charge
+/// beyond the budget runs into debt, which is paid by waiting, so threads charging concurrently share the rates.
+/// With a latency target, the measured latency of syscalls is smoothed, and while it is above the target every directory waits for a backoff
+/// delay, doubled each time the latency is still too high and decreased slowly once below.
+/// Optionally the walking threads run in the idle I/O scheduling class on Linux, so they only get disk time no one else wants.
+/// This class is thread safe.
+///
+class io_governor final : noncopyable
+{
+// Typedefs
+public:
+  using clock = std::chrono::steady_clock; ///< Clock measuring rates and latencies
+
+  ///
+  /// Limits of a walk, 0 for no limit.
+  ///
+  struct limits
+  {
+    double dirs_per_second = 0; ///< Directories listed per second
+    double entries_per_second = 0; ///< Directory entries read per second
+    double bytes_per_second = 0; ///< Bytes read per second
+    std::chrono::milliseconds burst{ 100 }; ///< Time whose budget is saved while idle
+    std::chrono::microseconds latency_target{ 0 }; ///< Syscall latency above which the walk backs off
+    bool idle_priority = false; ///< Runs the walking threads in the idle I/O scheduling class
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param l Limits
+  ///
+  explicit io_governor(const limits& l);
+
+// Accessors
+public:
+  ///
+  /// Returns the limits.
+  /// \return Limits
+  ///
+  const limits& get_limits() const noexcept;
+
+  ///
+  /// Returns the smoothed syscall latency measured.
+  /// \return Latency
+  ///
+  std::chrono::nanoseconds latency() const;
+
+  ///
+  /// Returns the delay added to each directory as the latency is too high.
+  /// \return Backoff delay
+  ///
+  std::chrono::nanoseconds backoff() const;
+
+// Operations
+public:
+  ///
+  /// Charges I/O done and returns the time to wait for it.
+  ///
+  /// \param dirs Directories listed
+  /// \param entries Directory entries read
+  /// \param bytes Bytes read
+  /// \return Time the caller is to wait before doing more I/O
+  ///
+  std::chrono::nanoseconds charge(std::uint64_t dirs, std::uint64_t entries, std::uint64_t bytes);
+
+  ///
+  /// Adds the measured latency of a syscall, adapting the backoff delay.
+  /// \param latency Time the syscall took
+  ///
+  void measured(std::chrono::nanoseconds latency);
+
+  ///
+  /// Applies the I/O priority to the calling thread, NOOP unless the idle priority is set.
+  /// \return False if the priority can't be set, e.g. on other platforms than Linux
+  ///
+  bool enter_thread() const;
+
+// Types
+private:
+  ///
+  /// Token bucket of one rate.
+  ///
+  struct bucket
+  {
+    ///
+    /// Ctor, the bucket is full.
+    ///
+    /// \param r Tokens added per second, 0 for no limit
+    /// \param burst Time whose tokens are held
+    ///
+    bucket(double r, std::chrono::milliseconds burst);
+
+    double rate; ///< Tokens added per second, 0 for no limit
+    double capacity; ///< Tokens held at most
+    double tokens; ///< Tokens available, negative for debt
+
+    ///
+    /// Takes tokens.
+    ///
+    /// \param n Number of tokens
+    /// \param elapsed Seconds since the last call
+    /// \return Seconds to wait until the debt is paid
+    ///
+    double take(double n, double elapsed);
+  };
+
+// Variables
+private:
+  const limits limits_; ///< Limits
+  mutable std::mutex mtx_; ///< Serializes the charges
+  clock::time_point last_; ///< Time of the last charge
+  bucket dirs_; ///< Directories listed
+  bucket entries_; ///< Directory entries read
+  bucket bytes_; ///< Bytes read
+  std::chrono::nanoseconds latency_{ 0 }; ///< Smoothed latency
+  std::chrono::nanoseconds backoff_{ 0 }; ///< Backoff delay per directory
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_IO_GOVERNOR_HPP
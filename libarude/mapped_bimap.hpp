@@ -0,0 +1,422 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_MAPPED_BIMAP_HPP
+#define INC_ARUDE_MAPPED_BIMAP_HPP
+
+
+#include "libarude/flat_bimap.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Thrown by the mapped_bimap when a file is not a valid bimap file for the requested types.
+///
+/// error_info: errinfo_file_name
+///
+struct mapped_bimap_format_exception : virtual exception {};
+
+///
+/// Thrown by the mapped_bimap_builder when a file could not be written.
+///
+/// error_info: errinfo_file_name
+///
+struct mapped_bimap_write_exception : virtual exception {};
+
+namespace mapped_bimap_format
+{
+
+///
+/// File header of a mapped bimap.
+///
+/// The header is followed by four arrays of count + 1 elements, each aligned to 64 bytes: the left keys and the right keys in Eytzinger order,
+/// and the position of the counterpart for each left and each right key (uint64). Everything is stored in native byte order, which is checked
+/// through the byte order marker.
+///
+struct header
+{
+  char magic[8]; ///< File magic "ARUDEBIM"
+  std::uint32_t version; ///< Format version
+  std::uint32_t byte_order; ///< Byte order marker, 0x01020304 in native order
+  std::uint32_t left_size; ///< Size of the left type
+  std::uint32_t right_size; ///< Size of the right type
+  std::uint64_t count; ///< Number of mappings
+  std::uint64_t left_offset; ///< File offset of the left keys
+  std::uint64_t right_offset; ///< File offset of the right keys
+  std::uint64_t l2r_offset; ///< File offset of the left to right positions
+  std::uint64_t r2l_offset; ///< File offset of the right to left positions
+};
+
+constexpr char magic[8] = { 'A', 'R', 'U', 'D', 'E', 'B', 'I', 'M' }; ///< File magic
+constexpr std::uint32_t version = 1; ///< Current format version
+constexpr std::uint32_t byte_order = 0x01020304; ///< Byte order marker
+constexpr std::uint64_t alignment = 64; ///< Alignment of the arrays
+
+///
+/// Rounds an offset up to the array alignment.
+/// \param offset File offset
+/// \return Aligned offset
+///
+constexpr std::uint64_t align(std::uint64_t offset)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace mapped_bimap_format
+
+///
+/// Writes a bimap to a file which can be opened by a mapped_bimap.
+///
+/// Both types must be trivially copyable and must not contain pointers, they are written as they are in memory.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+///
+template<typename LT, typename RT>
+class mapped_bimap_builder final
+{
+  static_assert(std::is_trivially_copyable<LT>::value && std::is_trivially_copyable<RT>::value, "mapped_bimap types must be trivially copyable");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+
+// Modifiers
+public:
+  ///
+  /// Adds a mapping. Uniqueness is checked when writing.
+  /// \param lv Left value
+  /// \param rv Right value
+  ///
+  void add(const left_type& lv, const right_type& rv)
+  {
+    m_mappings.emplace_back(lv, rv);
+  }
+
+// Operations
+public:
+  ///
+  /// Writes all added mappings to a file.
+  /// Throws nonuniquemapping_exception if the mappings are not unique.
+  ///
+  /// \param p Path of the file to write, replaced if it exists
+  ///
+  void write(const boost::filesystem::path& p) const
+  {
+    write(p, flat_bimap<left_type, right_type>(std::begin(m_mappings), std::end(m_mappings)));
+  }
+
+  ///
+  /// Writes a flat bimap to a file.
+  /// The file is written aside and renamed over \a p, so a crash never leaves a torn file and processes having mapped the former file keep
+  /// reading it.
+  ///
+  /// \param p Path of the file to write, replaced if it exists
+  /// \param b Bimap to write
+  ///
+  static void write(const boost::filesystem::path& p, const flat_bimap<left_type, right_type>& b)
+  {
+    namespace fmt = mapped_bimap_format;
+
+    const auto n = static_cast<std::uint64_t>(b.size()) + 1;
+    auto h = fmt::header{};
+    std::memcpy(h.magic, fmt::magic, sizeof(h.magic));
+    h.version = fmt::version;
+    h.byte_order = fmt::byte_order;
+    h.left_size = sizeof(left_type);
+    h.right_size = sizeof(right_type);
+    h.count = b.size();
+    h.left_offset = fmt::align(sizeof(h));
+    h.right_offset = fmt::align(h.left_offset + n * sizeof(left_type));
+    h.l2r_offset = fmt::align(h.right_offset + n * sizeof(right_type));
+    h.r2l_offset = fmt::align(h.l2r_offset + n * sizeof(std::uint64_t));
+
+    auto tmp = p;
+    tmp += ".tmp";
+    const auto fail = [&p, &tmp] {
+      auto ec = boost::system::error_code{};
+      boost::filesystem::remove(tmp, ec);
+      BOOST_THROW_EXCEPTION(mapped_bimap_write_exception{} << boost::errinfo_file_name(p.string()));
+    };
+
+    boost::filesystem::ofstream os{ tmp, std::ios::binary | std::ios::trunc };
+    auto pos = std::uint64_t{ 0 };
+    const auto put = [&os, &pos](std::uint64_t offset, const void* data, std::uint64_t size) {
+      static const char padding[fmt::alignment] = {};
+      os.write(padding, static_cast<std::streamsize>(offset - pos));
+      os.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+      pos = offset + size;
+    };
+
+    put(0, &h, sizeof(h));
+    if (!b.empty())
+    {
+      const auto l2r = std::vector<std::uint64_t>(std::begin(b.m_l2r), std::end(b.m_l2r));
+      const auto r2l = std::vector<std::uint64_t>(std::begin(b.m_r2l), std::end(b.m_r2l));
+      put(h.left_offset, b.m_left.data(), n * sizeof(left_type));
+      put(h.right_offset, b.m_right.data(), n * sizeof(right_type));
+      put(h.l2r_offset, l2r.data(), n * sizeof(std::uint64_t));
+      put(h.r2l_offset, r2l.data(), n * sizeof(std::uint64_t));
+    }
+
+    os.close();
+    if (!os)
+    {
+      fail();
+    }
+
+    auto ec = boost::system::error_code{};
+    boost::filesystem::rename(tmp, p, ec);
+    if (ec)
+    {
+      fail();
+    }
+  }
+
+// Variables
+private:
+  std::vector<std::pair<left_type, right_type>> m_mappings; ///< Mappings to write
+};
+
+///
+/// Read only bimap answering lookups directly from a memory mapped file written by the mapped_bimap_builder.
+///
+/// Opening maps the file without reading or converting anything, pages are loaded on first access and shared with all other processes
+/// mapping the same file. The file must not be modified in place while mapped; the builder replaces it by a new file instead.
+/// The header and the array bounds are validated when opening, the positions of the counterparts when looked up, so a corrupt file throws a
+/// mapped_bimap_format_exception. The order of the keys is trusted, a corrupt one only makes lookups miss.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+///
+template<typename LT, typename RT>
+class mapped_bimap final
+{
+  static_assert(std::is_trivially_copyable<LT>::value && std::is_trivially_copyable<RT>::value, "mapped_bimap types must be trivially copyable");
+  static_assert(!std::is_same<LT, RT>::value, "mapped_bimap can't map between equal left and right type");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// Maps the file and validates its header.
+  ///
+  /// \param p Path of a file written by the mapped_bimap_builder
+  ///
+  explicit mapped_bimap(const boost::filesystem::path& p)
+    : m_name{ p.string() }
+    , m_file{ p.string().c_str(), boost::interprocess::read_only }
+    , m_region{ m_file, boost::interprocess::read_only }
+  {
+    namespace fmt = mapped_bimap_format;
+
+    const auto base = static_cast<const char*>(m_region.get_address());
+    const auto size = static_cast<std::uint64_t>(m_region.get_size());
+    const auto fail = [&p] { BOOST_THROW_EXCEPTION(mapped_bimap_format_exception{} << boost::errinfo_file_name(p.string())); };
+
+    if (size < sizeof(fmt::header))
+    {
+      fail();
+    }
+
+    auto h = fmt::header{};
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, fmt::magic, sizeof(h.magic)) != 0 || h.version != fmt::version || h.byte_order != fmt::byte_order
+      || h.left_size != sizeof(left_type) || h.right_size != sizeof(right_type))
+    {
+      fail();
+    }
+
+    // Each mapping takes at least a left key, a larger count would wrap below
+    if (h.count >= size / sizeof(left_type))
+    {
+      fail();
+    }
+
+    m_count = static_cast<size_type>(h.count);
+    if (m_count == 0)
+    {
+      return;
+    }
+
+    const auto n = h.count + 1;
+    const auto inside = [size, n](std::uint64_t offset, std::uint64_t element_size) {
+      return offset % fmt::alignment == 0 && offset <= size && n <= (size - offset) / element_size;
+    };
+    if (!inside(h.left_offset, sizeof(left_type)) || !inside(h.right_offset, sizeof(right_type)) || !inside(h.l2r_offset, sizeof(std::uint64_t))
+      || !inside(h.r2l_offset, sizeof(std::uint64_t)))
+    {
+      fail();
+    }
+
+    m_left = reinterpret_cast<const left_type*>(base + h.left_offset);
+    m_right = reinterpret_cast<const right_type*>(base + h.right_offset);
+    m_l2r = reinterpret_cast<const std::uint64_t*>(base + h.l2r_offset);
+    m_r2l = reinterpret_cast<const std::uint64_t*>(base + h.r2l_offset);
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  const right_type& map(const left_type& v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  const left_type& map(const right_type& v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Looks up the second type value of a first type value. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Pointer to the second type value or nullptr if not mapped
+  ///
+  const right_type* find(const left_type& v) const
+  {
+    const auto k = eytzinger::lower_bound(m_left, m_count, v, std::less<left_type>{});
+    return k == 0 || std::less<left_type>{}(v, m_left[k]) ? nullptr : &m_right[position(m_l2r[k])];
+  }
+
+  ///
+  /// Looks up the first type value of a second type value. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return Pointer to the first type value or nullptr if not mapped
+  ///
+  const left_type* find(const right_type& v) const
+  {
+    const auto k = eytzinger::lower_bound(m_right, m_count, v, std::less<right_type>{});
+    return k == 0 || std::less<right_type>{}(v, m_right[k]) ? nullptr : &m_left[position(m_r2l[k])];
+  }
+
+  ///
+  /// Map first to second type. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Second type value or empty if not mapped
+  ///
+  std::optional<right_type> try_map(const left_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<right_type>{} : std::optional<right_type>{ *p };
+  }
+
+  ///
+  /// Map second to first type. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return First type value or empty if not mapped
+  ///
+  std::optional<left_type> try_map(const right_type& v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<left_type>{} : std::optional<left_type>{ *p };
+  }
+
+  ///
+  /// Returns the size of the bimap.
+  /// \return Size
+  ///
+  size_type size() const
+  {
+    return m_count;
+  }
+
+// Implementation
+private:
+  ///
+  /// Validates the position of a counterpart read from the file.
+  /// \param k Position in Eytzinger order
+  /// \return Position
+  ///
+  size_type position(std::uint64_t k) const
+  {
+    if (k == 0 || k > m_count)
+    {
+      BOOST_THROW_EXCEPTION(mapped_bimap_format_exception{} << boost::errinfo_file_name(m_name));
+    }
+
+    return static_cast<size_type>(k);
+  }
+
+// Variables
+private:
+  std::string m_name; ///< Path of the mapped file
+  boost::interprocess::file_mapping m_file; ///< Mapped file
+  boost::interprocess::mapped_region m_region; ///< Mapped view of the whole file
+  size_type m_count = 0; ///< Number of mappings
+  const left_type* m_left = nullptr; ///< Left keys in Eytzinger order
+  const right_type* m_right = nullptr; ///< Right keys in Eytzinger order
+  const std::uint64_t* m_l2r = nullptr; ///< Position of the right key for each left key
+  const std::uint64_t* m_r2l = nullptr; ///< Position of the left key for each right key
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_MAPPED_BIMAP_HPP
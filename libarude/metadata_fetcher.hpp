@@ -0,0 +1,175 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_METADATA_FETCHER_HPP
+#define INC_ARUDE_METADATA_FETCHER_HPP
+
+#include "libarude/file_metadata.hpp"
+#include "libarude/noncopyable.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#define ARUDE_METADATA_FETCHER_IO_URING
+#endif
+
+
+namespace arude
+{
+
+///
+/// Reads the metadata of many files at once, keeping many requests in flight.
+///
+/// On Linux statx requests are submitted in batches through an io_uring of the given queue depth. Where io_uring or its statx operation is
+/// not available, e.g. on older kernels or if blocked by a seccomp filter, and on other platforms, a pool of threads reads the metadata
+/// synchronously. The pool is only started when needed, without pool threads the calling thread reads the metadata itself.
+/// Symbolic links are not followed. An instance must not be used by several threads at once.
+///
+/// Example:
+/// arude::metadata_fetcher fetcher;
+/// std::vector<arude::file_metadata> md(paths.size());
+/// fetcher.fetch(paths.data(), paths.size(), md.data());
+///
+class metadata_fetcher final : noncopyable
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+
+  ///
+  /// Way the metadata is read.
+  ///
+  enum class backend
+  {
+    automatic, ///< io_uring if available, else the thread pool
+    thread_pool ///< Always the thread pool
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  /// \param queue_depth Number of requests in flight on the io_uring
+  /// \param threads Number of threads of the pool, 0 to read on the calling thread
+  /// \param b Way the metadata is read
+  ///
+  explicit metadata_fetcher(size_type queue_depth = 64, size_type threads = 8, backend b = backend::automatic);
+
+  ///
+  /// Dtor.
+  ///
+  ~metadata_fetcher();
+
+// Accessors
+public:
+  ///
+  /// Says if the metadata is read through an io_uring.
+  /// \return True if io_uring is used
+  ///
+  bool uses_io_uring() const noexcept;
+
+// Operations
+public:
+  ///
+  /// Reads the metadata of files.
+  ///
+  /// \param paths Paths of the files
+  /// \param n Number of paths
+  /// \param out Receives the metadata of each path
+  ///
+  void fetch(const std::string* paths, size_type n, file_metadata* out);
+
+// Implementation
+private:
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+  struct ring;
+
+  ///
+  /// Reads the metadata through the io_uring.
+  ///
+  /// \param paths Paths of the files
+  /// \param n Number of paths
+  /// \param out Receives the metadata of each path
+  /// \return False if the io_uring does not support statx
+  ///
+  bool fetch_ring(const std::string* paths, size_type n, file_metadata* out);
+#endif
+
+  ///
+  /// Reads the metadata with the thread pool.
+  ///
+  /// \param paths Paths of the files
+  /// \param n Number of paths
+  /// \param out Receives the metadata of each path
+  ///
+  void fetch_pool(const std::string* paths, size_type n, file_metadata* out);
+
+  ///
+  /// Reads the metadata of the files of the current batch until all are taken, run on each pool thread.
+  ///
+  void work();
+
+  ///
+  /// Reads the metadata of one file synchronously.
+  ///
+  /// \param path Path of the file
+  /// \param out Receives the metadata
+  ///
+  static void read(const std::string& path, file_metadata& out);
+
+// Variables
+private:
+  size_type queue_depth_; ///< Number of requests in flight on the io_uring
+  size_type thread_count_; ///< Number of threads of the pool
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+  std::unique_ptr<ring> ring_; ///< io_uring, empty if not available
+#endif
+  std::vector<std::thread> threads_; ///< Pool threads, started on first use
+  std::mutex mtx_; ///< Serializes access to the batch
+  std::condition_variable work_condition_; ///< Signals a new batch or the shutdown to the pool
+  std::condition_variable done_condition_; ///< Signals the end of a batch
+  const std::string* paths_ = nullptr; ///< Paths of the current batch
+  file_metadata* out_ = nullptr; ///< Metadata of the current batch
+  size_type size_ = 0; ///< Size of the current batch
+  std::atomic<size_type> next_{ 0 }; ///< Position of the next path to take
+  size_type done_ = 0; ///< Number of paths read of the current batch
+  size_type active_ = 0; ///< Number of pool threads working on the current batch
+  std::uint64_t generation_ = 0; ///< Number of the current batch
+  bool shutdown_ = false; ///< Ends the pool threads
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_METADATA_FETCHER_HPP
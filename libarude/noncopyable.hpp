@@ -24,6 +24,10 @@
 /// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
 ///
 
+#ifndef INC_ARUDE_NONCOPYABLE_HPP
+#define INC_ARUDE_NONCOPYABLE_HPP
+
+
 namespace arude
 {
 namespace noncopyable_  // Protection from unintended ADL
@@ -39,6 +43,11 @@ class noncopyable
 {
 // Structors
 protected:
+  ///
+  /// Ctor.
+  ///
+  noncopyable() = default;
+
   ///
   /// Copy dtor.
   /// Deleted to not allow copy construction.
@@ -56,4 +65,6 @@ protected:
 
 using noncopyable = noncopyable_::noncopyable;
 
-} // namespace arude
\ No newline at end of file
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_NONCOPYABLE_HPP
\ No newline at end of file
@@ -0,0 +1,261 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_PATH_COMPONENTS_HPP
+#define INC_ARUDE_PATH_COMPONENTS_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace arude
+{
+
+///
+/// Says if a character is a path separator on this platform.
+/// \param c Character
+/// \return True if separator
+///
+constexpr bool is_path_separator(char c)
+{
+#if defined(_WIN32)
+  return c == '/' || c == '\\';
+#else
+  return c == '/';
+#endif
+}
+
+///
+/// Range over the components of a path string, without allocation.
+///
+/// Separators, empty components and "." are skipped, so "/foo//bar/./" yields "foo" and "bar". The root of an absolute path yields nothing.
+/// No further normalization is done, ".." is a regular component.
+///
+class path_components final
+{
+// Typedefs
+public:
+  ///
+  /// Forward iterator over the components.
+  ///
+  class iterator final
+  {
+  // Typedefs
+  public:
+    using iterator_category = std::forward_iterator_tag; ///< Iterator category
+    using value_type = std::string_view; ///< Component type
+    using difference_type = std::ptrdiff_t; ///< Difference type
+    using pointer = const std::string_view*; ///< Pointer type
+    using reference = const std::string_view&; ///< Reference type
+
+  // Structors
+  public:
+    ///
+    /// Ctor.
+    /// \param s Remaining path string, the iterator is at its end if empty
+    ///
+    explicit iterator(std::string_view s = {})
+      : rest_{ s }
+    {
+      advance();
+    }
+
+  // Accessors
+  public:
+    reference operator*() const
+    {
+      return current_;
+    }
+
+    pointer operator->() const
+    {
+      return &current_;
+    }
+
+    ///
+    /// Returns the offset of the end of the current component in the original string, which is the length of the path up to this component.
+    /// \param s Original path string
+    /// \return Offset
+    ///
+    std::size_t end_offset(std::string_view s) const
+    {
+      return static_cast<std::size_t>(current_.data() + current_.size() - s.data());
+    }
+
+    bool operator==(const iterator& rhs) const
+    {
+      return current_.data() == rhs.current_.data() && current_.size() == rhs.current_.size();
+    }
+
+    bool operator!=(const iterator& rhs) const
+    {
+      return !(*this == rhs);
+    }
+
+  // Modifiers
+  public:
+    iterator& operator++()
+    {
+      advance();
+      return *this;
+    }
+
+    iterator operator++(int)
+    {
+      auto retval = *this;
+      advance();
+      return retval;
+    }
+
+  // Implementation
+  private:
+    ///
+    /// Moves to the next component.
+    ///
+    void advance()
+    {
+      for (;;)
+      {
+        auto i = std::size_t{ 0 };
+        while (i < rest_.size() && is_path_separator(rest_[i]))
+        {
+          ++i;
+        }
+        auto j = i;
+        while (j < rest_.size() && !is_path_separator(rest_[j]))
+        {
+          ++j;
+        }
+
+        current_ = rest_.substr(i, j - i);
+        rest_.remove_prefix(j);
+        if (current_.empty())
+        {
+          current_ = {};
+          return;
+        }
+        if (current_ != ".")
+        {
+          return;
+        }
+      }
+    }
+
+  // Variables
+  private:
+    std::string_view rest_; ///< Not yet visited part of the path
+    std::string_view current_; ///< Current component, default constructed at the end
+  };
+
+  using const_iterator = iterator; ///< Const iterator type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param s Path string
+  ///
+  explicit path_components(std::string_view s)
+    : s_{ s }
+  {
+  }
+
+// Accessors
+public:
+  iterator begin() const
+  {
+    return iterator{ s_ };
+  }
+
+  iterator end() const
+  {
+    return iterator{};
+  }
+
+// Variables
+private:
+  std::string_view s_; ///< Path string
+};
+
+///
+/// Says if a path is the same as or a sub path of another one, comparing components.
+///
+/// \param parent Parent path string
+/// \param p Path string to test
+/// \return True if \a p is \a parent or below it
+///
+inline bool is_subpath(std::string_view parent, std::string_view p)
+{
+  const auto pc = path_components{ p };
+  auto iter = std::begin(pc);
+  for (const auto& i : path_components{ parent })
+  {
+    if (iter == std::end(pc) || *iter != i)
+    {
+      return false;
+    }
+    ++iter;
+  }
+
+  return true;
+}
+
+///
+/// Returns the string of a path without allocating where the native format is a narrow string.
+///
+/// \tparam P Path type
+/// \param p Path
+/// \return std::string_view of the native string, or an owning std::string converted by string()
+///
+template<typename P>
+auto path_string(const P& p)
+{
+  if constexpr (std::is_convertible<decltype(p.native()), std::string_view>::value)
+  {
+    return std::string_view{ p.native() };
+  }
+  else
+  {
+    return p.string();
+  }
+}
+
+///
+/// Returns a path string itself, used where paths are held as plain strings.
+/// \param p Path string
+/// \return std::string_view of \a p
+///
+inline std::string_view path_string(const std::string& p)
+{
+  return p;
+}
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_PATH_COMPONENTS_HPP
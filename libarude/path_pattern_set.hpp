@@ -0,0 +1,170 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_PATH_PATTERN_SET_HPP
+#define INC_ARUDE_PATH_PATTERN_SET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Set of glob patterns over paths, compiled together into one automaton.
+///
+/// Pattern syntax follows gitignore:
+/// - "*" matches any characters within a component, "?" one character, "[a-z]" and "[!a-z]" character classes, "\" escapes the next character
+/// - "**" as a whole component matches any number of components, e.g. "/data/**/cache"
+/// - A pattern starting with a separator is anchored at the root, otherwise it matches at any depth, so "*.tmp" equals "**/*.tmp"
+/// A path matches if the path itself or one of its parents matches a pattern, so "**/node_modules" covers everything below such a directory.
+///
+/// Compilation is done in two levels. All distinct component globs form one DFA over characters, running it over a component yields the class of
+/// the component, which is the set of component globs matching it. All patterns form one DFA over component classes. Matching a path is thus a
+/// single pass over its characters with one table lookup each, whatever the number of patterns, and does not allocate.
+/// This class is as thread safe as a std::vector.
+///
+class path_pattern_set final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+  using pattern_list_type = std::vector<std::string>; ///< Type used to hold the patterns
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  path_pattern_set();
+
+// Accessors
+public:
+  ///
+  /// Says if a path or one of its parents matches any pattern.
+  /// \param p Path string
+  /// \return True if matched
+  ///
+  bool matches(std::string_view p) const noexcept;
+
+  ///
+  /// Returns all patterns in the order added.
+  /// \return Patterns
+  ///
+  const pattern_list_type& patterns() const;
+
+  ///
+  /// Returns the number of patterns.
+  /// \return Size
+  ///
+  size_type size() const;
+
+  ///
+  /// Says if there are no patterns.
+  /// \return True if empty
+  ///
+  bool empty() const;
+
+// Modifiers
+public:
+  ///
+  /// Adds a pattern and recompiles the automaton.
+  ///
+  /// Throws std::invalid_argument if the pattern has no components and std::length_error if the automaton gets too large.
+  ///
+  /// \param pattern Pattern to add
+  ///
+  void add(std::string_view pattern);
+
+  ///
+  /// Adds a range of patterns and recompiles the automaton once.
+  /// \see add
+  ///
+  /// \tparam InputIt Input iterator with a value type convertible to std::string_view
+  /// \param first First pattern
+  /// \param last Last pattern
+  ///
+  template<typename InputIt>
+  void add(InputIt first, InputIt last);
+
+  ///
+  /// Clears the contents.
+  ///
+  void clear();
+
+// Implementation
+private:
+  ///
+  /// Checks a pattern and adds it without recompiling.
+  /// \param pattern Pattern to add
+  ///
+  void append(std::string_view pattern);
+
+  ///
+  /// Builds both automatons from the patterns.
+  ///
+  void compile();
+
+// Variables
+private:
+  pattern_list_type patterns_; ///< All patterns
+  std::vector<std::uint32_t> component_dfa_; ///< Component DFA transitions, 256 per state, state 0 is dead
+  std::uint32_t component_start_; ///< Component DFA start state
+  std::vector<std::uint32_t> component_class_; ///< Class of each component DFA state, class 0 matches no glob
+  std::vector<std::uint32_t> path_dfa_; ///< Path DFA transitions, one per component class and state, state 0 is dead
+  std::vector<bool> path_accept_; ///< Says for each path DFA state if a pattern matched
+  std::uint32_t path_start_; ///< Path DFA start state
+  std::uint32_t classes_; ///< Number of component classes
+};
+
+
+template<typename InputIt>
+void path_pattern_set::add(InputIt first, InputIt last)
+{
+  const auto old_size = patterns_.size();
+  try
+  {
+    for (; first != last; ++first)
+    {
+      append(*first);
+    }
+    compile();
+  }
+  catch (...)
+  {
+    patterns_.resize(old_size);
+    compile();
+    throw;
+  }
+}
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_PATH_PATTERN_SET_HPP
@@ -0,0 +1,210 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_PATH_PREFIX_INDEX_HPP
+#define INC_ARUDE_PATH_PREFIX_INDEX_HPP
+
+#include "libarude/path_trie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Sorted list of marked paths for resolving large batches of paths in one merge pass.
+///
+/// Holds the same marks as a path_trie, but as a sorted vector of keys. A key is the list of components, each one terminated by a separator, so
+/// all sub paths of a path form one contiguous range following it. A sorted batch of paths is then resolved by walking both lists once, keeping
+/// the marked parents of the current path on a stack. The prefix comparisons use SSE2 where available.
+/// Paths can be given relative to a root id, the key is then prefixed by the root id. Paths of different roots never are sub paths of each other.
+/// The roots themselves are held in a second sorted list, so full paths are resolved to their deepest root within the same merge.
+/// This class is as thread safe as a std::vector.
+///
+class path_prefix_index final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+  using mark = path_trie::mark; ///< Mark type
+  using root_id = std::uint32_t; ///< Root id type
+
+  ///
+  /// Path with its root and mark, used for assign().
+  ///
+  struct marked_path
+  {
+    std::string_view path; ///< Path string, relative to the root
+    mark m; ///< Mark
+    root_id root; ///< Root id
+  };
+
+// Accessors
+public:
+  ///
+  /// Resolves a batch of paths.
+  ///
+  /// The batch is sorted by key unless already sorted, then merged against the index. Each path gets the deepest mark of itself and its
+  /// parents, like path_trie::lookup().
+  ///
+  /// \param in Path strings
+  /// \param roots Root id of each path, nullptr if all paths are relative to root 0
+  /// \param n Number of paths
+  /// \param out Receives the mark of each path
+  ///
+  void lookup_n(const std::string_view* in, const root_id* roots, size_type n, mark* out) const;
+
+  ///
+  /// Resolves a batch of full paths.
+  ///
+  /// The batch is sorted by key and merged against the sorted roots first, each path is taken relative to its deepest root, or root 0 if there
+  /// is none. The paths are then merged against the index like with lookup_n().
+  ///
+  /// \param in Path strings
+  /// \param n Number of paths
+  /// \param out Receives the mark of each path
+  ///
+  void resolve_n(const std::string_view* in, size_type n, mark* out) const;
+
+  ///
+  /// Returns the number of marked paths.
+  /// \return Size
+  ///
+  size_type size() const;
+
+  ///
+  /// Appends the key of a path.
+  /// \param p Path string
+  /// \param out String to append to
+  ///
+  static void append_key(std::string_view p, std::string& out);
+
+  ///
+  /// Appends the key of a path relative to a root.
+  /// \param root Root id
+  /// \param p Path string
+  /// \param out String to append to
+  ///
+  static void append_key(root_id root, std::string_view p, std::string& out);
+
+// Modifiers
+public:
+  ///
+  /// Replaces the contents, sorting all paths once.
+  /// \param paths Paths and their marks, the last mark of a path wins
+  ///
+  void assign(const std::vector<marked_path>& paths);
+
+  ///
+  /// Replaces the roots, sorting them once.
+  /// \param roots Root paths, the root id of a path is its position plus one
+  ///
+  void assign_roots(const std::vector<std::string_view>& roots);
+
+  ///
+  /// Moves a root to another path, the marked paths relative to it follow.
+  /// \param root Root id
+  /// \param p New path string of the root
+  ///
+  void set_root(root_id root, std::string_view p);
+
+  ///
+  /// Sets the mark of a path, mark::none removes it.
+  /// \param p Path string
+  /// \param m Mark to set
+  /// \param root Root id, \a p is relative to it
+  ///
+  void set(std::string_view p, mark m, root_id root = 0);
+
+  ///
+  /// Clears the marks strictly below a path.
+  /// \param p Path string
+  ///
+  void clear_below(std::string_view p);
+
+  ///
+  /// Clears a specific mark strictly below a path.
+  /// \param p Path string
+  /// \param m Mark to clear, mark::none for all marks
+  /// \param root Root id, \a p is relative to it
+  ///
+  void clear_below(std::string_view p, mark m, root_id root = 0);
+
+  ///
+  /// Clears the contents.
+  ///
+  void clear();
+
+// Implementation
+private:
+  ///
+  /// Marked path.
+  ///
+  struct entry
+  {
+    std::string key; ///< Key of the path
+    mark m; ///< Mark
+  };
+
+  ///
+  /// Root path.
+  ///
+  struct root_entry
+  {
+    std::string key; ///< Key of the path, without root id prefix
+    root_id root; ///< Root id
+  };
+
+  ///
+  /// Merges a batch of keys against the index.
+  /// \param keys Key of each path
+  /// \param order Positions of the paths sorted by key
+  /// \param out Receives the mark of each path
+  ///
+  void merge(const std::vector<std::string_view>& keys, const std::vector<size_type>& order, mark* out) const;
+
+  ///
+  /// Says if a string starts with a prefix.
+  /// \param s String
+  /// \param prefix Prefix
+  /// \return True if \a s starts with \a prefix
+  ///
+  static bool starts_with(std::string_view s, std::string_view prefix) noexcept;
+
+// Variables
+private:
+  std::vector<entry> entries_; ///< All marked paths sorted by key
+  std::vector<root_entry> roots_; ///< All roots sorted by key
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_PATH_PREFIX_INDEX_HPP
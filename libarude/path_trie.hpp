@@ -0,0 +1,230 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_PATH_TRIE_HPP
+#define INC_ARUDE_PATH_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Trie over path components where nodes can be marked as included or excluded.
+///
+/// A path is looked up component by component from the root, the deepest mark met on the way is the result. So an exclude mark covers a whole sub
+/// tree, while an include mark further down opens a part of it again.
+/// Children are found through one open addressing hash table keyed by parent node and component name, component names are stored in a single
+/// buffer. A lookup is O(depth) and does not allocate.
+/// This class is as thread safe as a std::vector.
+///
+class path_trie final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+  using node_id = std::uint32_t; ///< Node index type
+
+  ///
+  /// Node mark.
+  ///
+  enum class mark : std::uint8_t
+  {
+    none, ///< No mark, the mark of the parent applies
+    include, ///< Node and sub tree are included
+    exclude ///< Node and sub tree are excluded
+  };
+
+// Constants
+public:
+  static constexpr node_id root = 0; ///< Root node
+  static constexpr node_id npos = static_cast<node_id>(-1); ///< Not a node
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  path_trie();
+
+// Accessors
+public:
+  ///
+  /// Returns the mark which applies to a path, which is the deepest mark on the way from the start node to the path.
+  /// \param p Path string
+  /// \param from Start node, \a p is relative to it
+  /// \return Mark, mark::none if no node on the way is marked
+  ///
+  mark lookup(std::string_view p, node_id from = root) const noexcept;
+
+  ///
+  /// Returns the node of a path.
+  /// \param p Path string
+  /// \param from Start node, \a p is relative to it
+  /// \return Node or npos if there is no node for the path
+  ///
+  node_id find(std::string_view p, node_id from = root) const noexcept;
+
+  ///
+  /// Returns the node of a path component below a node.
+  /// \param parent Parent node
+  /// \param name Component name
+  /// \return Node or npos if there is no such child
+  ///
+  node_id child(node_id parent, std::string_view name) const noexcept;
+
+  ///
+  /// Returns the mark set on a node.
+  /// \param n Node
+  /// \return Mark
+  ///
+  mark node_mark(node_id n) const noexcept;
+
+  ///
+  /// Returns the marked nodes in the sub tree of a node.
+  /// \param n Node
+  /// \return Marked nodes, \a n itself included
+  ///
+  std::vector<node_id> marked_subtree(node_id n) const;
+
+  ///
+  /// Returns the number of nodes including the root and the pruned nodes kept for reuse, all node ids are below it.
+  /// \return Size
+  ///
+  size_type size() const;
+
+// Modifiers
+public:
+  ///
+  /// Returns the node of a path, creating the nodes as needed.
+  /// \param p Path string
+  /// \param from Start node, \a p is relative to it
+  /// \return Node
+  ///
+  node_id insert(std::string_view p, node_id from = root);
+
+  ///
+  /// Sets the mark of a path, creating the nodes as needed.
+  /// \param p Path string
+  /// \param m Mark to set
+  /// \param from Start node, \a p is relative to it
+  ///
+  void set(std::string_view p, mark m, node_id from = root);
+
+  ///
+  /// Clears the marks strictly below a path.
+  /// \param p Path string
+  ///
+  void clear_below(std::string_view p);
+
+  ///
+  /// Clears a specific mark strictly below a path.
+  /// \param p Path string
+  /// \param m Mark to clear, mark::none for all marks
+  /// \param from Start node, \a p is relative to it
+  ///
+  void clear_below(std::string_view p, mark m, node_id from = root);
+
+  ///
+  /// Removes a node if it has neither a mark nor children, then its parents the same way.
+  /// The ids of removed nodes are reused by insert().
+  /// \param n Node
+  ///
+  void prune(node_id n);
+
+  ///
+  /// Clears the contents.
+  ///
+  void clear();
+
+// Implementation
+private:
+  ///
+  /// Trie node.
+  ///
+  struct node
+  {
+    node_id parent; ///< Parent node, npos for the root and removed nodes
+    node_id first_child; ///< First child or npos
+    node_id next_sibling; ///< Next sibling or npos
+    std::uint32_t name_offset; ///< Offset of the component name in names_
+    std::uint32_t name_size; ///< Size of the component name
+    std::uint32_t hash; ///< Hash of parent and component name
+    mark m; ///< Mark
+  };
+
+  ///
+  /// Hashes a component name below a parent.
+  /// \param parent Parent node
+  /// \param name Component name
+  /// \return Hash
+  ///
+  static std::uint32_t hash(node_id parent, std::string_view name) noexcept;
+
+  ///
+  /// Returns the home slot of a hash.
+  /// \param h Hash
+  /// \return Slot index
+  ///
+  size_type home(std::uint32_t h) const noexcept;
+
+  ///
+  /// Adds a child node.
+  /// \param parent Parent node
+  /// \param name Component name
+  /// \return New node
+  ///
+  node_id add_child(node_id parent, std::string_view name);
+
+  ///
+  /// Rebuilds the hash table with twice the size.
+  ///
+  void grow();
+
+  ///
+  /// Clears marks in the sub tree of a node, the node itself excluded.
+  /// \param n Node
+  /// \param m Mark to clear, mark::none for all marks
+  ///
+  void clear_subtree(node_id n, mark m) noexcept;
+
+// Variables
+private:
+  std::vector<node> nodes_; ///< All nodes, the root first
+  std::string names_; ///< Component names of all nodes
+  std::vector<node_id> slots_; ///< Hash table of all nodes but the root, size is a power of two
+  std::vector<node_id> free_; ///< Removed nodes to reuse
+  unsigned shift_; ///< Shift selecting the home slot from a hash
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_PATH_TRIE_HPP
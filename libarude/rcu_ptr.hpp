@@ -0,0 +1,152 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_RCU_PTR_HPP
+#define INC_ARUDE_RCU_PTR_HPP
+
+#include "libarude/epoch.hpp"
+#include "libarude/noncopyable.hpp"
+
+#include <atomic>
+#include <memory>
+
+
+namespace arude
+{
+
+///
+/// Owning pointer to an immutable object which is replaced as a whole (read copy update).
+///
+/// Readers get the current object through read() without taking a lock, the object stays valid as long as the returned guard lives.
+/// Writers build a new object and publish() it, the old one is deleted through the global epoch_domain once the last reader holding it is gone.
+/// Concurrent publishers must be serialized by the caller.
+///
+/// \tparam T Object type
+///
+template<typename T>
+class rcu_ptr final : noncopyable
+{
+// Typedefs
+public:
+  using element_type = T; ///< Object type
+
+  ///
+  /// Read access to the object which was current when the guard was created.
+  ///
+  class read_guard final : noncopyable
+  {
+  // Structors
+  public:
+    ///
+    /// Ctor.
+    /// \param p Published pointer to load
+    ///
+    explicit read_guard(const std::atomic<const element_type*>& p) noexcept
+      : p_{ p.load(std::memory_order_acquire) }
+    {
+    }
+
+  // Accessors
+  public:
+    ///
+    /// Returns the object, nullptr if none was published.
+    /// \return Object
+    ///
+    const element_type* get() const noexcept
+    {
+      return p_;
+    }
+
+    const element_type& operator*() const noexcept
+    {
+      return *p_;
+    }
+
+    const element_type* operator->() const noexcept
+    {
+      return p_;
+    }
+
+  // Variables
+  private:
+    epoch_guard guard_; ///< Critical section keeping the object alive, must be entered before loading
+    const element_type* p_; ///< Object
+  };
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param init Initial object
+  ///
+  explicit rcu_ptr(std::unique_ptr<const element_type> init = {})
+    : p_{ init.release() }
+  {
+  }
+
+  ///
+  /// Dtor.
+  /// No reader may be left.
+  ///
+  ~rcu_ptr()
+  {
+    delete p_.load();
+  }
+
+// Accessors
+public:
+  ///
+  /// Returns read access to the current object.
+  /// \return Guard holding the object
+  ///
+  read_guard read() const noexcept
+  {
+    return read_guard{ p_ };
+  }
+
+// Modifiers
+public:
+  ///
+  /// Replaces the current object.
+  /// \param next New object
+  ///
+  void publish(std::unique_ptr<const element_type> next)
+  {
+    const auto old = p_.exchange(next.release(), std::memory_order_seq_cst);
+    if (old != nullptr)
+    {
+      epoch_domain::global().retire(old);
+    }
+  }
+
+// Variables
+private:
+  std::atomic<const element_type*> p_; ///< Current object
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_RCU_PTR_HPP
@@ -0,0 +1,204 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_RING_BUFFER_HPP
+#define INC_ARUDE_RING_BUFFER_HPP
+
+#include "libarude/noncopyable.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace arude
+{
+
+///
+/// Bounded lock free queue for many producers and a single consumer.
+///
+/// The values live in a ring of cells, each with a sequence number telling if it is free for the producer of a position or filled for the
+/// consumer (Vyukov). Producers claim a position with a compare and swap, the consumer takes values without any read modify write.
+/// Neither side waits: a full queue fails to push, which lets the producer apply backpressure as it sees fit, an empty one pops nothing.
+/// Closing tells the consumer that no more values come.
+///
+/// \tparam T Value type, default constructible and move assignable
+///
+template<typename T>
+class ring_buffer final : noncopyable
+{
+// Typedefs
+public:
+  using value_type = T; ///< Value type
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param capacity Least number of values held, rounded up to a power of two
+  ///
+  explicit ring_buffer(size_type capacity)
+    : mask_{ round_up(capacity) - 1 }
+    , cells_{ new cell[mask_ + 1] }
+  {
+    for (auto i = size_type{ 0 }; i <= mask_; ++i)
+    {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+// Accessors
+public:
+  ///
+  /// Returns the number of values held at most.
+  /// \return Capacity
+  ///
+  size_type capacity() const noexcept
+  {
+    return mask_ + 1;
+  }
+
+  ///
+  /// Says if the queue was closed.
+  /// \return True if closed
+  ///
+  bool closed() const noexcept
+  {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+// Modifiers
+public:
+  ///
+  /// Appends a value, thread safe.
+  /// \param v Value, moved from only if appended
+  /// \return False if full
+  ///
+  bool try_push(value_type&& v)
+  {
+    auto pos = tail_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      auto& c = cells_[pos & mask_];
+      const auto diff = static_cast<std::intptr_t>(c.seq.load(std::memory_order_acquire)) - static_cast<std::intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          c.value = std::move(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        // The cell still holds the value of the former round
+        return false;
+      }
+      else
+      {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  ///
+  /// Takes values in the order pushed, only called by the consumer.
+  ///
+  /// \param out Output iterator receiving the values
+  /// \param n Maximum number of values to take
+  /// \return Number of values taken
+  ///
+  template<typename O>
+  size_type try_pop(O out, size_type n)
+  {
+    auto count = size_type{ 0 };
+    for (; count < n; ++count)
+    {
+      auto& c = cells_[head_ & mask_];
+      if (c.seq.load(std::memory_order_acquire) != head_ + 1)
+      {
+        break;
+      }
+      *out++ = std::move(c.value);
+      c.seq.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+
+    return count;
+  }
+
+  ///
+  /// Closes the queue, called when all values were pushed.
+  ///
+  void close() noexcept
+  {
+    closed_.store(true, std::memory_order_release);
+  }
+
+// Types
+private:
+  ///
+  /// Slot of the ring.
+  ///
+  struct cell
+  {
+    std::atomic<size_type> seq; ///< Position the cell is free for, or position + 1 once filled
+    value_type value; ///< Value
+  };
+
+// Implementation
+private:
+  ///
+  /// Rounds up to a power of two.
+  /// \param n Number
+  /// \return Power of two not less than n, at least 2
+  ///
+  static size_type round_up(size_type n)
+  {
+    auto p = size_type{ 2 };
+    while (p < n)
+    {
+      p <<= 1;
+    }
+    return p;
+  }
+
+// Variables
+private:
+  const size_type mask_; ///< Capacity - 1
+  const std::unique_ptr<cell[]> cells_; ///< Ring of cells
+  alignas(64) std::atomic<size_type> tail_{ 0 }; ///< Next position to push, shared by the producers
+  alignas(64) size_type head_ = 0; ///< Next position to pop, owned by the consumer
+  alignas(64) std::atomic<bool> closed_{ false }; ///< Set once no more values come
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_RING_BUFFER_HPP
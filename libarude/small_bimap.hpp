@@ -0,0 +1,423 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_SMALL_BIMAP_HPP
+#define INC_ARUDE_SMALL_BIMAP_HPP
+
+
+#include "libarude/bimap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ARUDE_SMALL_BIMAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARUDE_SMALL_BIMAP_SSE2
+#endif
+
+
+namespace arude
+{
+namespace small_bimap_detail
+{
+
+///
+/// Unsigned integer type of a given size.
+///
+template<std::size_t S>
+struct bits;
+
+template<>
+struct bits<1>
+{
+  using type = std::uint8_t;
+};
+
+template<>
+struct bits<2>
+{
+  using type = std::uint16_t;
+};
+
+template<>
+struct bits<4>
+{
+  using type = std::uint32_t;
+};
+
+template<>
+struct bits<8>
+{
+  using type = std::uint64_t;
+};
+
+///
+/// Returns the index of the lowest set bit.
+/// \param m Non zero mask
+/// \return Bit index
+///
+inline unsigned lowest_bit(std::uint32_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(m));
+#else
+  auto i = 0u;
+  while ((m & 1) == 0)
+  {
+    m >>= 1;
+    ++i;
+  }
+  return i;
+#endif
+}
+
+#if defined(ARUDE_SMALL_BIMAP_AVX2)
+
+///
+/// Compares 32 bytes against a broadcast key.
+/// \return Byte mask of equal elements
+///
+template<std::size_t S>
+std::uint32_t compare(const void* p, __m256i key)
+{
+  const auto v = _mm256_load_si256(static_cast<const __m256i*>(p));
+  switch (S)
+  {
+    case 1: return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, key)));
+    case 2: return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, key)));
+    case 4: return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(v, key)));
+    default: return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi64(v, key)));
+  }
+}
+
+template<std::size_t S>
+__m256i broadcast(typename bits<S>::type k)
+{
+  switch (S)
+  {
+    case 1: return _mm256_set1_epi8(static_cast<char>(k));
+    case 2: return _mm256_set1_epi16(static_cast<short>(k));
+    case 4: return _mm256_set1_epi32(static_cast<int>(k));
+    default: return _mm256_set1_epi64x(static_cast<long long>(k));
+  }
+}
+
+constexpr std::size_t vector_size = 32; ///< Bytes compared at once
+
+#elif defined(ARUDE_SMALL_BIMAP_SSE2)
+
+///
+/// Compares 16 bytes against a broadcast key.
+/// \return Byte mask of equal elements
+///
+template<std::size_t S>
+std::uint32_t compare_half(const __m128i* p, __m128i key)
+{
+  const auto v = _mm_load_si128(p);
+  switch (S)
+  {
+    case 1: return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, key)));
+    case 2: return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, key)));
+    case 4: return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(v, key)));
+    default:
+    { // No 64 bit compare in SSE2, both 32 bit halves must be equal
+      const auto eq = _mm_cmpeq_epi32(v, key);
+      return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)))));
+    }
+  }
+}
+
+///
+/// Compares 32 bytes against a broadcast key, the arrays are aligned and sized to 32 bytes.
+/// \return Byte mask of equal elements
+///
+template<std::size_t S>
+std::uint32_t compare(const void* p, __m128i key)
+{
+  const auto v = static_cast<const __m128i*>(p);
+  return compare_half<S>(v, key) | compare_half<S>(v + 1, key) << 16;
+}
+
+template<std::size_t S>
+__m128i broadcast(typename bits<S>::type k)
+{
+  switch (S)
+  {
+    case 1: return _mm_set1_epi8(static_cast<char>(k));
+    case 2: return _mm_set1_epi16(static_cast<short>(k));
+    case 4: return _mm_set1_epi32(static_cast<int>(k));
+    default: return _mm_set_epi32(static_cast<int>(static_cast<std::uint64_t>(k) >> 32), static_cast<int>(k), static_cast<int>(static_cast<std::uint64_t>(k) >> 32), static_cast<int>(k));
+  }
+}
+
+constexpr std::size_t vector_size = 32; ///< Bytes compared at once
+
+#endif
+
+///
+/// Finds a key in an aligned array.
+///
+/// \param data Array, aligned to 32 bytes and readable in whole vectors
+/// \param n Number of used elements
+/// \param v Key to find
+/// \return Index of the key or \a n if not found
+///
+template<typename T>
+std::size_t find(const T* data, std::size_t n, const T& v)
+{
+  using bits_type = typename bits<sizeof(T)>::type;
+  auto k = bits_type{};
+  std::memcpy(&k, &v, sizeof(T));
+
+#if defined(ARUDE_SMALL_BIMAP_AVX2) || defined(ARUDE_SMALL_BIMAP_SSE2)
+  constexpr auto per_vector = vector_size / sizeof(T);
+  const auto key = broadcast<sizeof(T)>(k);
+
+  // Keys are unique, so at most one used element matches. The masks of all vectors are ORed together along with the offset of the matching
+  // vector, one bit scan at the end and no branch per vector.
+  auto found = std::uint32_t{ 0 };
+  auto offset = std::size_t{ 0 };
+  for (auto first = std::size_t{ 0 }; first < n; first += per_vector)
+  {
+    // Unused elements behind n can match as well
+    const auto used = (n - first) * sizeof(T);
+    const auto mask = compare<sizeof(T)>(data + first, key) & (used >= vector_size ? ~std::uint32_t{ 0 } : (std::uint32_t{ 1 } << used) - 1);
+    found |= mask;
+    offset |= first & (std::size_t{ 0 } - std::size_t{ mask != 0 });
+  }
+  return found == 0 ? n : offset + lowest_bit(found) / sizeof(T);
+#else
+  for (auto i = std::size_t{ 0 }; i < n; ++i)
+  {
+    auto e = bits_type{};
+    std::memcpy(&e, data + i, sizeof(T));
+    if (e == k)
+    {
+      return i;
+    }
+  }
+  return n;
+#endif
+}
+
+} // namespace small_bimap_detail
+
+///
+/// Small variant of the bimap for integral and enum types.
+///
+/// Up to C mappings are stored in place in two aligned arrays, the mapping at index i is left[i] and right[i]. A lookup compares the key against
+/// a whole vector of elements at once (AVX2 or SSE2, scalar without either) and takes the index from the compare mask, no allocation and no
+/// pointer chasing. Mappings can be inserted until the capacity is reached.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+/// \tparam C Capacity
+///
+template<typename LT, typename RT, std::size_t C = 64>
+class small_bimap
+{
+  static_assert(!std::is_same<LT, RT>::value, "small_bimap can't map between equal left and right type");
+  static_assert((std::is_integral<LT>::value || std::is_enum<LT>::value) && (std::is_integral<RT>::value || std::is_enum<RT>::value),
+    "small_bimap supports integral and enum types only");
+  static_assert(C % 32 == 0, "small_bimap capacity must be a multiple of 32");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  small_bimap() = default;
+
+  ///
+  /// Ctor.
+  /// \param init Initializer list with mappings to initialize the bimap
+  ///
+  small_bimap(std::initializer_list<std::pair<left_type, right_type>> init)
+  {
+    for (const auto& i : init)
+    {
+      insert(i.first, i.second);
+    }
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  right_type map(left_type v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  left_type map(right_type v) const
+  {
+    const auto p = find(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Looks up the second type value of a first type value. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Pointer to the second type value or nullptr if not mapped
+  ///
+  const right_type* find(left_type v) const
+  {
+    const auto i = small_bimap_detail::find(m_left, m_size, v);
+    return i == m_size ? nullptr : &m_right[i];
+  }
+
+  ///
+  /// Looks up the first type value of a second type value. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return Pointer to the first type value or nullptr if not mapped
+  ///
+  const left_type* find(right_type v) const
+  {
+    const auto i = small_bimap_detail::find(m_right, m_size, v);
+    return i == m_size ? nullptr : &m_left[i];
+  }
+
+  ///
+  /// Map first to second type. Never throws on a missing mapping.
+  /// \param v First type value
+  /// \return Second type value or empty if not mapped
+  ///
+  std::optional<right_type> try_map(left_type v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<right_type>{} : std::optional<right_type>{ *p };
+  }
+
+  ///
+  /// Map second to first type. Never throws on a missing mapping.
+  /// \param v Second type value
+  /// \return First type value or empty if not mapped
+  ///
+  std::optional<left_type> try_map(right_type v) const
+  {
+    const auto p = find(v);
+    return p == nullptr ? std::optional<left_type>{} : std::optional<left_type>{ *p };
+  }
+
+  ///
+  /// Returns the size of the bimap.
+  /// \return Size
+  ///
+  size_type size() const
+  {
+    return m_size;
+  }
+
+  ///
+  /// Returns the maximum number of mappings.
+  /// \return Capacity
+  ///
+  static constexpr size_type capacity()
+  {
+    return C;
+  }
+
+// Modifiers
+public:
+  ///
+  /// Inserts a new mapping.
+  /// Throws std::length_error if the capacity is exhausted.
+  ///
+  /// \param lv Left value
+  /// \param rv Right value
+  ///
+  void insert(left_type lv, right_type rv)
+  {
+    // Check for the possibility to mess up uniqueness
+    if (find(lv) != nullptr || find(rv) != nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
+    }
+
+    if (m_size == C)
+    {
+      BOOST_THROW_EXCEPTION(std::length_error{ "small_bimap capacity exhausted" });
+    }
+
+    m_left[m_size] = lv;
+    m_right[m_size] = rv;
+    ++m_size;
+  }
+
+// Operations
+public:
+  ///
+  /// Clears the bimap of all contents.
+  ///
+  void clear()
+  {
+    m_size = 0;
+  }
+
+// Variables
+private:
+  alignas(32) left_type m_left[C] = {}; ///< Left values
+  alignas(32) right_type m_right[C] = {}; ///< Right values
+  size_type m_size = 0; ///< Number of mappings
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_SMALL_BIMAP_HPP
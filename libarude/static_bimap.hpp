@@ -0,0 +1,277 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_STATIC_BIMAP_HPP
+#define INC_ARUDE_STATIC_BIMAP_HPP
+
+
+#include "libarude/bimap.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace arude
+{
+
+///
+/// Hash usable in constant expressions, used by the static_bimap.
+/// Specialized for integral types, enums and string views.
+///
+/// \tparam T Type to hash
+///
+template<typename T, typename = void>
+struct static_hash;
+
+///
+/// Static hash for integral types and enums (splitmix64 finalizer).
+///
+template<typename T>
+struct static_hash<T, std::enable_if_t<std::is_integral<T>::value || std::is_enum<T>::value>>
+{
+  constexpr std::uint64_t operator()(T v) const noexcept
+  {
+    auto h = static_cast<std::uint64_t>(v);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+  }
+};
+
+///
+/// Static hash for string views (FNV-1a).
+///
+template<>
+struct static_hash<std::string_view>
+{
+  constexpr std::uint64_t operator()(std::string_view v) const noexcept
+  {
+    auto h = 0xcbf29ce484222325ull;
+    for (const auto c : v)
+    {
+      h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return static_hash<std::uint64_t>{}(h);
+  }
+};
+
+///
+/// Compile time variant of the bimap.
+///
+/// Built from a literal table, both directions are stored in open addressing hash tables with a load factor of at most one half which are
+/// computed while constructing. Declared constexpr, the whole table lives in read only data: no allocation and no static initialization.
+/// Non unique mappings are detected while constructing. In a constant expression this makes the compilation fail, otherwise a
+/// nonuniquemapping_exception is thrown like in the bimap.
+/// Supported types are integral types, enums and std::string_view, all having a static_hash.
+///
+/// Example:
+/// constexpr auto names = arude::make_static_bimap<color, std::string_view>({ { color::red, "red" }, { color::green, "green" } });
+/// static_assert(names.map(color::green) == "green", "");
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+/// \tparam N Number of mappings
+///
+template<typename LT, typename RT, std::size_t N>
+class static_bimap
+{
+  static_assert(!std::is_same<LT, RT>::value, "static_bimap can't map between equal left and right type");
+  static_assert(N > 0, "static_bimap needs at least one mapping");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using value_type = std::pair<left_type, right_type>; ///< Mapping type
+  using size_type = std::size_t; ///< Size type
+
+// Constants
+private:
+  ///
+  /// Smallest power of two keeping the load factor at most one half.
+  ///
+  static constexpr size_type table_size()
+  {
+    auto s = size_type{ 2 };
+    while (s < 2 * N)
+    {
+      s <<= 1;
+    }
+    return s;
+  }
+
+  using index_type = std::conditional_t<(N < 0xff), std::uint8_t, std::conditional_t<(N < 0xffff), std::uint16_t, std::uint32_t>>; ///< Table slot type
+  static constexpr index_type empty_slot = std::numeric_limits<index_type>::max(); ///< Marks an unused slot
+  using table_type = std::array<index_type, table_size()>; ///< Hash table type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param init Table with all mappings
+  ///
+  constexpr static_bimap(const value_type (&init)[N])
+  {
+    for (auto& i : m_ltable)
+    {
+      i = empty_slot;
+    }
+    for (auto& i : m_rtable)
+    {
+      i = empty_slot;
+    }
+
+    for (auto i = size_type{ 0 }; i < N; ++i)
+    {
+      m_left[i] = init[i].first;
+      m_right[i] = init[i].second;
+      emplace(m_ltable, m_left, i);
+      emplace(m_rtable, m_right, i);
+    }
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  constexpr const right_type& map(const left_type& v) const
+  {
+    const auto i = lookup(m_ltable, m_left, v);
+    if (i == empty_slot)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return m_right[i];
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  constexpr const left_type& map(const right_type& v) const
+  {
+    const auto i = lookup(m_rtable, m_right, v);
+    if (i == empty_slot)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return m_left[i];
+  }
+
+  ///
+  /// Returns the size of the bimap.
+  /// \return Size
+  ///
+  constexpr size_type size() const
+  {
+    return N;
+  }
+
+// Implementation
+private:
+  ///
+  /// Adds the key with index \a i to a hash table.
+  ///
+  /// \param table Hash table to fill
+  /// \param keys All keys of this side
+  /// \param i Index of the key to add
+  ///
+  template<typename T>
+  static constexpr void emplace(table_type& table, const std::array<T, N>& keys, size_type i)
+  {
+    constexpr auto mask = table_size() - 1;
+    for (auto s = static_cast<size_type>(static_hash<T>{}(keys[i])) & mask;; s = (s + 1) & mask)
+    {
+      if (table[s] == empty_slot)
+      {
+        table[s] = static_cast<index_type>(i);
+        return;
+      }
+      if (keys[table[s]] == keys[i])
+      {
+        BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
+      }
+    }
+  }
+
+  ///
+  /// Looks up a key in a hash table.
+  ///
+  /// \param table Hash table to search
+  /// \param keys All keys of this side
+  /// \param v Key to search
+  /// \return Index of the key or empty_slot if not found
+  ///
+  template<typename T>
+  static constexpr index_type lookup(const table_type& table, const std::array<T, N>& keys, const T& v)
+  {
+    constexpr auto mask = table_size() - 1;
+    for (auto s = static_cast<size_type>(static_hash<T>{}(v)) & mask;; s = (s + 1) & mask)
+    {
+      if (table[s] == empty_slot || keys[table[s]] == v)
+      {
+        return table[s];
+      }
+    }
+  }
+
+// Variables
+private:
+  std::array<left_type, N> m_left{}; ///< Left values
+  std::array<right_type, N> m_right{}; ///< Right values
+  table_type m_ltable{}; ///< Hash table over the left values
+  table_type m_rtable{}; ///< Hash table over the right values
+};
+
+///
+/// Creates a static bimap from a literal table, deducing the number of mappings.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+/// \tparam N Number of mappings
+/// \param init Table with all mappings
+/// \return Static bimap
+///
+template<typename LT, typename RT, std::size_t N>
+constexpr static_bimap<LT, RT, N> make_static_bimap(const std::pair<LT, RT> (&init)[N])
+{
+  return static_bimap<LT, RT, N>{ init };
+}
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_STATIC_BIMAP_HPP
@@ -0,0 +1,97 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_STRING_POOL_HPP
+#define INC_ARUDE_STRING_POOL_HPP
+
+#include "libarude/noncopyable.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_set>
+
+
+namespace arude
+{
+
+///
+/// Interns strings into a shared arena.
+///
+/// Every distinct string is stored once in a monotonic arena, the index of the pool lives in the arena too. Interning returns a
+/// std::string_view which stays valid until the pool is cleared or destroyed. Containers keyed by these views, e.g. a
+/// bimap<std::string_view, id>, pay neither per key heap allocations nor key copies when they are copied. All strings are released at once.
+/// This class is as thread safe as a std::vector.
+///
+/// Example:
+/// arude::string_pool names;
+/// arude::bimap<std::string_view, int> ids{ { names.intern(read_name()), 1 } };
+///
+class string_pool final : noncopyable
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  /// \param upstream Memory resource the arena allocates from
+  ///
+  explicit string_pool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+// Accessors
+public:
+  ///
+  /// Returns the number of distinct strings.
+  /// \return Size
+  ///
+  size_type size() const;
+
+// Modifiers
+public:
+  ///
+  /// Interns a string.
+  /// \param s String to intern
+  /// \return View of the pooled string, equal strings share the same storage
+  ///
+  std::string_view intern(std::string_view s);
+
+  ///
+  /// Releases all strings, invalidating all views returned by intern().
+  ///
+  void clear();
+
+// Variables
+private:
+  std::pmr::monotonic_buffer_resource arena_; ///< Arena holding the characters
+  std::pmr::unordered_set<std::string_view> strings_; ///< Index of all interned strings, allocated from the arena
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_STRING_POOL_HPP
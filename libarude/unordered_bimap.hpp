@@ -0,0 +1,485 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_UNORDERED_BIMAP_HPP
+#define INC_ARUDE_UNORDERED_BIMAP_HPP
+
+
+#include "libarude/bimap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Hash used by default in the unordered_bimap.
+/// Strings and string views are hashed through their string view, which makes lookups by std::string, std::string_view or
+/// const char* possible without constructing a key.
+///
+/// \tparam T Type to hash
+///
+template<typename T>
+struct transparent_hash : std::hash<T>
+{
+};
+
+///
+/// Transparent hash for strings.
+///
+template<typename C, typename TR, typename A>
+struct transparent_hash<std::basic_string<C, TR, A>>
+{
+  using is_transparent = void; ///< Enables heterogeneous lookup
+
+  std::size_t operator()(std::basic_string_view<C, TR> v) const noexcept
+  {
+    return std::hash<std::basic_string_view<C, TR>>{}(v);
+  }
+};
+
+///
+/// Transparent hash for string views.
+///
+template<typename C, typename TR>
+struct transparent_hash<std::basic_string_view<C, TR>> : transparent_hash<std::basic_string<C, TR>>
+{
+};
+
+///
+/// Hash based variant of the bimap.
+///
+/// All mappings are stored in one contiguous value array. Both directions are indexed by a single open addressing slot array with linear probing,
+/// each slot holds the value index and a hash tag for the left and for the right side. With transparent hash and equality functions (the default
+/// for strings), lookups take any type comparable to the key, e.g. a std::string_view for a std::string key, and never allocate.
+/// Like the bimap, mappings can be inserted but not removed.
+///
+/// \tparam LT Left map type
+/// \tparam RT Right map type
+/// \tparam LH Left hash function
+/// \tparam LE Left equality function
+/// \tparam RH Right hash function
+/// \tparam RE Right equality function
+///
+template<typename LT, typename RT, typename LH = transparent_hash<LT>, typename LE = std::equal_to<>, typename RH = transparent_hash<RT>,
+  typename RE = std::equal_to<>>
+class unordered_bimap
+{
+  static_assert(!std::is_same<LT, RT>::value, "unordered_bimap can't map between equal left and right type");
+
+// Typedefs
+public:
+  using left_type = LT; ///< Left bimap type
+  using right_type = RT; ///< Right bimap type
+  using value_type = std::pair<left_type, right_type>; ///< Mapping type
+  using size_type = std::size_t; ///< Size type
+  using const_iterator = typename std::vector<value_type>::const_iterator; ///< Iterator type over all mappings
+
+// Structors
+public:
+  ///
+  /// Ctor.
+  ///
+  unordered_bimap() = default;
+
+  ///
+  /// Ctor.
+  /// \param init Initializer list with mappings to initialize the bimap
+  ///
+  unordered_bimap(std::initializer_list<value_type> init)
+    : unordered_bimap(std::begin(init), std::end(init))
+  {
+  }
+
+  ///
+  /// Ctor.
+  ///
+  /// \tparam InputIt Input iterator with pair like values
+  /// \param first First mapping
+  /// \param last Past the end mapping
+  ///
+  template<typename InputIt>
+  unordered_bimap(InputIt first, InputIt last)
+  {
+    for (; first != last; ++first)
+    {
+      insert(first->first, first->second);
+    }
+  }
+
+// Accessors
+public:
+  ///
+  /// Map first to second type.
+  /// \param v First type value
+  /// \return Second type value
+  ///
+  const right_type& map(const left_type& v) const
+  {
+    return map_left(v);
+  }
+
+  ///
+  /// Map second to first type.
+  /// \param v Second type value
+  /// \return First type value
+  ///
+  const left_type& map(const right_type& v) const
+  {
+    return map_right(v);
+  }
+
+  ///
+  /// Map a value comparable to the first type to the second type.
+  /// \param v Value comparable to the first type
+  /// \return Second type value
+  ///
+  template<typename K>
+  const right_type& map_left(const K& v) const
+  {
+    const auto p = find_left(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Map a value comparable to the second type to the first type.
+  /// \param v Value comparable to the second type
+  /// \return First type value
+  ///
+  template<typename K>
+  const left_type& map_right(const K& v) const
+  {
+    const auto p = find_right(v);
+    if (p == nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nomapping_exception{});
+    }
+
+    return *p;
+  }
+
+  ///
+  /// Looks up a value comparable to the first type.
+  /// \param v Value comparable to the first type
+  /// \return Pointer to the mapped second type value or nullptr if not mapped
+  ///
+  template<typename K>
+  const right_type* find_left(const K& v) const
+  {
+    const auto i = lookup<&slot::left, &slot::ltag>(LH{}(as_key<LH, left_type>(v)), [&v, this](index_type j) { return LE{}(m_values[j].first, v); });
+    return i == empty_slot ? nullptr : &m_values[i].second;
+  }
+
+  ///
+  /// Looks up a value comparable to the second type.
+  /// \param v Value comparable to the second type
+  /// \return Pointer to the mapped first type value or nullptr if not mapped
+  ///
+  template<typename K>
+  const left_type* find_right(const K& v) const
+  {
+    const auto i = lookup<&slot::right, &slot::rtag>(RH{}(as_key<RH, right_type>(v)), [&v, this](index_type j) { return RE{}(m_values[j].second, v); });
+    return i == empty_slot ? nullptr : &m_values[i].first;
+  }
+
+  ///
+  /// Returns an iterator to the first mapping, in insertion order.
+  /// \return Iterator
+  ///
+  const_iterator begin() const
+  {
+    return std::cbegin(m_values);
+  }
+
+  ///
+  /// Returns an iterator to the element following the last mapping.
+  /// \return Iterator
+  ///
+  const_iterator end() const
+  {
+    return std::cend(m_values);
+  }
+
+  ///
+  /// Returns the size of the bimap.
+  /// \return Size
+  ///
+  size_type size() const
+  {
+    return m_values.size();
+  }
+
+  ///
+  /// Says if the bimap is empty.
+  /// \return True if empty
+  ///
+  bool empty() const
+  {
+    return m_values.empty();
+  }
+
+// Modifiers
+public:
+  ///
+  /// Inserts a new mapping.
+  ///
+  /// \tparam ILT Left value type to allow perfect forwarding
+  /// \tparam IRT Right value type to allow perfect forwarding
+  /// \param ilv Left value
+  /// \param irv Right value
+  ///
+  template<typename ILT, typename IRT>
+  void insert(ILT&& ilv, IRT&& irv)
+  {
+    left_type lv{ std::forward<ILT>(ilv) };
+    right_type rv{ std::forward<IRT>(irv) };
+
+    // Check for the possibility to mess up uniqueness
+    if (find_left(lv) != nullptr || find_right(rv) != nullptr)
+    {
+      BOOST_THROW_EXCEPTION(nonuniquemapping_exception{});
+    }
+
+    if (m_values.size() >= static_cast<size_type>(std::numeric_limits<index_type>::max() - 1))
+    {
+      BOOST_THROW_EXCEPTION(std::length_error{ "unordered_bimap exceeds maximum size" });
+    }
+
+    if (2 * (m_values.size() + 1) > m_slots.size())
+    {
+      rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+    }
+
+    m_values.emplace_back(std::move(lv), std::move(rv));
+    index(static_cast<index_type>(m_values.size() - 1));
+  }
+
+  ///
+  /// Reserves space for at least \a n mappings.
+  /// \param n Number of mappings
+  ///
+  void reserve(size_type n)
+  {
+    m_values.reserve(n);
+
+    auto s = size_type{ 16 };
+    while (s < 2 * n)
+    {
+      s <<= 1;
+    }
+
+    if (s > m_slots.size())
+    {
+      rehash(s);
+    }
+  }
+
+// Operations
+public:
+  ///
+  /// Clears the bimap of all contents.
+  ///
+  void clear()
+  {
+    m_values.clear();
+    m_slots.clear();
+    m_shift = 64;
+  }
+
+// Implementation
+private:
+  using index_type = std::uint32_t; ///< Value index type
+  static constexpr index_type empty_slot = std::numeric_limits<index_type>::max(); ///< Marks an unused slot
+
+  ///
+  /// Slot of the open addressing table, indexing one value per direction.
+  ///
+  struct slot
+  {
+    index_type left = empty_slot; ///< Index of the value hashed to this slot by its left side
+    std::uint32_t ltag = 0; ///< Upper hash bits of the left side
+    index_type right = empty_slot; ///< Index of the value hashed to this slot by its right side
+    std::uint32_t rtag = 0; ///< Upper hash bits of the right side
+  };
+
+  ///
+  /// Passes a lookup value through if the hash is transparent, otherwise converts it to the key type.
+  ///
+  template<typename H, typename T, typename K>
+  static decltype(auto) as_key(const K& v)
+  {
+    if constexpr (std::is_same<K, T>::value || is_transparent<H>(0))
+    {
+      return (v);
+    }
+    else
+    {
+      return T{ v };
+    }
+  }
+
+  ///
+  /// Says if a hash function is transparent.
+  ///
+  template<typename H>
+  static constexpr bool is_transparent(typename H::is_transparent*)
+  {
+    return true;
+  }
+
+  template<typename H>
+  static constexpr bool is_transparent(...)
+  {
+    return false;
+  }
+
+  ///
+  /// Returns the first slot to probe for a hash value (Fibonacci hashing).
+  /// Spreads the hash as std::hash is the identity for integers on common implementations.
+  /// \param h Hash value
+  /// \return Slot index
+  ///
+  size_type home(std::size_t h) const noexcept
+  {
+    return static_cast<size_type>((static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ull) >> m_shift);
+  }
+
+  ///
+  /// Returns the tag stored alongside the value index to skip most key comparisons.
+  /// \param h Hash value
+  /// \return Tag
+  ///
+  static std::uint32_t tag(std::size_t h) noexcept
+  {
+    const auto h64 = static_cast<std::uint64_t>(h);
+    return static_cast<std::uint32_t>(h64 ^ (h64 >> 32));
+  }
+
+  ///
+  /// Probes one direction of the slot array.
+  ///
+  /// \tparam I Slot member holding the value index of this direction
+  /// \tparam T Slot member holding the hash tag of this direction
+  /// \param h Hash of the value to find
+  /// \param eq Says if the value with the given index equals the one to find
+  /// \return Index of the value or empty_slot
+  ///
+  template<index_type slot::*I, std::uint32_t slot::*T, typename E>
+  index_type lookup(std::size_t h, E eq) const noexcept
+  {
+    if (m_slots.empty())
+    {
+      return empty_slot;
+    }
+
+    const auto t = tag(h);
+    const auto mask = m_slots.size() - 1;
+    for (auto s = home(h);; s = (s + 1) & mask)
+    {
+      const auto& sl = m_slots[s];
+      if (sl.*I == empty_slot || (sl.*T == t && eq(sl.*I)))
+      {
+        return sl.*I;
+      }
+    }
+  }
+
+  ///
+  /// Adds a value to both directions of the slot array.
+  /// \param i Index of the value
+  ///
+  void index(index_type i)
+  {
+    const auto mask = m_slots.size() - 1;
+
+    const auto lh = LH{}(m_values[i].first);
+    for (auto s = home(lh);; s = (s + 1) & mask)
+    {
+      if (m_slots[s].left == empty_slot)
+      {
+        m_slots[s].left = i;
+        m_slots[s].ltag = tag(lh);
+        break;
+      }
+    }
+
+    const auto rh = RH{}(m_values[i].second);
+    for (auto s = home(rh);; s = (s + 1) & mask)
+    {
+      if (m_slots[s].right == empty_slot)
+      {
+        m_slots[s].right = i;
+        m_slots[s].rtag = tag(rh);
+        break;
+      }
+    }
+  }
+
+  ///
+  /// Rebuilds the slot array with a new size.
+  /// \param n New number of slots, a power of two
+  ///
+  void rehash(size_type n)
+  {
+    m_slots.assign(n, slot{});
+    m_shift = 64;
+    for (auto s = n; s > 1; s >>= 1)
+    {
+      --m_shift;
+    }
+
+    for (auto i = size_type{ 0 }; i < m_values.size(); ++i)
+    {
+      index(static_cast<index_type>(i));
+    }
+  }
+
+// Variables
+private:
+  std::vector<value_type> m_values; ///< All mappings in insertion order
+  std::vector<slot> m_slots; ///< Open addressing table for both directions
+  unsigned m_shift = 64; ///< Shift turning a mixed hash into a slot index
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_UNORDERED_BIMAP_HPP
@@ -0,0 +1,119 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#ifndef INC_ARUDE_WALK_CHECKPOINT_HPP
+#define INC_ARUDE_WALK_CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace arude
+{
+
+///
+/// Progress of a walk of the filesystem_walker, from which a later walk resumes.
+///
+/// The progress is the frontier of the walk: the directories still to be listed and those being listed, the latter with the number of
+/// entries already handled and their modification time. A directory is read in the same order again as long as it did not change, so the
+/// handled entries are skipped then, otherwise it is listed from the start.
+/// A checkpoint is saved to and loaded from a compact binary file.
+/// This class is as thread safe as a std::vector.
+///
+class walk_checkpoint final
+{
+// Typedefs
+public:
+  using size_type = std::size_t; ///< Size type
+
+  ///
+  /// Directory of the frontier.
+  ///
+  struct entry
+  {
+    std::string dir; ///< Directory path
+    std::uint64_t position; ///< Number of entries handled, 0 if not listed yet
+    std::int64_t mtime; ///< Modification time in nanoseconds since the epoch when the listing started, 0 if not listed yet
+  };
+
+// Accessors
+public:
+  ///
+  /// Returns the directories of the frontier.
+  /// \return Directories
+  ///
+  const std::vector<entry>& dirs() const;
+
+  ///
+  /// Returns the number of directories.
+  /// \return Size
+  ///
+  size_type size() const;
+
+  ///
+  /// Says if no directory is left, e.g. as the walk was done.
+  /// \return True if empty
+  ///
+  bool empty() const;
+
+  ///
+  /// Saves the checkpoint, replacing the file at once.
+  /// \param file Path of the checkpoint file
+  ///
+  void save(const std::string& file) const;
+
+// Modifiers
+public:
+  ///
+  /// Adds a directory.
+  ///
+  /// \param dir Directory path
+  /// \param position Number of entries handled
+  /// \param mtime Modification time in nanoseconds since the epoch when the listing started
+  ///
+  void add(std::string dir, std::uint64_t position = 0, std::int64_t mtime = 0);
+
+  ///
+  /// Loads a checkpoint saved before, replacing all directories.
+  /// \param file Path of the checkpoint file
+  ///
+  void load(const std::string& file);
+
+  ///
+  /// Removes all directories.
+  ///
+  void clear();
+
+// Variables
+private:
+  std::vector<entry> dirs_; ///< Directories of the frontier
+};
+
+} // namespace arude
+
+#endif // #ifndef INC_ARUDE_WALK_CHECKPOINT_HPP
@@ -0,0 +1,356 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/compact_path.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+
+namespace arude
+{
+
+compact_path::compact_path() noexcept
+  : data_{ inline_ }
+{
+  clear();
+}
+
+compact_path::compact_path(std::string_view s)
+  : compact_path{}
+{
+  assign(s);
+}
+
+compact_path::compact_path(const value_type* s)
+  : compact_path{ std::string_view{ s } }
+{
+}
+
+compact_path::compact_path(const compact_path& rhs)
+  : compact_path{}
+{
+  *this = rhs;
+}
+
+compact_path::compact_path(compact_path&& rhs) noexcept
+  : compact_path{}
+{
+  *this = std::move(rhs);
+}
+
+compact_path::~compact_path()
+{
+  if (on_heap())
+  {
+    delete[] data_;
+  }
+}
+
+compact_path& compact_path::operator=(const compact_path& rhs)
+{
+  if (this != &rhs)
+  {
+    const auto bytes = storage_size(rhs.size_, rhs.depth_);
+    reserve(bytes);
+    std::memcpy(data_, rhs.data_, bytes);
+    size_ = rhs.size_;
+    depth_ = rhs.depth_;
+    hash_ = rhs.hash_;
+  }
+
+  return *this;
+}
+
+compact_path& compact_path::operator=(compact_path&& rhs) noexcept
+{
+  if (this == &rhs)
+  {
+    return *this;
+  }
+  if (!rhs.on_heap())
+  {
+    // Fits in the inline buffer, so this never allocates
+    return *this = static_cast<const compact_path&>(rhs);
+  }
+
+  if (on_heap())
+  {
+    delete[] data_;
+  }
+  data_ = rhs.data_;
+  size_ = rhs.size_;
+  depth_ = rhs.depth_;
+  capacity_ = rhs.capacity_;
+  hash_ = rhs.hash_;
+
+  rhs.data_ = rhs.inline_;
+  rhs.capacity_ = inline_capacity;
+  rhs.clear();
+
+  return *this;
+}
+
+compact_path& compact_path::operator/=(std::string_view s)
+{
+  // Views into this path are appended to a copy, the buffer is overwritten below
+  if (s.data() >= data_ && s.data() < data_ + capacity_)
+  {
+    auto tmp = *this;
+    tmp /= s;
+    swap(tmp);
+    return *this;
+  }
+  if (!s.empty() && is_path_separator(s.front()))
+  {
+    assign(s);
+    return *this;
+  }
+
+  // Length of the joined path, a separator goes before each component unless the path is empty or only the root
+  auto size = std::size_t{ size_ };
+  auto depth = std::size_t{ depth_ };
+  for (const auto& c : path_components{ s })
+  {
+    size += (size == 0 || (size == 1 && is_absolute()) ? 0 : 1) + c.size();
+    ++depth;
+  }
+  if (depth == depth_)
+  {
+    return *this;
+  }
+
+  const auto bytes = storage_size(size, depth);
+  if (bytes > capacity_)
+  {
+    auto tmp = compact_path{};
+    tmp.reserve(bytes);
+    std::memcpy(tmp.data_, data_, storage_size(size_, depth_));
+    tmp.size_ = size_;
+    tmp.depth_ = depth_;
+    swap(tmp);
+  }
+
+  // The offsets move behind the longer string first, the string grows over their old place
+  const auto o = reinterpret_cast<size_type*>(data_ + storage_size(size, 0));
+  std::memmove(o, offsets(), depth_ * sizeof(size_type));
+  for (const auto& c : path_components{ s })
+  {
+    if (size_ != 0 && !is_path_separator(data_[size_ - 1]))
+    {
+      data_[size_++] = preferred_separator;
+    }
+    o[depth_++] = size_;
+    std::memcpy(data_ + size_, c.data(), c.size());
+    size_ += static_cast<size_type>(c.size());
+  }
+  data_[size_] = '\0';
+  rehash();
+
+  return *this;
+}
+
+std::string_view compact_path::component(size_type i) const noexcept
+{
+  const auto o = offsets();
+  const auto end = i + 1 < depth_ ? o[i + 1] - 1 : size_;
+  return { data_ + o[i], end - o[i] };
+}
+
+std::string_view compact_path::prefix(size_type n) const noexcept
+{
+  if (n == 0)
+  {
+    return { data_, is_absolute() ? std::size_t{ 1 } : std::size_t{ 0 } };
+  }
+
+  return { data_, n < depth_ ? offsets()[n] - 1 : size_ };
+}
+
+std::string_view compact_path::stem() const noexcept
+{
+  const auto f = filename();
+  const auto e = extension();
+  return f.substr(0, f.size() - e.size());
+}
+
+std::string_view compact_path::extension() const noexcept
+{
+  // Like std::filesystem, a leading dot belongs to the stem and "." and ".." have no extension
+  const auto f = filename();
+  const auto dot = f.rfind('.');
+  if (dot == std::string_view::npos || dot == 0 || f == "..")
+  {
+    return {};
+  }
+
+  return f.substr(dot);
+}
+
+int compact_path::compare(const compact_path& rhs) const noexcept
+{
+  if (is_absolute() != rhs.is_absolute())
+  {
+    return is_absolute() ? -1 : 1;
+  }
+
+  const auto n = std::min(depth_, rhs.depth_);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    const auto c = component(i).compare(rhs.component(i));
+    if (c != 0)
+    {
+      return c;
+    }
+  }
+
+  return depth_ < rhs.depth_ ? -1 : (depth_ > rhs.depth_ ? 1 : 0);
+}
+
+void compact_path::assign(std::string_view s)
+{
+  // Views into this path are assigned to a copy, the buffer is overwritten below
+  if (s.data() >= data_ && s.data() < data_ + capacity_)
+  {
+    auto tmp = compact_path{};
+    tmp.assign(s);
+    swap(tmp);
+    return;
+  }
+
+  // The normalized string is never longer than the original one
+  auto depth = std::size_t{ 0 };
+  for (const auto& c : path_components{ s })
+  {
+    static_cast<void>(c);
+    ++depth;
+  }
+  reserve(storage_size(s.size(), depth));
+
+  size_ = 0;
+  if (!s.empty() && is_path_separator(s.front()))
+  {
+    data_[size_++] = preferred_separator;
+  }
+  for (const auto& c : path_components{ s })
+  {
+    if (size_ != 0 && !is_path_separator(data_[size_ - 1]))
+    {
+      data_[size_++] = preferred_separator;
+    }
+    std::memcpy(data_ + size_, c.data(), c.size());
+    size_ += static_cast<size_type>(c.size());
+  }
+  data_[size_] = '\0';
+
+  // The offsets follow the final string
+  depth_ = static_cast<size_type>(depth);
+  auto i = size_type{ 0 };
+  for (const auto& c : path_components{ native() })
+  {
+    offsets()[i++] = static_cast<size_type>(c.data() - data_);
+  }
+  rehash();
+}
+
+void compact_path::remove_filename() noexcept
+{
+  if (depth_ == 0)
+  {
+    return;
+  }
+
+  const auto old_offsets = offsets();
+  size_ = static_cast<size_type>(prefix(depth_ - 1).size());
+  --depth_;
+  data_[size_] = '\0';
+  std::memmove(offsets(), old_offsets, depth_ * sizeof(size_type));
+  rehash();
+}
+
+void compact_path::clear() noexcept
+{
+  size_ = 0;
+  depth_ = 0;
+  data_[0] = '\0';
+  rehash();
+}
+
+void compact_path::swap(compact_path& rhs) noexcept
+{
+  auto tmp = std::move(rhs);
+  rhs = std::move(*this);
+  *this = std::move(tmp);
+}
+
+compact_path::size_type* compact_path::offsets() const noexcept
+{
+  const auto offset = storage_size(size_, 0);
+  return reinterpret_cast<size_type*>(data_ + offset);
+}
+
+std::size_t compact_path::storage_size(std::size_t size, std::size_t depth) noexcept
+{
+  // Null terminated string, padded to the alignment of the offsets
+  const auto string_size = (size + sizeof(size_type)) / sizeof(size_type) * sizeof(size_type);
+  return string_size + depth * sizeof(size_type);
+}
+
+void compact_path::reserve(std::size_t bytes)
+{
+  if (bytes <= capacity_)
+  {
+    return;
+  }
+
+  const auto capacity = std::max(bytes, 2 * std::size_t{ capacity_ });
+  const auto data = new value_type[capacity];
+  if (on_heap())
+  {
+    delete[] data_;
+  }
+  data_ = data;
+  capacity_ = static_cast<size_type>(capacity);
+}
+
+void compact_path::rehash() noexcept
+{
+  // FNV-1a
+  auto h = std::uint64_t{ 0xcbf29ce484222325ull };
+  for (const auto c : native())
+  {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  hash_ = static_cast<std::size_t>(h);
+}
+
+std::ostream& operator<<(std::ostream& os, const compact_path& p)
+{
+  return os << p.native();
+}
+
+} // namespace arude
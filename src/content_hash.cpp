@@ -0,0 +1,200 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/content_hash.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr std::uint64_t prime1 = 0x9e3779b185ebca87ull; ///< XXH64 primes
+constexpr std::uint64_t prime2 = 0xc2b2ae3d27d4eb4full;
+constexpr std::uint64_t prime3 = 0x165667b19e3779f9ull;
+constexpr std::uint64_t prime4 = 0x85ebca77c2b2ae63ull;
+constexpr std::uint64_t prime5 = 0x27d4eb2f165667c5ull;
+
+inline std::uint64_t rotl(std::uint64_t v, int r) noexcept
+{
+  return (v << r) | (v >> (64 - r));
+}
+
+inline std::uint64_t read64(const unsigned char* p) noexcept
+{
+  auto v = std::uint64_t{};
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline std::uint32_t read32(const unsigned char* p) noexcept
+{
+  auto v = std::uint32_t{};
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+///
+/// Mixes a word into an accumulator.
+///
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t v) noexcept
+{
+  return rotl(acc + v * prime2, 31) * prime1;
+}
+
+///
+/// Folds an accumulator into the hash.
+///
+inline std::uint64_t merge(std::uint64_t h, std::uint64_t acc) noexcept
+{
+  return (h ^ round(0, acc)) * prime1 + prime4;
+}
+
+///
+/// Consumes whole stripes.
+///
+/// \param acc Accumulators
+/// \param p Data
+/// \param n Number of bytes, the remainder of a stripe is left
+/// \return Pointer behind the last stripe consumed
+///
+inline const unsigned char* consume(std::uint64_t (&acc)[4], const unsigned char* p, std::size_t n) noexcept
+{
+  auto a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+  for (const auto end = p + n / 32 * 32; p != end; p += 32)
+  {
+    a0 = round(a0, read64(p));
+    a1 = round(a1, read64(p + 8));
+    a2 = round(a2, read64(p + 16));
+    a3 = round(a3, read64(p + 24));
+  }
+  acc[0] = a0;
+  acc[1] = a1;
+  acc[2] = a2;
+  acc[3] = a3;
+  return p;
+}
+
+} // namespace
+
+content_hash::content_hash(std::uint64_t seed) noexcept
+{
+  reset(seed);
+}
+
+std::uint64_t content_hash::digest() const noexcept
+{
+  auto h = std::uint64_t{};
+  if (total_ >= stripe_size)
+  {
+    h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+    for (const auto a : acc_)
+    {
+      h = merge(h, a);
+    }
+  }
+  else
+  {
+    h = seed_ + prime5;
+  }
+  h += total_;
+
+  auto p = stripe_;
+  const auto end = stripe_ + buffered_;
+  for (; p + 8 <= end; p += 8)
+  {
+    h = rotl(h ^ round(0, read64(p)), 27) * prime1 + prime4;
+  }
+  if (p + 4 <= end)
+  {
+    h = rotl(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p != end; ++p)
+  {
+    h = rotl(h ^ (*p * prime5), 11) * prime1;
+  }
+
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  return h ^ (h >> 32);
+}
+
+void content_hash::update(const void* data, size_type n) noexcept
+{
+  if (n == 0)
+  {
+    return;
+  }
+
+  auto p = static_cast<const unsigned char*>(data);
+  total_ += n;
+
+  if (buffered_ != 0)
+  {
+    const auto fill = std::min(n, stripe_size - buffered_);
+    std::memcpy(stripe_ + buffered_, p, fill);
+    buffered_ += fill;
+    p += fill;
+    n -= fill;
+    if (buffered_ != stripe_size)
+    {
+      return;
+    }
+    consume(acc_, stripe_, stripe_size);
+    buffered_ = 0;
+  }
+
+  const auto rest = consume(acc_, p, n);
+  buffered_ = n - static_cast<size_type>(rest - p);
+  std::memcpy(stripe_, rest, buffered_);
+}
+
+void content_hash::reset(std::uint64_t seed) noexcept
+{
+  seed_ = seed;
+  acc_[0] = seed + prime1 + prime2;
+  acc_[1] = seed + prime2;
+  acc_[2] = seed;
+  acc_[3] = seed - prime1;
+  total_ = 0;
+  buffered_ = 0;
+}
+
+std::uint64_t content_hash::of(const void* data, size_type n, std::uint64_t seed) noexcept
+{
+  auto h = content_hash{ seed };
+  h.update(data, n);
+  return h.digest();
+}
+
+} // namespace arude
@@ -0,0 +1,295 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/directory_reader.hpp>
+
+#if defined(ARUDE_DIRECTORY_READER_GETDENTS)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace arude
+{
+
+#if defined(ARUDE_DIRECTORY_READER_GETDENTS)
+
+namespace
+{
+
+///
+/// Record of getdents64, declared by the kernel only.
+///
+struct linux_dirent64
+{
+  ino64_t d_ino;
+  off64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+
+///
+/// Maps a d_type to a file type.
+/// \param type d_type
+/// \return File type
+///
+directory_reader::file_type to_file_type(unsigned char type)
+{
+  switch (type)
+  {
+  case DT_DIR:
+    return directory_reader::file_type::directory;
+  case DT_REG:
+    return directory_reader::file_type::regular;
+  case DT_LNK:
+    return directory_reader::file_type::symlink;
+  default:
+    return directory_reader::file_type::other;
+  }
+}
+
+///
+/// Converts the result of a stat call.
+///
+/// \param st stat result
+/// \param out Receives the metadata
+///
+void to_metadata(const struct stat& st, file_metadata& out)
+{
+  out.size = static_cast<std::uint64_t>(st.st_size);
+  out.mtime = std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(
+    std::chrono::seconds{ st.st_mtim.tv_sec } + std::chrono::nanoseconds{ st.st_mtim.tv_nsec }) };
+  out.inode = st.st_ino;
+  out.valid = true;
+}
+
+} // namespace
+
+directory_reader::directory_reader()
+  : buffer_{ new char[buffer_size] }
+{
+}
+
+directory_reader::~directory_reader()
+{
+  close();
+}
+
+bool directory_reader::status(file_metadata& out) const
+{
+  struct stat st;
+  out = file_metadata{};
+  if (fd_ < 0 || ::fstat(fd_, &st) != 0)
+  {
+    return false;
+  }
+
+  to_metadata(st, out);
+  return true;
+}
+
+bool directory_reader::status(const entry& e, file_metadata& out) const
+{
+  // Entry names are null terminated in the getdents64 buffer
+  struct stat st;
+  out = file_metadata{};
+  if (fd_ < 0 || ::fstatat(fd_, e.name.data(), &st, AT_SYMLINK_NOFOLLOW) != 0)
+  {
+    return false;
+  }
+
+  to_metadata(st, out);
+  return true;
+}
+
+directory_reader::size_type directory_reader::bytes_read() const noexcept
+{
+  return bytes_;
+}
+
+bool directory_reader::open(std::string_view path)
+{
+  close();
+  path_.assign(path);
+  bytes_ = 0;
+  fd_ = ::openat(AT_FDCWD, path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  return fd_ >= 0;
+}
+
+bool directory_reader::next(entry& e)
+{
+  for (;;)
+  {
+    if (offset_ == size_)
+    {
+      const auto n = ::syscall(SYS_getdents64, fd_, buffer_.get(), buffer_size);
+      if (n <= 0)
+      {
+        return false;
+      }
+      offset_ = 0;
+      size_ = static_cast<size_type>(n);
+      bytes_ += size_;
+    }
+
+    const auto d = reinterpret_cast<const linux_dirent64*>(buffer_.get() + offset_);
+    offset_ += d->d_reclen;
+    const auto name = std::string_view{ d->d_name };
+    if (name == "." || name == "..")
+    {
+      continue;
+    }
+
+    // Not every filesystem fills in d_type
+    auto type = d->d_type;
+    if (type == DT_UNKNOWN)
+    {
+      struct stat st;
+      if (::fstatat(fd_, d->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+      {
+        continue;
+      }
+      type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : (S_ISLNK(st.st_mode) ? DT_LNK : DT_UNKNOWN));
+    }
+
+    e.name = name;
+    e.type = to_file_type(type);
+    return true;
+  }
+}
+
+void directory_reader::close() noexcept
+{
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  offset_ = 0;
+  size_ = 0;
+}
+
+#else
+
+directory_reader::directory_reader()
+{
+}
+
+directory_reader::~directory_reader()
+{
+}
+
+namespace
+{
+
+///
+/// Reads the metadata of a path.
+///
+/// \param p Path
+/// \param out Receives the metadata
+/// \return False if the metadata can't be read
+///
+bool read_status(const boost::filesystem::path& p, file_metadata& out)
+{
+  namespace fs = boost::filesystem;
+
+  auto ec = boost::system::error_code{};
+  const auto status = fs::symlink_status(p, ec);
+  out = file_metadata{};
+  if (ec || !fs::exists(status))
+  {
+    return false;
+  }
+
+  out.size = fs::is_regular_file(status) ? fs::file_size(p, ec) : 0;
+  out.mtime = std::chrono::system_clock::from_time_t(fs::last_write_time(p, ec));
+  out.valid = !ec;
+  return out.valid;
+}
+
+} // namespace
+
+bool directory_reader::status(file_metadata& out) const
+{
+  return read_status(boost::filesystem::path{ path_ }, out);
+}
+
+bool directory_reader::status(const entry& e, file_metadata& out) const
+{
+  return read_status(boost::filesystem::path{ path_ } / std::string{ e.name }, out);
+}
+
+directory_reader::size_type directory_reader::bytes_read() const noexcept
+{
+  return bytes_;
+}
+
+bool directory_reader::open(std::string_view path)
+{
+  path_.assign(path);
+  bytes_ = 0;
+  auto ec = boost::system::error_code{};
+  iter_ = boost::filesystem::directory_iterator{ boost::filesystem::path{ path_ }, boost::filesystem::directory_options::skip_permission_denied, ec };
+  return !ec;
+}
+
+bool directory_reader::next(entry& e)
+{
+  namespace fs = boost::filesystem;
+
+  auto ec = boost::system::error_code{};
+  if (iter_ == fs::directory_iterator{})
+  {
+    return false;
+  }
+
+  const auto status = iter_->symlink_status(ec);
+  name_ = iter_->path().filename().string();
+  bytes_ += name_.size();
+  e.name = name_;
+  e.type = fs::is_directory(status) ? file_type::directory :
+    (fs::is_regular_file(status) ? file_type::regular : (fs::is_symlink(status) ? file_type::symlink : file_type::other));
+
+  iter_.increment(ec);
+  if (ec)
+  {
+    iter_ = fs::directory_iterator{};
+  }
+  return true;
+}
+
+void directory_reader::close() noexcept
+{
+  iter_ = boost::filesystem::directory_iterator{};
+}
+
+#endif
+
+} // namespace arude
@@ -0,0 +1,145 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/directory_snapshot.hpp>
+
+#include <libarude/detail/binary_io.hpp>
+
+#include <iterator>
+#include <utility>
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr detail::binary_file format{ "Snapshot", { 'A', 'R', 'D', 'S' }, 1 }; ///< Snapshot file format
+
+} // namespace
+
+const directory_snapshot::record* directory_snapshot::find(const std::string& dir) const
+{
+  const auto iter = records_.find(dir);
+  return iter == std::end(records_) ? nullptr : &iter->second;
+}
+
+directory_snapshot::size_type directory_snapshot::size() const
+{
+  return records_.size();
+}
+
+bool directory_snapshot::empty() const
+{
+  return records_.empty();
+}
+
+void directory_snapshot::save(const std::string& file) const
+{
+  detail::save(format, file, [this](std::ostream& os)
+  {
+    using detail::write;
+    write(os, static_cast<std::uint64_t>(records_.size()));
+    for (const auto& i : records_)
+    {
+      write(os, i.first);
+      write(os, i.second.inode);
+      write(os, i.second.mtime);
+      write(os, static_cast<std::uint32_t>(i.second.entries.size()));
+      for (const auto& j : i.second.entries)
+      {
+        write(os, j.name);
+        write(os, static_cast<std::uint8_t>(j.type));
+        if (j.type == entry_type::file)
+        {
+          write(os, j.size);
+          write(os, j.mtime);
+        }
+      }
+    }
+  });
+}
+
+void directory_snapshot::insert(std::string dir, record r)
+{
+  records_[std::move(dir)] = std::move(r);
+}
+
+void directory_snapshot::retain(const std::unordered_set<std::string_view>& dirs)
+{
+  for (auto iter = std::begin(records_); iter != std::end(records_);)
+  {
+    iter = dirs.count(iter->first) == 0 ? records_.erase(iter) : std::next(iter);
+  }
+}
+
+void directory_snapshot::erase(const std::string& dir)
+{
+  records_.erase(dir);
+}
+
+void directory_snapshot::load(const std::string& file)
+{
+  using detail::read;
+  auto is = detail::open(format, file);
+  auto records = decltype(records_){};
+  for (auto n = read<std::uint64_t>(format, is); n > 0; --n)
+  {
+    auto dir = detail::read_string(format, is);
+    auto r = record{};
+    r.inode = read<std::uint64_t>(format, is);
+    r.mtime = read<std::int64_t>(format, is);
+    r.entries.resize(read<std::uint32_t>(format, is));
+    for (auto& i : r.entries)
+    {
+      i.name = detail::read_string(format, is);
+      const auto type = read<std::uint8_t>(format, is);
+      if (type > static_cast<std::uint8_t>(entry_type::directory))
+      {
+        format.fail("has an unknown format.");
+      }
+      i.type = static_cast<entry_type>(type);
+      i.size = i.type == entry_type::file ? read<std::uint64_t>(format, is) : 0;
+      i.mtime = i.type == entry_type::file ? read<std::int64_t>(format, is) : 0;
+    }
+    records.emplace(std::move(dir), std::move(r));
+  }
+
+  records_.swap(records);
+}
+
+void directory_snapshot::clear()
+{
+  records_.clear();
+}
+
+void directory_snapshot::swap(directory_snapshot& rhs) noexcept
+{
+  records_.swap(rhs.records_);
+}
+
+} // namespace arude
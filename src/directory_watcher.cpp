@@ -0,0 +1,225 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/directory_watcher.hpp>
+
+#if defined(ARUDE_DIRECTORY_WATCHER_INOTIFY)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <thread>
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr std::size_t buffer_size = 64 * 1024; ///< Bytes of events read at once
+
+} // namespace
+
+#if defined(ARUDE_DIRECTORY_WATCHER_INOTIFY)
+
+directory_watcher::directory_watcher()
+  : fd_{ ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) }
+  , buffer_{ new char[buffer_size] }
+{
+}
+
+directory_watcher::~directory_watcher()
+{
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+  }
+}
+
+bool directory_watcher::available() const noexcept
+{
+  return fd_ >= 0;
+}
+
+std::size_t directory_watcher::size() const
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  return dirs_.size();
+}
+
+bool directory_watcher::add(std::string_view dir)
+{
+  if (fd_ < 0)
+  {
+    return false;
+  }
+
+  // Adding a watch again for the same inode returns the same descriptor, so a moved directory gets its new path
+  const auto path = std::string{ dir };
+  const auto wd = ::inotify_add_watch(fd_, path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_MODIFY |
+    IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK);
+  if (wd < 0)
+  {
+    return false;
+  }
+
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  auto& former = dirs_[wd];
+  if (former != path)
+  {
+    wds_.erase(former);
+    former = path;
+    wds_[path] = wd;
+  }
+  return true;
+}
+
+void directory_watcher::remove(std::string_view dir)
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  const auto iter = wds_.find(std::string{ dir });
+  if (iter != std::end(wds_))
+  {
+    ::inotify_rm_watch(fd_, iter->second);
+    dirs_.erase(iter->second);
+    wds_.erase(iter);
+  }
+}
+
+bool directory_watcher::read(std::vector<event>& out, std::chrono::milliseconds timeout)
+{
+  out.clear();
+  if (fd_ < 0)
+  {
+    std::this_thread::sleep_for(timeout);
+    return false;
+  }
+
+  auto pfd = pollfd{ fd_, POLLIN, 0 };
+  if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0)
+  {
+    return false;
+  }
+
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  for (;;)
+  {
+    const auto n = ::read(fd_, buffer_.get(), buffer_size);
+    if (n <= 0)
+    {
+      break;
+    }
+
+    for (auto offset = ssize_t{ 0 }; offset < n;)
+    {
+      const auto e = reinterpret_cast<const inotify_event*>(buffer_.get() + offset);
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + e->len);
+
+      if ((e->mask & IN_Q_OVERFLOW) != 0)
+      {
+        out.push_back(event{ {}, {}, event_type::overflow, false });
+        continue;
+      }
+
+      const auto iter = dirs_.find(e->wd);
+      if (iter == std::end(dirs_))
+      {
+        continue;
+      }
+
+      // The path may be watched again already, for a directory created in place of the removed one
+      if ((e->mask & IN_IGNORED) != 0)
+      {
+        const auto path = wds_.find(iter->second);
+        if (path != std::end(wds_) && path->second == e->wd)
+        {
+          wds_.erase(path);
+        }
+        dirs_.erase(iter);
+        continue;
+      }
+
+      // A moved directory is watched again under its new path when found there
+      if ((e->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+      {
+        out.push_back(event{ iter->second, {}, event_type::removed, true });
+        if ((e->mask & IN_MOVE_SELF) != 0)
+        {
+          ::inotify_rm_watch(fd_, e->wd);
+        }
+        continue;
+      }
+
+      const auto type = (e->mask & (IN_CREATE | IN_MOVED_TO)) != 0 ? event_type::created :
+        ((e->mask & (IN_DELETE | IN_MOVED_FROM)) != 0 ? event_type::removed : event_type::modified);
+      out.push_back(event{ iter->second, e->len > 0 ? std::string{ e->name } : std::string{}, type, (e->mask & IN_ISDIR) != 0 });
+    }
+  }
+
+  return !out.empty();
+}
+
+#else
+
+directory_watcher::directory_watcher()
+{
+}
+
+directory_watcher::~directory_watcher()
+{
+}
+
+bool directory_watcher::available() const noexcept
+{
+  return false;
+}
+
+std::size_t directory_watcher::size() const
+{
+  return 0;
+}
+
+bool directory_watcher::add(std::string_view)
+{
+  return false;
+}
+
+void directory_watcher::remove(std::string_view)
+{
+}
+
+bool directory_watcher::read(std::vector<event>& out, std::chrono::milliseconds timeout)
+{
+  out.clear();
+  std::this_thread::sleep_for(timeout);
+  return false;
+}
+
+#endif
+
+} // namespace arude
@@ -0,0 +1,610 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/duplicate_finder.hpp>
+
+#include <libarude/content_hash.hpp>
+#include <libarude/metadata_fetcher.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#include <fstream>
+#endif
+
+
+namespace arude
+{
+
+namespace
+{
+
+///
+/// File opened for reading.
+///
+class input_file final : noncopyable
+{
+public:
+  ///
+  /// Ctor, opens the file.
+  ///
+  /// \param path Path of the file
+  /// \param sequential True if the file is read from the start to the end
+  ///
+  input_file(const std::string& path, bool sequential)
+  {
+#if defined(__linux__)
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    struct stat st;
+    if (fd_ < 0 || ::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      return;
+    }
+    size_ = static_cast<std::uint64_t>(st.st_size);
+    device_ = static_cast<std::uint64_t>(st.st_dev);
+    inode_ = static_cast<std::uint64_t>(st.st_ino);
+    if (sequential)
+    {
+      ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#else
+    static_cast<void>(sequential);
+    is_.open(path, std::ios::binary | std::ios::ate);
+    if (is_)
+    {
+      size_ = static_cast<std::uint64_t>(is_.tellg());
+    }
+#endif
+  }
+
+#if defined(__linux__)
+  ~input_file()
+  {
+    if (fd_ >= 0)
+    {
+      ::close(fd_);
+    }
+  }
+#endif
+
+  ///
+  /// Returns the size of the file.
+  /// \return Size, all bits set if the file can't be read
+  ///
+  std::uint64_t size() const noexcept
+  {
+    return size_;
+  }
+
+  ///
+  /// Returns the device of the file.
+  /// \return Device number, 0 where unknown
+  ///
+  std::uint64_t device() const noexcept
+  {
+    return device_;
+  }
+
+  ///
+  /// Returns the inode of the file.
+  /// \return Inode number, 0 where unknown
+  ///
+  std::uint64_t inode() const noexcept
+  {
+    return inode_;
+  }
+
+  ///
+  /// Reads at a position until \a n bytes are read or the end is reached.
+  ///
+  /// \param offset Position to read at
+  /// \param buffer Buffer to read into
+  /// \param n Bytes to read
+  /// \return Bytes read, less than \a n on the end or an error
+  ///
+  std::size_t read(std::uint64_t offset, unsigned char* buffer, std::size_t n)
+  {
+    auto done = std::size_t{ 0 };
+#if defined(__linux__)
+    while (done < n)
+    {
+      const auto r = ::pread(fd_, buffer + done, n - done, static_cast<off_t>(offset + done));
+      if (r <= 0)
+      {
+        if (r < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        break;
+      }
+      done += static_cast<std::size_t>(r);
+    }
+#else
+    if (is_.seekg(static_cast<std::streamoff>(offset)))
+    {
+      is_.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(n));
+      done = static_cast<std::size_t>(is_.gcount());
+      is_.clear();
+    }
+#endif
+    return done;
+  }
+
+private:
+  std::uint64_t size_ = ~std::uint64_t{}; ///< Size of the file
+  std::uint64_t device_ = 0; ///< Device number of the file
+  std::uint64_t inode_ = 0; ///< Inode number of the file
+#if defined(__linux__)
+  int fd_ = -1; ///< File descriptor
+#else
+  std::ifstream is_; ///< Stream reading the file
+#endif
+};
+
+///
+/// Runs work items on a pool of threads.
+///
+/// \param threads Number of threads, the calling thread works alone if 1
+/// \param n Number of work items
+/// \param governor Governor whose I/O priority the threads take, may be nullptr
+/// \param f Function taking the index of a work item and two buffers reused by the thread
+///
+template<typename F>
+void parallel(std::size_t threads, std::size_t n, const io_governor* governor, F f)
+{
+  auto next = std::atomic<std::size_t>{ 0 };
+  const auto work = [&next, n, governor, &f]
+  {
+    if (governor != nullptr)
+    {
+      governor->enter_thread();
+    }
+
+    auto buffer = std::vector<unsigned char>{};
+    auto reference = std::vector<unsigned char>{};
+    for (auto i = next++; i < n; i = next++)
+    {
+      f(i, buffer, reference);
+    }
+  };
+
+  threads = std::min(std::max(threads, std::size_t{ 1 }), n);
+  if (threads <= 1)
+  {
+    work();
+    return;
+  }
+
+  auto pool = std::vector<std::thread>{};
+  for (auto i = std::size_t{ 0 }; i < threads; ++i)
+  {
+    pool.emplace_back(work);
+  }
+  for (auto& t : pool)
+  {
+    t.join();
+  }
+}
+
+} // namespace
+
+duplicate_finder::duplicate_finder()
+  : duplicate_finder{ options{} }
+{
+}
+
+duplicate_finder::duplicate_finder(options o)
+  : options_{ std::move(o) }
+{
+}
+
+duplicate_finder::size_type duplicate_finder::size() const
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  return files_.size();
+}
+
+std::uint64_t duplicate_finder::bytes_read() const noexcept
+{
+  return bytes_;
+}
+
+void duplicate_finder::add(std::string path, std::uint64_t size)
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  files_.push_back({ std::move(path), size, 0, 0, 0 });
+}
+
+void duplicate_finder::add(std::string path)
+{
+  add(std::move(path), unknown_size);
+}
+
+void duplicate_finder::clear()
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  files_.clear();
+}
+
+std::vector<duplicate_finder::group_type> duplicate_finder::find()
+{
+  bytes_ = 0;
+  fetch_sizes();
+
+  auto files = std::vector<candidate>{};
+  std::copy_if(files_.begin(), files_.end(), std::back_inserter(files),
+    [this](const candidate& c) { return c.size != unknown_size && c.size >= options_.min_size; });
+  keep_twins(files);
+
+  hash(files, false);
+  keep_twins(files);
+  drop_links(files);
+  keep_twins(files);
+
+  // Files read whole by the edge hash are done, the others are hashed whole unless compared byte for byte anyway, which would read them twice
+  if (!options_.verify)
+  {
+    const auto whole = std::stable_partition(files.begin(), files.end(),
+      [this](const candidate& c) { return c.size <= 2 * static_cast<std::uint64_t>(options_.edge_size); });
+    auto large = std::vector<candidate>{ std::make_move_iterator(whole), std::make_move_iterator(files.end()) };
+    files.erase(whole, files.end());
+    hash(large, true);
+    keep_twins(large);
+    std::move(large.begin(), large.end(), std::back_inserter(files));
+  }
+
+  auto candidates = std::vector<std::vector<candidate>>{};
+  for (auto i = files.begin(); i != files.end();)
+  {
+    const auto j = std::find_if(i, files.end(), [i](const candidate& c) { return c.size != i->size || c.hash != i->hash; });
+    candidates.emplace_back(std::make_move_iterator(i), std::make_move_iterator(j));
+    i = j;
+  }
+
+  // Equal hashes are confirmed byte for byte
+  auto confirmed = std::vector<std::vector<group_type>>(candidates.size());
+  if (options_.verify)
+  {
+    parallel(options_.threads, candidates.size(), options_.governor.get(),
+      [this, &candidates, &confirmed](size_type i, std::vector<unsigned char>& buffer, std::vector<unsigned char>& reference)
+      {
+        confirmed[i] = confirm(candidates[i], buffer, reference);
+      });
+  }
+  else
+  {
+    for (auto i = size_type{ 0 }; i < candidates.size(); ++i)
+    {
+      auto g = group_type{};
+      std::transform(candidates[i].begin(), candidates[i].end(), std::back_inserter(g), [](candidate& c) { return std::move(c.path); });
+      confirmed[i].push_back(std::move(g));
+    }
+  }
+
+  auto groups = std::vector<group_type>{};
+  for (auto& i : confirmed)
+  {
+    std::move(i.begin(), i.end(), std::back_inserter(groups));
+  }
+  std::sort(groups.begin(), groups.end());
+  return groups;
+}
+
+void duplicate_finder::fetch_sizes()
+{
+  auto paths = std::vector<std::string>{};
+  auto unknown = std::vector<candidate*>{};
+  for (auto& c : files_)
+  {
+    if (c.size == unknown_size)
+    {
+      paths.push_back(c.path);
+      unknown.push_back(&c);
+    }
+  }
+  if (paths.empty())
+  {
+    return;
+  }
+
+  auto md = std::vector<file_metadata>(paths.size());
+  metadata_fetcher{}.fetch(paths.data(), paths.size(), md.data());
+  for (auto i = size_type{ 0 }; i < unknown.size(); ++i)
+  {
+    if (md[i].valid)
+    {
+      unknown[i]->size = md[i].size;
+    }
+  }
+}
+
+void duplicate_finder::keep_twins(std::vector<candidate>& files)
+{
+  std::sort(files.begin(), files.end(),
+    [](const candidate& a, const candidate& b) { return std::tie(a.size, a.hash, a.path) < std::tie(b.size, b.hash, b.path); });
+
+  auto out = files.begin();
+  for (auto i = files.begin(); i != files.end();)
+  {
+    const auto j = std::find_if(i, files.end(), [i](const candidate& c) { return c.size != i->size || c.hash != i->hash; });
+    if (j - i > 1)
+    {
+      out = out == i ? j : std::move(i, j, out);
+    }
+    i = j;
+  }
+  files.erase(out, files.end());
+}
+
+void duplicate_finder::drop_links(std::vector<candidate>& files)
+{
+  auto seen = std::set<std::pair<std::uint64_t, std::uint64_t>>{};
+  auto out = files.begin();
+  for (auto i = files.begin(); i != files.end();)
+  {
+    const auto j = std::find_if(i, files.end(), [i](const candidate& c) { return c.size != i->size || c.hash != i->hash; });
+    seen.clear();
+    for (auto k = i; k != j; ++k)
+    {
+      if (k->inode == 0 || seen.emplace(k->device, k->inode).second)
+      {
+        if (out != k)
+        {
+          *out = std::move(*k);
+        }
+        ++out;
+      }
+    }
+    i = j;
+  }
+  files.erase(out, files.end());
+}
+
+void duplicate_finder::hash(std::vector<candidate>& files, bool whole)
+{
+  auto failed = std::vector<char>(files.size(), 0);
+  parallel(options_.threads, files.size(), options_.governor.get(),
+    [this, &files, &failed, whole](size_type i, std::vector<unsigned char>& buffer, std::vector<unsigned char>&)
+    {
+      failed[i] = !(whole ? hash_whole(files[i], buffer) : hash_edges(files[i], buffer));
+    });
+
+  auto out = size_type{ 0 };
+  for (auto i = size_type{ 0 }; i < files.size(); ++i)
+  {
+    if (!failed[i])
+    {
+      if (out != i)
+      {
+        files[out] = std::move(files[i]);
+      }
+      ++out;
+    }
+  }
+  files.resize(out);
+}
+
+bool duplicate_finder::hash_edges(candidate& c, std::vector<unsigned char>& buffer)
+{
+  auto f = input_file{ c.path, false };
+  if (f.size() != c.size)
+  {
+    return false;
+  }
+
+  // Files not larger than both edges are read whole
+  const auto edge = static_cast<std::uint64_t>(options_.edge_size);
+  const auto n = static_cast<size_type>(std::min(c.size, 2 * edge));
+  buffer.resize(n);
+  auto done = size_type{ 0 };
+  if (c.size <= 2 * edge)
+  {
+    done = f.read(0, buffer.data(), n);
+  }
+  else
+  {
+    done = f.read(0, buffer.data(), n / 2);
+    done += f.read(c.size - edge, buffer.data() + n / 2, n / 2);
+  }
+  charge(done);
+  if (done != n)
+  {
+    return false;
+  }
+
+  c.hash = content_hash::of(buffer.data(), n);
+  c.device = f.device();
+  c.inode = f.inode();
+  return true;
+}
+
+bool duplicate_finder::hash_whole(candidate& c, std::vector<unsigned char>& buffer)
+{
+  auto f = input_file{ c.path, true };
+  if (f.size() != c.size)
+  {
+    return false;
+  }
+
+  buffer.resize(std::max(options_.buffer_size, size_type{ 1 }));
+  auto h = content_hash{};
+  auto offset = std::uint64_t{ 0 };
+  while (offset < c.size)
+  {
+    const auto n = f.read(offset, buffer.data(), static_cast<size_type>(std::min<std::uint64_t>(buffer.size(), c.size - offset)));
+    charge(n);
+    if (n == 0)
+    {
+      return false;
+    }
+    h.update(buffer.data(), n);
+    offset += n;
+  }
+
+  c.hash = h.digest();
+  return true;
+}
+
+std::vector<duplicate_finder::group_type> duplicate_finder::confirm(std::vector<candidate>& group, std::vector<unsigned char>& buffer,
+  std::vector<unsigned char>& reference)
+{
+  // Groups of files equal up to an offset. Files differing from the reference in the same block are equal up to it and are compared on from
+  // there, those differing in other blocks differ from each other, so no part of a file is read again but the blocks where groups split.
+  auto retval = std::vector<group_type>{};
+  auto pending = std::vector<std::pair<std::uint64_t, std::vector<candidate>>>{};
+  pending.emplace_back(0, std::move(group));
+  while (!pending.empty())
+  {
+    const auto offset = pending.back().first;
+    auto files = std::move(pending.back().second);
+    pending.pop_back();
+    if (files.size() < 2)
+    {
+      continue;
+    }
+
+    // The first file is the reference, the others are compared with it a bounded number at once
+    auto same = group_type{ files.front().path };
+    auto differing = std::vector<std::pair<std::uint64_t, candidate>>{};
+    auto readable = true;
+    for (auto first = size_type{ 1 }; readable && first < files.size(); first += compare_fanout)
+    {
+      const auto last = std::min(files.size(), first + compare_fanout);
+      readable = compare(files.front(), offset, files.data() + first, last - first, same, differing, buffer, reference);
+    }
+
+    if (!readable)
+    {
+      files.erase(files.begin());
+      pending.emplace_back(offset, std::move(files));
+      continue;
+    }
+    if (same.size() > 1)
+    {
+      retval.push_back(std::move(same));
+    }
+
+    std::stable_sort(std::begin(differing), std::end(differing), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto iter = std::begin(differing); iter != std::end(differing);)
+    {
+      auto split = std::vector<candidate>{};
+      const auto at = iter->first;
+      for (; iter != std::end(differing) && iter->first == at; ++iter)
+      {
+        split.push_back(std::move(iter->second));
+      }
+      pending.emplace_back(at, std::move(split));
+    }
+  }
+
+  return retval;
+}
+
+bool duplicate_finder::compare(const candidate& ref, std::uint64_t start, const candidate* files, size_type n, group_type& same,
+  std::vector<std::pair<std::uint64_t, candidate>>& differing, std::vector<unsigned char>& buffer, std::vector<unsigned char>& reference)
+{
+  auto r = input_file{ ref.path, true };
+  if (r.size() != ref.size)
+  {
+    return false;
+  }
+
+  // Files which can't be read or changed size are left out
+  auto opened = std::vector<std::unique_ptr<input_file>>{};
+  auto members = std::vector<const candidate*>{};
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    auto f = std::make_unique<input_file>(files[i].path, true);
+    if (f->size() == files[i].size)
+    {
+      opened.push_back(std::move(f));
+      members.push_back(files + i);
+    }
+  }
+
+  const auto size = std::max(options_.buffer_size, size_type{ 1 });
+  buffer.resize(size);
+  reference.resize(size);
+  for (auto offset = start; offset < ref.size && !members.empty();)
+  {
+    const auto chunk = static_cast<size_type>(std::min<std::uint64_t>(size, ref.size - offset));
+    const auto read = r.read(offset, reference.data(), chunk);
+    charge(read);
+    if (read != chunk)
+    {
+      return false;
+    }
+
+    for (auto i = size_type{ 0 }; i < members.size();)
+    {
+      const auto got = opened[i]->read(offset, buffer.data(), chunk);
+      charge(got);
+      if (got != chunk || std::memcmp(buffer.data(), reference.data(), chunk) != 0)
+      {
+        if (got == chunk)
+        {
+          differing.emplace_back(offset, *members[i]);
+        }
+        opened.erase(opened.begin() + static_cast<std::ptrdiff_t>(i));
+        members.erase(members.begin() + static_cast<std::ptrdiff_t>(i));
+        continue;
+      }
+      ++i;
+    }
+    offset += chunk;
+  }
+
+  for (const auto i : members)
+  {
+    same.push_back(i->path);
+  }
+  return true;
+}
+
+void duplicate_finder::charge(std::uint64_t bytes)
+{
+  bytes_ += bytes;
+  if (options_.governor)
+  {
+    std::this_thread::sleep_for(options_.governor->charge(0, 0, bytes));
+  }
+}
+
+} // namespace arude
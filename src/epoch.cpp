@@ -0,0 +1,177 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/epoch.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+
+namespace arude
+{
+
+struct epoch_domain::reader
+{
+  slot* s = nullptr; ///< Claimed slot, claimed on first use
+  unsigned depth = 0; ///< Nesting depth of critical sections
+
+  ~reader()
+  {
+    if (s != nullptr)
+    {
+      s->epoch.store(0, std::memory_order_release);
+      s->claimed.store(false, std::memory_order_release);
+    }
+  }
+};
+
+epoch_domain::epoch_domain()
+  : epoch_{ 1 }
+  , used_{ 0 }
+  , slots_{ std::make_unique<slot[]>(max_readers) }
+{
+}
+
+epoch_domain::~epoch_domain()
+{
+  for (const auto& i : retired_)
+  {
+    i.deleter(i.p);
+  }
+}
+
+epoch_domain& epoch_domain::global()
+{
+  static epoch_domain domain;
+  return domain;
+}
+
+void epoch_domain::enter() noexcept
+{
+  auto& r = local();
+  if (r.depth++ != 0)
+  {
+    return;
+  }
+
+  if (r.s == nullptr)
+  {
+    r.s = claim();
+  }
+
+  // The fence orders the announcement before any load of a published pointer, see retire
+  r.s->epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void epoch_domain::leave() noexcept
+{
+  auto& r = local();
+  if (--r.depth == 0)
+  {
+    r.s->epoch.store(0, std::memory_order_release);
+  }
+}
+
+void epoch_domain::retire(void* p, void (*deleter)(void*))
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+
+  // Readers announcing a later epoch entered after the pointer to p was replaced
+  retired_.push_back(retired{ p, deleter, epoch_.fetch_add(1, std::memory_order_seq_cst) });
+  reclaim();
+}
+
+void epoch_domain::synchronize()
+{
+  for (;;)
+  {
+    {
+      std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+      reclaim();
+      if (retired_.empty())
+      {
+        return;
+      }
+    }
+
+    std::this_thread::yield();
+  }
+}
+
+epoch_domain::slot* epoch_domain::claim() noexcept
+{
+  for (;;)
+  {
+    for (auto i = std::size_t{ 0 }; i < max_readers; ++i)
+    {
+      auto expected = false;
+      if (!slots_[i].claimed.load(std::memory_order_relaxed) && slots_[i].claimed.compare_exchange_strong(expected, true))
+      {
+        // Raise the scan bound to cover this slot
+        auto used = used_.load();
+        while (used < i + 1 && !used_.compare_exchange_weak(used, i + 1))
+        {
+        }
+
+        return &slots_[i];
+      }
+    }
+
+    // All slots taken, wait for a thread to exit
+    std::this_thread::yield();
+  }
+}
+
+void epoch_domain::reclaim()
+{
+  auto oldest = std::numeric_limits<std::uint64_t>::max();
+  const auto used = used_.load(std::memory_order_seq_cst);
+  for (auto i = std::size_t{ 0 }; i < used; ++i)
+  {
+    const auto e = slots_[i].epoch.load(std::memory_order_seq_cst);
+    if (e != 0)
+    {
+      oldest = std::min(oldest, e);
+    }
+  }
+
+  const auto iter = std::partition(std::begin(retired_), std::end(retired_), [oldest](const retired& r) { return r.epoch >= oldest; });
+  for (auto i = iter; i != std::end(retired_); ++i)
+  {
+    i->deleter(i->p);
+  }
+  retired_.erase(iter, std::end(retired_));
+}
+
+epoch_domain::reader& epoch_domain::local() noexcept
+{
+  thread_local reader r;
+  return r;
+}
+
+} // namespace arude
@@ -0,0 +1,150 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/io_governor.hpp>
+
+#include <algorithm>
+
+#if defined(ARUDE_IO_GOVERNOR_IOPRIO)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr auto backoff_min = std::chrono::nanoseconds{ std::chrono::milliseconds{ 1 } }; ///< Backoff delay when backing off starts
+constexpr auto backoff_max = std::chrono::nanoseconds{ std::chrono::seconds{ 1 } }; ///< Longest backoff delay
+
+#if defined(ARUDE_IO_GOVERNOR_IOPRIO)
+// Declared by the kernel headers only since Linux 6.0
+constexpr int ioprio_who_process = 1; ///< IOPRIO_WHO_PROCESS
+constexpr int ioprio_class_idle = 3; ///< IOPRIO_CLASS_IDLE
+constexpr int ioprio_class_shift = 13; ///< IOPRIO_CLASS_SHIFT
+#endif
+
+} // namespace
+
+io_governor::io_governor(const limits& l)
+  : limits_{ l }
+  , last_{ clock::now() }
+  , dirs_{ l.dirs_per_second, l.burst }
+  , entries_{ l.entries_per_second, l.burst }
+  , bytes_{ l.bytes_per_second, l.burst }
+{
+}
+
+const io_governor::limits& io_governor::get_limits() const noexcept
+{
+  return limits_;
+}
+
+std::chrono::nanoseconds io_governor::latency() const
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  return latency_;
+}
+
+std::chrono::nanoseconds io_governor::backoff() const
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  return backoff_;
+}
+
+std::chrono::nanoseconds io_governor::charge(std::uint64_t dirs, std::uint64_t entries, std::uint64_t bytes)
+{
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  const auto now = clock::now();
+  const auto elapsed = std::chrono::duration<double>{ now - last_ }.count();
+  last_ = now;
+
+  const auto wait = std::max({ dirs_.take(static_cast<double>(dirs), elapsed), entries_.take(static_cast<double>(entries), elapsed),
+    bytes_.take(static_cast<double>(bytes), elapsed) });
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{ wait }) + (dirs > 0 ? backoff_ : std::chrono::nanoseconds{ 0 });
+}
+
+void io_governor::measured(std::chrono::nanoseconds latency)
+{
+  if (limits_.latency_target.count() == 0)
+  {
+    return;
+  }
+
+  // Smoothed like the round trip time of TCP, a single slow call does not back off
+  std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+  latency_ = latency_.count() == 0 ? latency : latency_ + (latency - latency_) / 8;
+  if (latency_ > limits_.latency_target)
+  {
+    backoff_ = std::min(std::max(backoff_ * 2, backoff_min), backoff_max);
+  }
+  else
+  {
+    backoff_ -= backoff_ / 8;
+    if (backoff_ < backoff_min / 8)
+    {
+      backoff_ = std::chrono::nanoseconds{ 0 };
+    }
+  }
+}
+
+bool io_governor::enter_thread() const
+{
+  if (!limits_.idle_priority)
+  {
+    return true;
+  }
+
+#if defined(ARUDE_IO_GOVERNOR_IOPRIO)
+  // Who 0 is the calling thread
+  return ::syscall(SYS_ioprio_set, ioprio_who_process, 0, ioprio_class_idle << ioprio_class_shift) == 0;
+#else
+  return false;
+#endif
+}
+
+io_governor::bucket::bucket(double r, std::chrono::milliseconds burst)
+  : rate{ r }
+  , capacity{ std::max(r * std::chrono::duration<double>{ burst }.count(), 1.0) }
+  , tokens{ capacity }
+{
+}
+
+double io_governor::bucket::take(double n, double elapsed)
+{
+  if (rate <= 0)
+  {
+    return 0;
+  }
+
+  tokens = std::min(tokens + rate * elapsed, capacity) - n;
+  return tokens < 0 ? -tokens / rate : 0;
+}
+
+} // namespace arude
@@ -0,0 +1,425 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/metadata_fetcher.hpp>
+
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#else
+#include <boost/filesystem/operations.hpp>
+#endif
+
+#include <algorithm>
+
+
+namespace arude
+{
+
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+
+namespace
+{
+
+///
+/// Converts the result of statx.
+///
+/// \param st statx result
+/// \param out Receives the metadata
+///
+void to_metadata(const struct statx& st, file_metadata& out)
+{
+  out.size = st.stx_size;
+  out.mtime = std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(
+    std::chrono::seconds{ st.stx_mtime.tv_sec } + std::chrono::nanoseconds{ st.stx_mtime.tv_nsec }) };
+  out.inode = st.stx_ino;
+  out.valid = true;
+}
+
+} // namespace
+
+///
+/// Submission and completion queues of an io_uring, mapped from the kernel.
+///
+struct metadata_fetcher::ring
+{
+  ///
+  /// Ctor.
+  /// \param entries Number of submission queue entries
+  ///
+  explicit ring(unsigned entries)
+  {
+    auto p = io_uring_params{};
+    fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd < 0)
+    {
+      return;
+    }
+
+    // Both queues share one mapping on all kernels supporting statx, older ones are not used anyway
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) == 0)
+    {
+      return;
+    }
+    sq_size = std::max(sq_size, cq_size);
+    sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED)
+    {
+      sq_ptr = nullptr;
+      return;
+    }
+    sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+    {
+      sqes = nullptr;
+      return;
+    }
+
+    const auto base = static_cast<char*>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned*>(base + p.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(base + p.sq_off.array);
+    cq_head = reinterpret_cast<unsigned*>(base + p.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(base + p.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned*>(base + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(base + p.cq_off.cqes);
+  }
+
+  ~ring()
+  {
+    if (sqes != nullptr)
+    {
+      ::munmap(sqes, sqes_size);
+    }
+    if (sq_ptr != nullptr)
+    {
+      ::munmap(sq_ptr, sq_size);
+    }
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+  }
+
+  ///
+  /// Says if the ring was set up.
+  /// \return True if usable
+  ///
+  bool valid() const noexcept
+  {
+    return sqes != nullptr;
+  }
+
+  int fd = -1; ///< Ring file descriptor
+  void* sq_ptr = nullptr; ///< Mapping of both queues
+  std::size_t sq_size = 0; ///< Size of the queue mapping
+  std::size_t cq_size = 0; ///< Size of the completion queue
+  io_uring_sqe* sqes = nullptr; ///< Submission queue entries
+  std::size_t sqes_size = 0; ///< Size of the submission queue entries mapping
+  unsigned* sq_tail = nullptr; ///< Submission queue tail, written by us
+  unsigned sq_mask = 0; ///< Submission queue mask
+  unsigned* sq_array = nullptr; ///< Submission queue index array
+  unsigned* cq_head = nullptr; ///< Completion queue head, written by us
+  unsigned* cq_tail = nullptr; ///< Completion queue tail, written by the kernel
+  unsigned cq_mask = 0; ///< Completion queue mask
+  io_uring_cqe* cqes = nullptr; ///< Completion queue entries
+  std::vector<struct statx> results; ///< statx results of the current batch
+};
+
+#endif
+
+metadata_fetcher::metadata_fetcher(size_type queue_depth, size_type threads, backend b)
+  : queue_depth_{ std::max(queue_depth, size_type{ 1 }) }
+  , thread_count_{ threads }
+{
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+  if (b == backend::automatic)
+  {
+    ring_.reset(new ring{ static_cast<unsigned>(queue_depth_) });
+    if (!ring_->valid())
+    {
+      ring_.reset();
+    }
+  }
+#else
+  static_cast<void>(b);
+#endif
+}
+
+metadata_fetcher::~metadata_fetcher()
+{
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    shutdown_ = true;
+  }
+  work_condition_.notify_all();
+  for (auto& i : threads_)
+  {
+    i.join();
+  }
+}
+
+bool metadata_fetcher::uses_io_uring() const noexcept
+{
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+  return ring_ != nullptr;
+#else
+  return false;
+#endif
+}
+
+void metadata_fetcher::fetch(const std::string* paths, size_type n, file_metadata* out)
+{
+  if (n == 0)
+  {
+    return;
+  }
+
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+  if (ring_)
+  {
+    if (fetch_ring(paths, n, out))
+    {
+      return;
+    }
+
+    // The kernel has io_uring but not its statx operation
+    ring_.reset();
+  }
+#endif
+
+  fetch_pool(paths, n, out);
+}
+
+#if defined(ARUDE_METADATA_FETCHER_IO_URING)
+
+bool metadata_fetcher::fetch_ring(const std::string* paths, size_type n, file_metadata* out)
+{
+  auto& r = *ring_;
+  r.results.resize(n);
+
+  auto supported = true;
+  auto submitted = size_type{ 0 };
+  auto completed = size_type{ 0 };
+  auto unsubmitted = 0u;
+  while (completed < n)
+  {
+    // Keep the queue filled
+    auto tail = *r.sq_tail;
+    for (; submitted < n && submitted - completed < queue_depth_; ++submitted, ++tail, ++unsubmitted)
+    {
+      const auto index = tail & r.sq_mask;
+      auto& sqe = r.sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_STATX;
+      sqe.fd = AT_FDCWD;
+      sqe.addr = reinterpret_cast<std::uintptr_t>(paths[submitted].c_str());
+      sqe.len = STATX_SIZE | STATX_MTIME | STATX_INO;
+      sqe.off = reinterpret_cast<std::uintptr_t>(&r.results[submitted]);
+      sqe.statx_flags = AT_SYMLINK_NOFOLLOW;
+      sqe.user_data = submitted;
+      r.sq_array[index] = index;
+    }
+    __atomic_store_n(r.sq_tail, tail, __ATOMIC_RELEASE);
+
+    const auto ret = ::syscall(__NR_io_uring_enter, r.fd, unsubmitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+      {
+        continue;
+      }
+      // Requests already submitted still complete into the results, so they must be reaped before giving up
+      supported = false;
+      break;
+    }
+    unsubmitted -= static_cast<unsigned>(ret);
+
+    // Reap all completions
+    auto head = *r.cq_head;
+    for (; head != __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE); ++head, ++completed)
+    {
+      const auto& cqe = r.cqes[head & r.cq_mask];
+      const auto i = static_cast<size_type>(cqe.user_data);
+      if (cqe.res == 0)
+      {
+        to_metadata(r.results[i], out[i]);
+      }
+      else
+      {
+        out[i] = file_metadata{};
+        supported = supported && cqe.res != -EINVAL;
+      }
+    }
+    __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  if (!supported && completed < n)
+  {
+    // Wait for the requests in flight, their buffers must stay valid
+    while (completed < submitted - unsubmitted)
+    {
+      if (::syscall(__NR_io_uring_enter, r.fd, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+      {
+        break;
+      }
+      auto head = *r.cq_head;
+      for (; head != __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE); ++head, ++completed)
+      {
+      }
+      __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+    }
+  }
+
+  return supported;
+}
+
+void metadata_fetcher::read(const std::string& path, file_metadata& out)
+{
+  struct statx st;
+  if (::statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW, STATX_SIZE | STATX_MTIME | STATX_INO, &st) == 0)
+  {
+    to_metadata(st, out);
+  }
+  else
+  {
+    out = file_metadata{};
+  }
+}
+
+#else
+
+void metadata_fetcher::read(const std::string& path, file_metadata& out)
+{
+  namespace fs = boost::filesystem;
+
+  auto ec = boost::system::error_code{};
+  const auto p = fs::path{ path };
+  const auto status = fs::symlink_status(p, ec);
+  out = file_metadata{};
+  if (ec || !fs::exists(status))
+  {
+    return;
+  }
+
+  out.size = fs::is_regular_file(status) ? fs::file_size(p, ec) : 0;
+  out.mtime = std::chrono::system_clock::from_time_t(fs::last_write_time(p, ec));
+  out.valid = !ec;
+}
+
+#endif
+
+void metadata_fetcher::fetch_pool(const std::string* paths, size_type n, file_metadata* out)
+{
+  if (thread_count_ == 0)
+  {
+    for (auto i = size_type{ 0 }; i < n; ++i)
+    {
+      read(paths[i], out[i]);
+    }
+    return;
+  }
+
+  if (threads_.empty())
+  {
+    for (auto i = size_type{ 0 }; i < thread_count_; ++i)
+    {
+      threads_.emplace_back([this] { work(); });
+    }
+  }
+
+  {
+    std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+    paths_ = paths;
+    out_ = out;
+    size_ = n;
+    next_ = 0;
+    done_ = 0;
+    ++generation_;
+  }
+  work_condition_.notify_all();
+
+  // All threads must have left the batch, else a late one could take a path of the next batch with the pointers of this one
+  std::unique_lock<decltype(mtx_)> lock{ mtx_ };
+  done_condition_.wait(lock, [this] { return done_ == size_ && active_ == 0; });
+
+  // A thread waking only now must not join the batch, its arrays belong to the caller again
+  paths_ = nullptr;
+  out_ = nullptr;
+  size_ = 0;
+}
+
+void metadata_fetcher::work()
+{
+  for (auto seen = std::uint64_t{ 0 };;)
+  {
+    const std::string* paths = nullptr;
+    file_metadata* out = nullptr;
+    auto n = size_type{ 0 };
+    {
+      std::unique_lock<decltype(mtx_)> lock{ mtx_ };
+      work_condition_.wait(lock, [this, seen] { return shutdown_ || generation_ != seen; });
+      if (shutdown_)
+      {
+        return;
+      }
+      seen = generation_;
+      if (size_ == 0)
+      {
+        continue;
+      }
+      paths = paths_;
+      out = out_;
+      n = size_;
+      ++active_;
+    }
+
+    auto count = size_type{ 0 };
+    for (auto i = next_++; i < n; i = next_++, ++count)
+    {
+      read(paths[i], out[i]);
+    }
+
+    {
+      std::lock_guard<decltype(mtx_)> lock{ mtx_ };
+      done_ += count;
+      --active_;
+    }
+    done_condition_.notify_one();
+  }
+}
+
+} // namespace arude
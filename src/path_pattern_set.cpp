@@ -0,0 +1,429 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/path_pattern_set.hpp>
+
+#include <libarude/path_components.hpp>
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <stdexcept>
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr auto max_states = std::size_t{ 1 } << 16; ///< Limit of states per automaton
+
+///
+/// Token of a component glob.
+///
+struct glob_token
+{
+  bool star; ///< Matches any number of characters
+  std::bitset<256> chars; ///< Characters matched if not a star
+};
+
+///
+/// Parses a component glob.
+/// \param g Component glob
+/// \return Tokens
+///
+std::vector<glob_token> parse_glob(std::string_view g)
+{
+  auto retval = std::vector<glob_token>{};
+  for (auto i = std::size_t{ 0 }; i < g.size(); ++i)
+  {
+    auto t = glob_token{ false, {} };
+    const auto c = static_cast<unsigned char>(g[i]);
+    if (c == '*')
+    {
+      if (retval.empty() || !retval.back().star)
+      {
+        retval.push_back(glob_token{ true, {} });
+      }
+      continue;
+    }
+    else if (c == '?')
+    {
+      t.chars.set();
+    }
+    else if (c == '\\' && i + 1 < g.size())
+    {
+      t.chars.set(static_cast<unsigned char>(g[++i]));
+    }
+    else if (c == '[' && g.find(']', i + 2) != std::string_view::npos)
+    {
+      const auto end = g.find(']', i + 2);
+      auto j = i + 1;
+      const auto negate = g[j] == '!' || g[j] == '^';
+      if (negate)
+      {
+        ++j;
+      }
+      for (; j < end; ++j)
+      {
+        const auto first = static_cast<unsigned char>(g[j]);
+        if (j + 2 < end && g[j + 1] == '-')
+        {
+          for (auto k = unsigned{ first }; k <= static_cast<unsigned char>(g[j + 2]); ++k)
+          {
+            t.chars.set(k);
+          }
+          j += 2;
+        }
+        else
+        {
+          t.chars.set(first);
+        }
+      }
+      if (negate)
+      {
+        t.chars.flip();
+      }
+      i = end;
+    }
+    else
+    {
+      t.chars.set(c);
+    }
+    retval.push_back(t);
+  }
+
+  return retval;
+}
+
+///
+/// Subset construction helper, assigns ids to sorted sets of NFA positions.
+///
+class state_sets final
+{
+public:
+  ///
+  /// Returns the id of a set, adding it if new.
+  /// \param s Sorted set
+  /// \return Id
+  ///
+  std::uint32_t intern(std::vector<std::uint32_t> s)
+  {
+    const auto iter = ids_.find(s);
+    if (iter != std::end(ids_))
+    {
+      return iter->second;
+    }
+    if (sets_.size() >= max_states)
+    {
+      throw std::length_error{ "path_pattern_set automaton too large." };
+    }
+
+    const auto id = static_cast<std::uint32_t>(sets_.size());
+    sets_.push_back(s);
+    ids_.emplace(std::move(s), id);
+    return id;
+  }
+
+  std::size_t size() const
+  {
+    return sets_.size();
+  }
+
+  const std::vector<std::uint32_t>& operator[](std::size_t i) const
+  {
+    return sets_[i];
+  }
+
+private:
+  std::map<std::vector<std::uint32_t>, std::uint32_t> ids_; ///< Ids by set
+  std::vector<std::vector<std::uint32_t>> sets_; ///< Sets by id
+};
+
+///
+/// Sorts and deduplicates a set of positions.
+/// \param s Set
+/// \return Normalized set
+///
+std::vector<std::uint32_t> normalized(std::vector<std::uint32_t> s)
+{
+  std::sort(std::begin(s), std::end(s));
+  s.erase(std::unique(std::begin(s), std::end(s)), std::end(s));
+  return s;
+}
+
+///
+/// Positions of patterns over items, used for both automatons.
+/// An item either consumes one symbol if it matches, or is a star consuming any number of symbols.
+///
+/// \tparam I Item type
+///
+template<typename I>
+struct nfa
+{
+  std::vector<const I*> items; ///< Item at each position, nullptr for final positions
+  std::vector<std::uint32_t> starts; ///< First position of each sequence
+
+  ///
+  /// Adds a sequence of items.
+  /// \param seq Items
+  ///
+  void add(const std::vector<I>& seq)
+  {
+    starts.push_back(static_cast<std::uint32_t>(items.size()));
+    for (const auto& i : seq)
+    {
+      items.push_back(&i);
+    }
+    items.push_back(nullptr);
+  }
+
+  ///
+  /// Adds the positions reachable by skipping stars.
+  /// \param s Set
+  /// \return Closed set
+  ///
+  std::vector<std::uint32_t> closure(std::vector<std::uint32_t> s) const
+  {
+    for (auto i = std::size_t{ 0 }; i < s.size(); ++i)
+    {
+      if (items[s[i]] != nullptr && items[s[i]]->star)
+      {
+        s.push_back(s[i] + 1);
+      }
+    }
+    return normalized(std::move(s));
+  }
+
+  ///
+  /// Moves a set of positions over a symbol.
+  /// \param s Set
+  /// \param match Says if a non star item matches the symbol
+  /// \return Closed set
+  ///
+  template<typename F>
+  std::vector<std::uint32_t> step(const std::vector<std::uint32_t>& s, F match) const
+  {
+    auto retval = std::vector<std::uint32_t>{};
+    for (const auto i : s)
+    {
+      if (items[i] == nullptr)
+      {
+        continue;
+      }
+      if (items[i]->star)
+      {
+        retval.push_back(i);
+      }
+      else if (match(*items[i]))
+      {
+        retval.push_back(i + 1);
+      }
+    }
+    return closure(std::move(retval));
+  }
+};
+
+///
+/// Item of a path pattern.
+///
+struct path_item
+{
+  bool star; ///< "**", matches any number of components
+  std::uint32_t glob; ///< Component glob if not a star
+};
+
+} // namespace
+
+
+path_pattern_set::path_pattern_set()
+{
+  compile();
+}
+
+bool path_pattern_set::matches(std::string_view p) const noexcept
+{
+  auto s = path_start_;
+  for (const auto& i : path_components{ p })
+  {
+    auto c = component_start_;
+    for (const auto ch : i)
+    {
+      c = component_dfa_[c * 256 + static_cast<unsigned char>(ch)];
+    }
+
+    s = path_dfa_[s * classes_ + component_class_[c]];
+    if (path_accept_[s])
+    {
+      return true;
+    }
+    if (s == 0)
+    {
+      return false;
+    }
+  }
+
+  return path_accept_[s];
+}
+
+const path_pattern_set::pattern_list_type& path_pattern_set::patterns() const
+{
+  return patterns_;
+}
+
+path_pattern_set::size_type path_pattern_set::size() const
+{
+  return patterns_.size();
+}
+
+bool path_pattern_set::empty() const
+{
+  return patterns_.empty();
+}
+
+void path_pattern_set::add(std::string_view pattern)
+{
+  add(&pattern, &pattern + 1);
+}
+
+void path_pattern_set::clear()
+{
+  patterns_.clear();
+  compile();
+}
+
+void path_pattern_set::append(std::string_view pattern)
+{
+  const auto components = path_components{ pattern };
+  if (std::begin(components) == std::end(components))
+  {
+    throw std::invalid_argument{ "Path pattern has no components." };
+  }
+
+  patterns_.emplace_back(pattern);
+}
+
+void path_pattern_set::compile()
+{
+  // Split the patterns into items and collect the distinct component globs
+  auto glob_ids = std::map<std::string_view, std::uint32_t>{};
+  auto globs = std::vector<std::vector<glob_token>>{};
+  auto sequences = std::vector<std::vector<path_item>>{};
+  for (const auto& i : patterns_)
+  {
+    auto seq = std::vector<path_item>{};
+    if (!is_path_separator(i.front()))
+    {
+      seq.push_back(path_item{ true, 0 });
+    }
+    for (const auto& c : path_components{ i })
+    {
+      if (c == "**")
+      {
+        if (seq.empty() || !seq.back().star)
+        {
+          seq.push_back(path_item{ true, 0 });
+        }
+        continue;
+      }
+
+      const auto iter = glob_ids.emplace(c, static_cast<std::uint32_t>(globs.size())).first;
+      if (iter->second == globs.size())
+      {
+        globs.push_back(parse_glob(c));
+      }
+      seq.push_back(path_item{ false, iter->second });
+    }
+    sequences.push_back(std::move(seq));
+  }
+
+  // Component DFA over characters, each state gets the class of the globs accepted in it
+  auto glob_nfa = nfa<glob_token>{};
+  for (const auto& i : globs)
+  {
+    glob_nfa.add(i);
+  }
+  auto glob_of = std::vector<std::uint32_t>(glob_nfa.items.size());
+  for (auto g = std::size_t{ 0 }; g < globs.size(); ++g)
+  {
+    std::fill(std::begin(glob_of) + glob_nfa.starts[g], std::begin(glob_of) + glob_nfa.starts[g] + globs[g].size() + 1, g);
+  }
+
+  auto component_sets = state_sets{};
+  auto classes = state_sets{};
+  component_sets.intern({});
+  component_start_ = component_sets.intern(glob_nfa.closure(glob_nfa.starts));
+  classes.intern({});
+  component_dfa_.clear();
+  component_class_.clear();
+  for (auto i = std::size_t{ 0 }; i < component_sets.size(); ++i)
+  {
+    const auto s = component_sets[i];
+    auto accepted = std::vector<std::uint32_t>{};
+    for (const auto p : s)
+    {
+      if (glob_nfa.items[p] == nullptr)
+      {
+        accepted.push_back(glob_of[p]);
+      }
+    }
+    component_class_.push_back(classes.intern(normalized(std::move(accepted))));
+
+    for (auto ch = 0u; ch < 256; ++ch)
+    {
+      component_dfa_.push_back(component_sets.intern(glob_nfa.step(s, [ch](const glob_token& t) { return t.chars[ch]; })));
+    }
+  }
+  classes_ = static_cast<std::uint32_t>(classes.size());
+
+  // Path DFA over component classes
+  auto path_nfa = nfa<path_item>{};
+  for (const auto& i : sequences)
+  {
+    path_nfa.add(i);
+  }
+
+  auto path_sets = state_sets{};
+  path_sets.intern({});
+  path_start_ = path_sets.intern(path_nfa.closure(path_nfa.starts));
+  path_dfa_.clear();
+  path_accept_.clear();
+  for (auto i = std::size_t{ 0 }; i < path_sets.size(); ++i)
+  {
+    const auto s = path_sets[i];
+    path_accept_.push_back(std::any_of(std::begin(s), std::end(s), [&path_nfa](std::uint32_t p) { return path_nfa.items[p] == nullptr; }));
+
+    for (auto k = std::size_t{ 0 }; k < classes_; ++k)
+    {
+      const auto& matched = classes[k];
+      path_dfa_.push_back(path_sets.intern(path_nfa.step(s,
+        [&matched](const path_item& t) { return std::binary_search(std::begin(matched), std::end(matched), t.glob); })));
+    }
+  }
+}
+
+} // namespace arude
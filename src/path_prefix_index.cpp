@@ -0,0 +1,315 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/path_prefix_index.hpp>
+
+#include <libarude/path_components.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARUDE_PATH_PREFIX_INDEX_SSE2
+#endif
+
+
+namespace arude
+{
+
+void path_prefix_index::lookup_n(const std::string_view* in, const root_id* roots, size_type n, mark* out) const
+{
+  // All keys of the batch in one buffer
+  auto buffer = std::string{};
+  auto offsets = std::vector<size_type>(n + 1);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    offsets[i] = buffer.size();
+    append_key(roots == nullptr ? 0 : roots[i], in[i], buffer);
+  }
+  offsets[n] = buffer.size();
+
+  auto keys = std::vector<std::string_view>(n);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    keys[i] = std::string_view{ buffer }.substr(offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  auto order = std::vector<size_type>(n);
+  std::iota(std::begin(order), std::end(order), size_type{ 0 });
+  const auto comp = [&keys](size_type a, size_type b) { return keys[a] < keys[b]; };
+  if (!std::is_sorted(std::begin(order), std::end(order), comp))
+  {
+    std::sort(std::begin(order), std::end(order), comp);
+  }
+
+  merge(keys, order, out);
+}
+
+void path_prefix_index::resolve_n(const std::string_view* in, size_type n, mark* out) const
+{
+  // Full keys first, sorted they are merged against the sorted roots
+  auto buffer = std::string{};
+  auto offsets = std::vector<size_type>(n + 1);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    offsets[i] = buffer.size();
+    append_key(in[i], buffer);
+  }
+  offsets[n] = buffer.size();
+
+  const auto key = [&buffer, &offsets](size_type i) { return std::string_view{ buffer }.substr(offsets[i], offsets[i + 1] - offsets[i]); };
+  auto order = std::vector<size_type>(n);
+  std::iota(std::begin(order), std::end(order), size_type{ 0 });
+  const auto comp = [&key](size_type a, size_type b) { return key(a) < key(b); };
+  if (!std::is_sorted(std::begin(order), std::end(order), comp))
+  {
+    std::sort(std::begin(order), std::end(order), comp);
+  }
+
+  // The stack holds the roots above the current path, the deepest on top. The root id replaces the root part of the key.
+  auto rooted = std::string{};
+  auto rooted_offsets = std::vector<size_type>(n);
+  auto rooted_sizes = std::vector<size_type>(n);
+  auto path_roots = std::vector<root_id>(n);
+  auto parents = std::vector<size_type>{};
+  auto j = size_type{ 0 };
+  for (const auto i : order)
+  {
+    const auto k = key(i);
+    while (!parents.empty() && !starts_with(k, roots_[parents.back()].key))
+    {
+      parents.pop_back();
+    }
+    for (; j < roots_.size() && std::string_view{ roots_[j].key } <= k; ++j)
+    {
+      if (starts_with(k, roots_[j].key))
+      {
+        parents.push_back(j);
+      }
+    }
+
+    const auto skip = parents.empty() ? size_type{ 0 } : roots_[parents.back()].key.size();
+    path_roots[i] = parents.empty() ? 0 : roots_[parents.back()].root;
+    rooted_offsets[i] = rooted.size();
+    append_key(path_roots[i], {}, rooted);
+    rooted.append(k.data() + skip, k.size() - skip);
+    rooted_sizes[i] = rooted.size() - rooted_offsets[i];
+  }
+
+  auto keys = std::vector<std::string_view>(n);
+  for (auto i = size_type{ 0 }; i < n; ++i)
+  {
+    keys[i] = std::string_view{ rooted }.substr(rooted_offsets[i], rooted_sizes[i]);
+  }
+
+  // Paths of one root keep their order relative to each other, as their keys share the root part
+  std::stable_sort(std::begin(order), std::end(order), [&path_roots](size_type a, size_type b) { return path_roots[a] < path_roots[b]; });
+  merge(keys, order, out);
+}
+
+path_prefix_index::size_type path_prefix_index::size() const
+{
+  return entries_.size();
+}
+
+void path_prefix_index::append_key(std::string_view p, std::string& out)
+{
+  for (const auto& i : path_components{ p })
+  {
+    out.append(i.data(), i.size());
+    out.push_back('/');
+  }
+}
+
+void path_prefix_index::append_key(root_id root, std::string_view p, std::string& out)
+{
+  // Big endian, so keys of one root stay together in order
+  for (auto shift = 24; shift >= 0; shift -= 8)
+  {
+    out.push_back(static_cast<char>((root >> shift) & 0xff));
+  }
+  append_key(p, out);
+}
+
+void path_prefix_index::assign(const std::vector<marked_path>& paths)
+{
+  entries_.clear();
+  entries_.reserve(paths.size());
+  for (const auto& i : paths)
+  {
+    auto k = std::string{};
+    append_key(i.root, i.path, k);
+    entries_.push_back(entry{ std::move(k), i.m });
+  }
+
+  // Keep the last entry of equal keys
+  std::stable_sort(std::begin(entries_), std::end(entries_), [](const entry& a, const entry& b) { return a.key < b.key; });
+  auto last = std::end(entries_);
+  if (!entries_.empty())
+  {
+    auto out = std::begin(entries_);
+    for (auto iter = std::next(std::begin(entries_)); iter != std::end(entries_); ++iter)
+    {
+      if (iter->key != out->key)
+      {
+        ++out;
+      }
+      if (out != iter)
+      {
+        *out = std::move(*iter);
+      }
+    }
+    last = std::next(out);
+  }
+  entries_.erase(std::remove_if(std::begin(entries_), last, [](const entry& e) { return e.m == mark::none; }), std::end(entries_));
+}
+
+void path_prefix_index::assign_roots(const std::vector<std::string_view>& roots)
+{
+  roots_.clear();
+  roots_.reserve(roots.size());
+  for (auto i = size_type{ 0 }; i < roots.size(); ++i)
+  {
+    auto k = std::string{};
+    append_key(roots[i], k);
+    roots_.push_back(root_entry{ std::move(k), static_cast<root_id>(i + 1) });
+  }
+  std::sort(std::begin(roots_), std::end(roots_), [](const root_entry& a, const root_entry& b) { return a.key < b.key; });
+}
+
+void path_prefix_index::set_root(root_id root, std::string_view p)
+{
+  const auto iter = std::find_if(std::begin(roots_), std::end(roots_), [root](const root_entry& e) { return e.root == root; });
+  if (iter != std::end(roots_))
+  {
+    roots_.erase(iter);
+  }
+
+  auto k = std::string{};
+  append_key(p, k);
+  const auto pos = std::upper_bound(std::begin(roots_), std::end(roots_), k, [](const std::string& v, const root_entry& e) { return v < e.key; });
+  roots_.insert(pos, root_entry{ std::move(k), root });
+}
+
+void path_prefix_index::set(std::string_view p, mark m, root_id root)
+{
+  auto k = std::string{};
+  append_key(root, p, k);
+
+  const auto iter = std::lower_bound(std::begin(entries_), std::end(entries_), k, [](const entry& e, const std::string& v) { return e.key < v; });
+  if (iter != std::end(entries_) && iter->key == k)
+  {
+    if (m == mark::none)
+    {
+      entries_.erase(iter);
+    }
+    else
+    {
+      iter->m = m;
+    }
+  }
+  else if (m != mark::none)
+  {
+    entries_.insert(iter, entry{ std::move(k), m });
+  }
+}
+
+void path_prefix_index::clear_below(std::string_view p)
+{
+  clear_below(p, mark::none);
+}
+
+void path_prefix_index::clear_below(std::string_view p, mark m, root_id root)
+{
+  auto k = std::string{};
+  append_key(root, p, k);
+
+  // The sub paths directly follow the path
+  auto first = std::upper_bound(std::begin(entries_), std::end(entries_), k, [](const std::string& v, const entry& e) { return v < e.key; });
+  auto last = first;
+  while (last != std::end(entries_) && starts_with(last->key, k))
+  {
+    ++last;
+  }
+
+  entries_.erase(std::remove_if(first, last, [m](const entry& e) { return m == mark::none || e.m == m; }), last);
+}
+
+void path_prefix_index::clear()
+{
+  entries_.clear();
+  roots_.clear();
+}
+
+void path_prefix_index::merge(const std::vector<std::string_view>& keys, const std::vector<size_type>& order, mark* out) const
+{
+  // The stack holds the marked parents of the current path, the deepest on top
+  auto parents = std::vector<size_type>{};
+  auto j = size_type{ 0 };
+  for (const auto i : order)
+  {
+    const auto k = keys[i];
+    while (!parents.empty() && !starts_with(k, entries_[parents.back()].key))
+    {
+      parents.pop_back();
+    }
+    for (; j < entries_.size() && std::string_view{ entries_[j].key } <= k; ++j)
+    {
+      if (starts_with(k, entries_[j].key))
+      {
+        parents.push_back(j);
+      }
+    }
+
+    out[i] = parents.empty() ? mark::none : entries_[parents.back()].m;
+  }
+}
+
+bool path_prefix_index::starts_with(std::string_view s, std::string_view prefix) noexcept
+{
+  if (prefix.size() > s.size())
+  {
+    return false;
+  }
+
+  auto i = size_type{ 0 };
+#if defined(ARUDE_PATH_PREFIX_INDEX_SSE2)
+  for (; i + 16 <= prefix.size(); i += 16)
+  {
+    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + i));
+    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prefix.data() + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff)
+    {
+      return false;
+    }
+  }
+#endif
+  return std::memcmp(s.data() + i, prefix.data() + i, prefix.size() - i) == 0;
+}
+
+} // namespace arude
@@ -0,0 +1,333 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/path_trie.hpp>
+
+#include <libarude/path_components.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+
+namespace arude
+{
+
+path_trie::path_trie()
+{
+  clear();
+}
+
+path_trie::mark path_trie::lookup(std::string_view p, node_id from) const noexcept
+{
+  auto retval = nodes_[from].m;
+  auto n = from;
+  for (const auto& i : path_components{ p })
+  {
+    n = child(n, i);
+    if (n == npos)
+    {
+      break;
+    }
+    if (nodes_[n].m != mark::none)
+    {
+      retval = nodes_[n].m;
+    }
+  }
+
+  return retval;
+}
+
+path_trie::node_id path_trie::find(std::string_view p, node_id from) const noexcept
+{
+  auto n = from;
+  for (const auto& i : path_components{ p })
+  {
+    n = child(n, i);
+    if (n == npos)
+    {
+      break;
+    }
+  }
+
+  return n;
+}
+
+path_trie::node_id path_trie::child(node_id parent, std::string_view name) const noexcept
+{
+  const auto h = hash(parent, name);
+  const auto mask = slots_.size() - 1;
+  for (auto s = home(h);; s = (s + 1) & mask)
+  {
+    const auto n = slots_[s];
+    if (n == npos)
+    {
+      return npos;
+    }
+
+    const auto& c = nodes_[n];
+    if (c.hash == h && c.parent == parent && std::string_view{ names_.data() + c.name_offset, c.name_size } == name)
+    {
+      return n;
+    }
+  }
+}
+
+path_trie::mark path_trie::node_mark(node_id n) const noexcept
+{
+  return nodes_[n].m;
+}
+
+std::vector<path_trie::node_id> path_trie::marked_subtree(node_id n) const
+{
+  auto retval = std::vector<node_id>{};
+  if (nodes_[n].m != mark::none)
+  {
+    retval.push_back(n);
+  }
+
+  // Pre order through the child, sibling and parent links like clear_subtree()
+  auto i = nodes_[n].first_child;
+  while (i != npos)
+  {
+    if (nodes_[i].m != mark::none)
+    {
+      retval.push_back(i);
+    }
+
+    if (nodes_[i].first_child != npos)
+    {
+      i = nodes_[i].first_child;
+      continue;
+    }
+    while (i != n && nodes_[i].next_sibling == npos)
+    {
+      i = nodes_[i].parent;
+    }
+    i = i == n ? npos : nodes_[i].next_sibling;
+  }
+
+  return retval;
+}
+
+path_trie::size_type path_trie::size() const
+{
+  return nodes_.size();
+}
+
+path_trie::node_id path_trie::insert(std::string_view p, node_id from)
+{
+  auto n = from;
+  for (const auto& i : path_components{ p })
+  {
+    const auto c = child(n, i);
+    n = c == npos ? add_child(n, i) : c;
+  }
+
+  return n;
+}
+
+void path_trie::set(std::string_view p, mark m, node_id from)
+{
+  nodes_[insert(p, from)].m = m;
+}
+
+void path_trie::clear_below(std::string_view p)
+{
+  clear_below(p, mark::none);
+}
+
+void path_trie::clear_below(std::string_view p, mark m, node_id from)
+{
+  const auto n = find(p, from);
+  if (n != npos)
+  {
+    clear_subtree(n, m);
+  }
+}
+
+void path_trie::prune(node_id n)
+{
+  const auto mask = slots_.size() - 1;
+  while (n != root && nodes_[n].parent != npos && nodes_[n].m == mark::none && nodes_[n].first_child == npos)
+  {
+    // Unlink from the children of the parent
+    const auto parent = nodes_[n].parent;
+    auto* link = &nodes_[parent].first_child;
+    while (*link != n)
+    {
+      link = &nodes_[*link].next_sibling;
+    }
+    *link = nodes_[n].next_sibling;
+
+    // Remove from the hash table, the following nodes of the cluster move back into the hole unless it lies before their home slot
+    auto hole = home(nodes_[n].hash);
+    while (slots_[hole] != n)
+    {
+      hole = (hole + 1) & mask;
+    }
+    for (auto s = (hole + 1) & mask; slots_[s] != npos; s = (s + 1) & mask)
+    {
+      if (((s - home(nodes_[slots_[s]].hash)) & mask) >= ((s - hole) & mask))
+      {
+        slots_[hole] = slots_[s];
+        hole = s;
+      }
+    }
+    slots_[hole] = npos;
+
+    nodes_[n].parent = npos;
+    nodes_[n].next_sibling = npos;
+    free_.push_back(n);
+    n = parent;
+  }
+}
+
+void path_trie::clear()
+{
+  nodes_.clear();
+  free_.clear();
+  nodes_.push_back(node{ npos, npos, npos, 0, 0, 0, mark::none });
+  names_.clear();
+  slots_.assign(16, npos);
+  shift_ = 32 - 4;
+}
+
+std::uint32_t path_trie::hash(node_id parent, std::string_view name) noexcept
+{
+  // FNV-1a, seeded with the parent node
+  auto h = 0x811c9dc5u ^ (parent * 0x9e3779b9u);
+  for (const auto c : name)
+  {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x01000193u;
+  }
+  return h;
+}
+
+path_trie::size_type path_trie::home(std::uint32_t h) const noexcept
+{
+  // Fibonacci hashing spreads the FNV result over the upper bits
+  return static_cast<size_type>(static_cast<std::uint32_t>(h * 0x9e3779b9u) >> shift_);
+}
+
+path_trie::node_id path_trie::add_child(node_id parent, std::string_view name)
+{
+  if (nodes_.size() >= std::numeric_limits<node_id>::max() / 2 || names_.size() + name.size() > std::numeric_limits<std::uint32_t>::max())
+  {
+    throw std::length_error{ "path_trie too large." };
+  }
+
+  // Keep the load factor at most one half
+  if (2 * nodes_.size() >= slots_.size())
+  {
+    grow();
+  }
+
+  // A removed node is reused along with its name storage if the name fits
+  const auto reused = !free_.empty();
+  auto n = static_cast<node_id>(nodes_.size());
+  if (reused)
+  {
+    n = free_.back();
+    free_.pop_back();
+  }
+  else
+  {
+    nodes_.emplace_back();
+  }
+
+  auto offset = names_.size();
+  if (reused && name.size() <= nodes_[n].name_size)
+  {
+    offset = nodes_[n].name_offset;
+    names_.replace(offset, name.size(), name.data(), name.size());
+  }
+  else
+  {
+    names_.append(name.data(), name.size());
+  }
+
+  const auto h = hash(parent, name);
+  nodes_[n] = node{ parent, npos, nodes_[parent].first_child, static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(name.size()), h,
+    mark::none };
+  nodes_[parent].first_child = n;
+
+  const auto mask = slots_.size() - 1;
+  auto s = home(h);
+  while (slots_[s] != npos)
+  {
+    s = (s + 1) & mask;
+  }
+  slots_[s] = n;
+
+  return n;
+}
+
+void path_trie::grow()
+{
+  slots_.assign(2 * slots_.size(), npos);
+  --shift_;
+
+  const auto mask = slots_.size() - 1;
+  for (auto n = node_id{ 1 }; n < nodes_.size(); ++n)
+  {
+    if (nodes_[n].parent == npos)
+    {
+      continue;
+    }
+    auto s = home(nodes_[n].hash);
+    while (slots_[s] != npos)
+    {
+      s = (s + 1) & mask;
+    }
+    slots_[s] = n;
+  }
+}
+
+void path_trie::clear_subtree(node_id n, mark m) noexcept
+{
+  // Walks the sub tree in pre order through the child, sibling and parent links, no stack needed
+  auto i = nodes_[n].first_child;
+  while (i != npos)
+  {
+    if (m == mark::none || nodes_[i].m == m)
+    {
+      nodes_[i].m = mark::none;
+    }
+
+    if (nodes_[i].first_child != npos)
+    {
+      i = nodes_[i].first_child;
+      continue;
+    }
+    while (i != n && nodes_[i].next_sibling == npos)
+    {
+      i = nodes_[i].parent;
+    }
+    i = i == n ? npos : nodes_[i].next_sibling;
+  }
+}
+
+} // namespace arude
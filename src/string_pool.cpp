@@ -0,0 +1,69 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/string_pool.hpp>
+
+#include <cstring>
+
+
+namespace arude
+{
+
+string_pool::string_pool(std::pmr::memory_resource* upstream)
+  : arena_{ upstream }
+  , strings_{ &arena_ }
+{
+}
+
+string_pool::size_type string_pool::size() const
+{
+  return strings_.size();
+}
+
+std::string_view string_pool::intern(std::string_view s)
+{
+  const auto iter = strings_.find(s);
+  if (iter != std::end(strings_))
+  {
+    return *iter;
+  }
+
+  const auto p = static_cast<char*>(arena_.allocate(s.size() == 0 ? 1 : s.size(), alignof(char)));
+  if (!s.empty())
+  {
+    std::memcpy(p, s.data(), s.size());
+  }
+  return *strings_.emplace(p, s.size()).first;
+}
+
+void string_pool::clear()
+{
+  // The index allocates from the arena as well, drop it before releasing the arena
+  strings_ = std::pmr::unordered_set<std::string_view>{ &arena_ };
+  arena_.release();
+}
+
+} // namespace arude
@@ -0,0 +1,99 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include <libarude/walk_checkpoint.hpp>
+
+#include <libarude/detail/binary_io.hpp>
+
+#include <utility>
+
+
+namespace arude
+{
+
+namespace
+{
+
+constexpr detail::binary_file format{ "Checkpoint", { 'A', 'R', 'C', 'P' }, 1 }; ///< Checkpoint file format
+
+} // namespace
+
+const std::vector<walk_checkpoint::entry>& walk_checkpoint::dirs() const
+{
+  return dirs_;
+}
+
+walk_checkpoint::size_type walk_checkpoint::size() const
+{
+  return dirs_.size();
+}
+
+bool walk_checkpoint::empty() const
+{
+  return dirs_.empty();
+}
+
+void walk_checkpoint::save(const std::string& file) const
+{
+  detail::save(format, file, [this](std::ostream& os)
+  {
+    using detail::write;
+    write(os, static_cast<std::uint64_t>(dirs_.size()));
+    for (const auto& i : dirs_)
+    {
+      write(os, i.dir);
+      write(os, i.position);
+      write(os, i.mtime);
+    }
+  });
+}
+
+void walk_checkpoint::add(std::string dir, std::uint64_t position, std::int64_t mtime)
+{
+  dirs_.push_back(entry{ std::move(dir), position, mtime });
+}
+
+void walk_checkpoint::load(const std::string& file)
+{
+  using detail::read;
+  auto is = detail::open(format, file);
+  auto dirs = decltype(dirs_){};
+  for (auto n = read<std::uint64_t>(format, is); n > 0; --n)
+  {
+    auto dir = detail::read_string(format, is);
+    const auto position = read<std::uint64_t>(format, is);
+    dirs.push_back(entry{ std::move(dir), position, read<std::int64_t>(format, is) });
+  }
+
+  dirs_.swap(dirs);
+}
+
+void walk_checkpoint::clear()
+{
+  dirs_.clear();
+}
+
+} // namespace arude
@@ -0,0 +1,410 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include "libarude_test.hpp"
+
+#include <libarude/bimap.hpp>
+#include <libarude/concurrent_bimap.hpp>
+#include <libarude/flat_bimap.hpp>
+#include <libarude/mapped_bimap.hpp>
+#include <libarude/small_bimap.hpp>
+#include <libarude/static_bimap.hpp>
+#include <libarude/string_pool.hpp>
+#include <libarude/unordered_bimap.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(bimap_map_test)
+{
+  auto b = arude::bimap<int, std::string>{ { 1, "one" }, { 2, "two" } };
+  b.insert(3, "three");
+
+  BOOST_CHECK_EQUAL(b.size(), 3u);
+  BOOST_CHECK_EQUAL(b.map(3), "three");
+  BOOST_CHECK_EQUAL(b.map(std::string{ "two" }), 2);
+  BOOST_CHECK_THROW(b.map(4), arude::nomapping_exception);
+  BOOST_CHECK_THROW(b.insert(4, "one"), arude::nonuniquemapping_exception);
+
+  // Assigned bimaps don't refer to the nodes of the source
+  auto copy = arude::bimap<int, std::string>{ { 9, "nine" } };
+  auto moved = arude::bimap<int, std::string>{};
+  {
+    auto source = b;
+    copy = source;
+    source.insert(4, "four");
+    moved = std::move(source);
+  }
+  BOOST_CHECK_EQUAL(copy.size(), 3u);
+  BOOST_CHECK_EQUAL(copy.map(std::string{ "three" }), 3);
+  BOOST_CHECK_THROW(copy.map(9), arude::nomapping_exception);
+  BOOST_CHECK_EQUAL(moved.size(), 4u);
+  BOOST_CHECK_EQUAL(moved.map(std::string{ "four" }), 4);
+  BOOST_CHECK_EQUAL(moved.map(1), "one");
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(bimap_bulk_load_test)
+{
+  auto mappings = std::vector<std::pair<int, int>>{};
+  for (auto i = 0; i < 100000; ++i)
+  {
+    mappings.emplace_back((i * 7919) % 100000, -i);
+  }
+
+  const auto b = arude::bimap<int, long>(std::begin(mappings), std::end(mappings));
+  BOOST_CHECK_EQUAL(b.size(), mappings.size());
+  BOOST_CHECK_EQUAL(b.map(7919), -1);
+  BOOST_CHECK_EQUAL(b.map(-99999L), (99999 * 7919) % 100000);
+
+  // All offending mappings are reported at once
+  mappings.emplace_back(7919, 1);
+  mappings.emplace_back(100000, -5);
+  try
+  {
+    arude::bimap<int, long>(std::begin(mappings), std::end(mappings));
+    BOOST_ERROR("nonuniquemapping_exception expected");
+  }
+  catch (const arude::nonuniquemapping_exception& e)
+  {
+    const auto nonunique = boost::get_error_info<arude::errinfo_nonunique_mappings<int, long>>(e);
+    BOOST_REQUIRE(nonunique != nullptr);
+    BOOST_CHECK_EQUAL(nonunique->size(), 4u);
+  }
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(flat_bimap_map_test)
+{
+  auto init = arude::bimap<int, std::string>::init_map_type{};
+  for (auto i = 0; i < 1000; ++i)
+  {
+    init.emplace(i * 3, std::to_string(1000 - i));
+  }
+
+  const auto b = arude::flat_bimap<int, std::string>{ init };
+  BOOST_CHECK_EQUAL(b.size(), init.size());
+  for (const auto& i : init)
+  {
+    BOOST_CHECK_EQUAL(b.map(i.first), i.second);
+    BOOST_CHECK_EQUAL(b.map(i.second), i.first);
+  }
+
+  BOOST_CHECK_THROW(b.map(1), arude::nomapping_exception);
+  BOOST_CHECK_THROW(b.map(3001), arude::nomapping_exception);
+  BOOST_CHECK_THROW(b.map(std::string{ "x" }), arude::nomapping_exception);
+  BOOST_CHECK_THROW((arude::flat_bimap<int, std::string>{ { 1, "a" }, { 2, "a" } }), arude::nonuniquemapping_exception);
+  BOOST_CHECK((arude::flat_bimap<int, std::string>{}.empty()));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(static_bimap_map_test)
+{
+  enum class color { red, green, blue };
+  constexpr auto names = arude::make_static_bimap<color, std::string_view>({ { color::red, "red" }, { color::green, "green" }, { color::blue, "blue" } });
+  static_assert(names.map(color::green) == "green", "static_bimap must be usable in constant expressions");
+  static_assert(names.map(std::string_view{ "blue" }) == color::blue, "static_bimap must be usable in constant expressions");
+
+  BOOST_CHECK_EQUAL(names.size(), 3u);
+  BOOST_CHECK(names.map("red") == color::red);
+  BOOST_CHECK_THROW(names.map("yellow"), arude::nomapping_exception);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(unordered_bimap_map_test)
+{
+  auto b = arude::unordered_bimap<std::string, int>{ { "one", 1 }, { "two", 2 } };
+  for (auto i = 3; i < 1000; ++i)
+  {
+    b.insert("id" + std::to_string(i), i);
+  }
+
+  BOOST_CHECK_EQUAL(b.size(), 999u);
+  BOOST_CHECK_EQUAL(b.map(2), "two");
+  BOOST_CHECK_EQUAL(b.map(std::string{ "one" }), 1);
+  BOOST_CHECK_EQUAL(b.map_left(std::string_view{ "id500" }), 500);
+  BOOST_CHECK_EQUAL(b.map_left("id999"), 999);
+  BOOST_CHECK(b.find_left(std::string_view{ "three" }) == nullptr);
+  BOOST_CHECK(b.find_right(0) == nullptr);
+  BOOST_CHECK_THROW(b.map_left("three"), arude::nomapping_exception);
+  BOOST_CHECK_THROW(b.insert("three", 1), arude::nonuniquemapping_exception);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(bimap_nothrow_lookup_test)
+{
+  auto init = arude::bimap<int, std::string>::init_map_type{};
+  for (auto i = 0; i < 100; ++i)
+  {
+    init.emplace(i * 2, "v" + std::to_string(i));
+  }
+  const auto tree = arude::bimap<int, std::string>{ init };
+  const auto flat = arude::flat_bimap<int, std::string>{ init };
+
+  BOOST_CHECK(tree.find(3) == nullptr);
+  BOOST_CHECK_EQUAL(*tree.find(std::string{ "v7" }), 14);
+  BOOST_CHECK(!tree.try_map(std::string{ "x" }));
+  BOOST_CHECK_EQUAL(*flat.try_map(198), "v99");
+  BOOST_CHECK(!flat.try_map(199));
+
+  // Batches small and large against the map size take different paths in bimap
+  for (const auto n : { 3, 1000 })
+  {
+    auto in = std::vector<int>{};
+    for (auto i = 0; i < n; ++i)
+    {
+      in.push_back((i * 7919) % 250);
+    }
+
+    auto tree_out = std::vector<std::string>(in.size());
+    auto flat_out = std::vector<std::string>(in.size());
+    auto tree_missing = std::vector<bool>{};
+    auto flat_missing = std::vector<bool>{};
+    const auto tree_misses = tree.map_n(in.data(), in.size(), tree_out.data(), tree_missing);
+    const auto flat_misses = flat.map_n(in.data(), in.size(), flat_out.data(), flat_missing);
+
+    auto misses = std::size_t{ 0 };
+    for (auto i = std::size_t{ 0 }; i < in.size(); ++i)
+    {
+      const auto p = tree.find(in[i]);
+      misses += p == nullptr ? 1 : 0;
+      BOOST_CHECK_EQUAL(tree_missing[i], p == nullptr);
+      BOOST_CHECK_EQUAL(flat_missing[i], p == nullptr);
+      BOOST_CHECK_EQUAL(tree_out[i], p == nullptr ? std::string{} : *p);
+      BOOST_CHECK_EQUAL(flat_out[i], p == nullptr ? std::string{} : *p);
+    }
+    BOOST_CHECK_EQUAL(tree_misses, misses);
+    BOOST_CHECK_EQUAL(flat_misses, misses);
+  }
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(concurrent_bimap_publish_test)
+{
+  auto b = arude::concurrent_bimap<int, std::string>{};
+  b.insert(0, "0");
+  BOOST_CHECK(!b.try_map(0));
+  b.publish();
+  BOOST_CHECK_EQUAL(b.map(0), "0");
+
+  // Readers must always see a consistent version while the writer publishes
+  auto done = std::atomic<bool>{ false };
+  auto failures = std::atomic<int>{ 0 };
+  auto readers = std::vector<std::thread>{};
+  for (auto i = 0; i < 4; ++i)
+  {
+    readers.emplace_back([&b, &done, &failures] {
+      while (!done)
+      {
+        b.read([&failures](const arude::bimap<int, std::string>& snapshot) {
+          const auto n = static_cast<int>(snapshot.size());
+          if (snapshot.map(n - 1) != std::to_string(n - 1))
+          {
+            ++failures;
+          }
+        });
+      }
+    });
+  }
+
+  for (auto i = 1; i < 200; ++i)
+  {
+    b.insert(i, std::to_string(i));
+    b.publish();
+  }
+  done = true;
+  for (auto& i : readers)
+  {
+    i.join();
+  }
+
+  BOOST_CHECK_EQUAL(failures, 0);
+  BOOST_CHECK_EQUAL(b.size(), 200u);
+  BOOST_CHECK_EQUAL(b.map(std::string{ "199" }), 199);
+
+  b.insert(200, "0");
+  BOOST_CHECK_THROW(b.publish(), arude::nonuniquemapping_exception);
+  b.clear();
+  b.publish();
+  BOOST_CHECK_EQUAL(b.size(), 0u);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(mapped_bimap_map_test)
+{
+  const auto p = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  auto builder = arude::mapped_bimap_builder<std::uint32_t, std::uint64_t>{};
+  for (auto i = std::uint32_t{ 0 }; i < 5000; ++i)
+  {
+    builder.add(i * 5, std::uint64_t{ 1000000 } - i);
+  }
+  builder.write(p);
+
+  {
+    const auto b = arude::mapped_bimap<std::uint32_t, std::uint64_t>{ p };
+    BOOST_CHECK_EQUAL(b.size(), 5000u);
+    for (auto i = std::uint32_t{ 0 }; i < 5000; ++i)
+    {
+      BOOST_CHECK_EQUAL(b.map(i * 5), std::uint64_t{ 1000000 } - i);
+      BOOST_CHECK_EQUAL(b.map(std::uint64_t{ 1000000 } - i), i * 5);
+    }
+    BOOST_CHECK(!b.try_map(std::uint32_t{ 7 }));
+    BOOST_CHECK_THROW(b.map(std::uint64_t{ 7 }), arude::nomapping_exception);
+
+    // Opening with other types must fail
+    BOOST_CHECK_THROW((arude::mapped_bimap<std::uint64_t, std::uint32_t>{ p }), arude::mapped_bimap_format_exception);
+
+    // Rewriting replaces the file, the mapped one stays readable
+    auto other = arude::mapped_bimap_builder<std::uint32_t, std::uint64_t>{};
+    other.add(1, 2);
+    other.write(p);
+    BOOST_CHECK_EQUAL(b.map(std::uint32_t{ 4995 }), std::uint64_t{ 999001 });
+    BOOST_CHECK_EQUAL((arude::mapped_bimap<std::uint32_t, std::uint64_t>{ p }.size()), 1u);
+    BOOST_CHECK(!boost::filesystem::exists(p.string() + ".tmp"));
+  }
+
+  // Corrupt positions of the counterparts must fail
+  {
+    auto h = arude::mapped_bimap_format::header{};
+    boost::filesystem::fstream f{ p, std::ios::binary | std::ios::in | std::ios::out };
+    f.read(reinterpret_cast<char*>(&h), sizeof(h));
+    const auto corrupt = std::uint64_t{ 1000 };
+    f.seekp(static_cast<std::streamoff>(h.l2r_offset + sizeof(corrupt)));
+    f.write(reinterpret_cast<const char*>(&corrupt), sizeof(corrupt));
+  }
+  {
+    const auto b = arude::mapped_bimap<std::uint32_t, std::uint64_t>{ p };
+    BOOST_CHECK_THROW(b.map(std::uint32_t{ 1 }), arude::mapped_bimap_format_exception);
+    BOOST_CHECK_EQUAL(b.map(std::uint64_t{ 2 }), 1u);
+  }
+
+  // A count wrapping the array bounds must fail
+  {
+    auto h = arude::mapped_bimap_format::header{};
+    boost::filesystem::fstream f{ p, std::ios::binary | std::ios::in | std::ios::out };
+    f.read(reinterpret_cast<char*>(&h), sizeof(h));
+    h.count = ~std::uint64_t{};
+    f.seekp(0);
+    f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  }
+  BOOST_CHECK_THROW((arude::mapped_bimap<std::uint32_t, std::uint64_t>{ p }), arude::mapped_bimap_format_exception);
+
+  builder.add(1, 1000000);
+  BOOST_CHECK_THROW(builder.write(p), arude::nonuniquemapping_exception);
+  boost::filesystem::remove(p);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(small_bimap_map_test)
+{
+  auto b = arude::small_bimap<std::int64_t, std::uint16_t>{ { -1, 7 } };
+  for (auto i = std::int64_t{ 1 }; i < 64; ++i)
+  {
+    b.insert(i << 32, static_cast<std::uint16_t>(100 + i));
+  }
+
+  BOOST_CHECK_EQUAL(b.size(), 64u);
+  BOOST_CHECK_EQUAL(b.map(std::int64_t{ -1 }), 7);
+  BOOST_CHECK_EQUAL(b.map(std::int64_t{ 63 } << 32), 163);
+  BOOST_CHECK_EQUAL(b.map(std::uint16_t{ 101 }), std::int64_t{ 1 } << 32);
+  BOOST_CHECK(!b.try_map(std::int64_t{ 1 })); // Only the lower half matches
+  BOOST_CHECK(!b.try_map(std::uint16_t{ 164 }));
+  BOOST_CHECK_THROW(b.insert(std::int64_t{ 2 }, std::uint16_t{ 2 }), std::length_error);
+  BOOST_CHECK_THROW(b.insert(std::int64_t{ -1 }, std::uint16_t{ 2 }), arude::nonuniquemapping_exception);
+
+  // Stale elements behind the size must not match
+  b.clear();
+  for (auto i = std::int64_t{ 0 }; i < 40; ++i)
+  {
+    b.insert(i, static_cast<std::uint16_t>(i));
+  }
+  BOOST_CHECK(!b.try_map(std::int64_t{ 63 } << 32));
+  BOOST_CHECK(!b.try_map(std::uint16_t{ 163 }));
+  BOOST_CHECK_EQUAL(b.map(std::int64_t{ 39 }), 39);
+  BOOST_CHECK_EQUAL(b.map(std::uint16_t{ 33 }), 33);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(string_pool_clear_test)
+{
+  auto names = arude::string_pool{};
+  BOOST_CHECK_EQUAL(names.intern(std::string_view{}), "");
+  BOOST_CHECK_EQUAL(names.intern("a").data(), names.intern(std::string{ "a" }).data());
+  BOOST_CHECK_EQUAL(names.size(), 2u);
+
+  // The index lives in the released arena, it must be usable after clearing
+  names.clear();
+  BOOST_CHECK_EQUAL(names.size(), 0u);
+  for (auto i = 0; i < 100; ++i)
+  {
+    names.intern("name" + std::to_string(i));
+  }
+  BOOST_CHECK_EQUAL(names.size(), 100u);
+  BOOST_CHECK_EQUAL(names.intern("name42"), "name42");
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(pmr_bimap_arena_test)
+{
+  auto arena = std::pmr::monotonic_buffer_resource{};
+  auto names = arude::string_pool{ &arena };
+
+  auto b = arude::pmr::bimap<std::string_view, int>(&arena);
+  for (auto i = 0; i < 100; ++i)
+  {
+    b.insert(names.intern("name" + std::to_string(i)), i);
+  }
+
+  BOOST_CHECK(b.get_allocator().resource() == &arena);
+  BOOST_CHECK_EQUAL(names.size(), 100u);
+  BOOST_CHECK_EQUAL(names.intern("name42").data(), b.map(42).data());
+  BOOST_CHECK_EQUAL(b.map(std::string_view{ "name7" }), 7);
+
+  const auto copy = arude::pmr::bimap<std::string_view, int>(b, &arena);
+  BOOST_CHECK_EQUAL(copy.size(), 100u);
+  BOOST_CHECK_EQUAL(copy.map(99), "name99");
+  BOOST_CHECK_EQUAL(copy.map(std::string_view{ "name0" }), 0);
+
+  // Moving into a bimap on another arena copies the nodes into that arena
+  auto other_arena = std::pmr::monotonic_buffer_resource{};
+  auto other = arude::pmr::bimap<std::string_view, int>(&other_arena);
+  {
+    auto source = arude::pmr::bimap<std::string_view, int>(b, &arena);
+    other = std::move(source);
+  }
+  BOOST_CHECK(other.get_allocator().resource() == &other_arena);
+  BOOST_CHECK_EQUAL(other.size(), 100u);
+  BOOST_CHECK_EQUAL(other.map(std::string_view{ "name5" }), 5);
+  BOOST_CHECK_EQUAL(other.map(5), "name5");
+}
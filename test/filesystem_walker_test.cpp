@@ -0,0 +1,993 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include "libarude_test.hpp"
+
+#include <libarude/compact_path.hpp>
+#include <libarude/concurrent_pathlist.hpp>
+#include <libarude/content_hash.hpp>
+#include <libarude/directory_reader.hpp>
+#include <libarude/directory_snapshot.hpp>
+#include <libarude/duplicate_finder.hpp>
+#include <libarude/filesystem_walker.hpp>
+#include <libarude/includeexclude_pathlist.hpp>
+#include <libarude/io_governor.hpp>
+#include <libarude/metadata_fetcher.hpp>
+#include <libarude/ring_buffer.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+
+///
+/// Temporary directory tree removed at the end of a test.
+///
+struct temp_tree
+{
+  temp_tree()
+    : root{ boost::filesystem::temp_directory_path() / boost::filesystem::unique_path() }
+  {
+    for (const auto i : { "a/x", "a/cache/y", "b/z.tmp", "b/w" })
+    {
+      const auto p = root / i;
+      boost::filesystem::create_directories(p.parent_path());
+      boost::filesystem::ofstream{ p } << i;
+    }
+  }
+
+  ~temp_tree()
+  {
+    boost::filesystem::remove_all(root);
+  }
+
+  boost::filesystem::path root; ///< Root of the tree
+};
+
+} // namespace
+
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(directory_reader_test)
+{
+  using reader_type = arude::directory_reader;
+  const auto tree = temp_tree{};
+  boost::filesystem::create_symlink(tree.root / "b", tree.root / "a" / "link");
+
+  auto entries = std::vector<std::pair<std::string, reader_type::file_type>>{};
+  auto reader = reader_type{};
+  BOOST_REQUIRE(reader.open((tree.root / "a").string()));
+  for (auto e = reader_type::entry{}; reader.next(e);)
+  {
+    entries.emplace_back(std::string{ e.name }, e.type);
+  }
+  std::sort(std::begin(entries), std::end(entries));
+  BOOST_REQUIRE_EQUAL(entries.size(), 3u);
+  BOOST_CHECK(entries[0] == std::make_pair(std::string{ "cache" }, reader_type::file_type::directory));
+  BOOST_CHECK(entries[1] == std::make_pair(std::string{ "link" }, reader_type::file_type::symlink));
+  BOOST_CHECK(entries[2] == std::make_pair(std::string{ "x" }, reader_type::file_type::regular));
+
+  // Reused for the next directory, files and missing directories can't be opened
+  BOOST_REQUIRE(reader.open((tree.root / "b").string()));
+  auto count = 0;
+  for (auto e = reader_type::entry{}; reader.next(e);)
+  {
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, 2);
+
+  // A symlinked directory is followed
+  BOOST_REQUIRE(reader.open((tree.root / "a" / "link").string()));
+  count = 0;
+  for (auto e = reader_type::entry{}; reader.next(e);)
+  {
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK(!reader.open((tree.root / "b" / "w").string()));
+  BOOST_CHECK(!reader.open((tree.root / "missing").string()));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(metadata_fetcher_test)
+{
+  const auto tree = temp_tree{};
+  auto paths = std::vector<std::string>{};
+  for (auto i = 0; i < 300; ++i)
+  {
+    const auto p = tree.root / ("f" + std::to_string(i));
+    boost::filesystem::ofstream{ p } << std::string(static_cast<std::size_t>(i), 'x');
+    paths.push_back(p.string());
+  }
+  paths.push_back((tree.root / "missing").string());
+
+  using backend = arude::metadata_fetcher::backend;
+  // Without pool threads the calling thread reads the metadata
+  const std::pair<backend, std::size_t> configs[] = { { backend::automatic, 4 }, { backend::thread_pool, 4 }, { backend::thread_pool, 0 } };
+  for (const auto& c : configs)
+  {
+    auto fetcher = arude::metadata_fetcher{ 16, c.second, c.first };
+    BOOST_CHECK(c.first == backend::automatic || !fetcher.uses_io_uring());
+
+    // Twice, the second batch reuses the ring or the pool
+    for (auto round = 0; round < 2; ++round)
+    {
+      auto md = std::vector<arude::file_metadata>(paths.size());
+      fetcher.fetch(paths.data(), paths.size(), md.data());
+      for (auto i = 0u; i < 300; ++i)
+      {
+        BOOST_CHECK(md[i].valid);
+        BOOST_CHECK_EQUAL(md[i].size, i);
+        BOOST_CHECK(md[i].mtime.time_since_epoch().count() > 0);
+      }
+      BOOST_CHECK(!md.back().valid);
+    }
+  }
+
+  // Many tiny batches, so pool threads wake while the batch before is done already
+  auto fetcher = arude::metadata_fetcher{ 16, 8, backend::thread_pool };
+  auto failures = 0;
+  for (auto round = 0u; round < 2000; ++round)
+  {
+    const auto batch = std::vector<std::string>{ paths[round % 300] };
+    auto md = std::vector<arude::file_metadata>(batch.size());
+    fetcher.fetch(batch.data(), batch.size(), md.data());
+    failures += !md[0].valid || md[0].size != round % 300;
+  }
+  BOOST_CHECK_EQUAL(failures, 0);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(concurrent_pathlist_publish_test)
+{
+  using path = boost::filesystem::path;
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(path{ "/data" }, false);
+  l.add_excludepath(path{ "/data/a" });
+
+  auto shared = arude::concurrent_pathlist<path>{ l };
+  BOOST_CHECK(shared.excluded(path{ "/data/a/f" }));
+
+  // Readers keep going while the list is reloaded
+  auto done = std::atomic<bool>{ false };
+  auto torn = std::atomic<int>{ 0 };
+  auto readers = std::vector<std::thread>{};
+  for (auto i = 0; i < 4; ++i)
+  {
+    readers.emplace_back([&shared, &done, &torn]
+    {
+      while (!done)
+      {
+        const auto snapshot = shared.read();
+        const auto a = snapshot->excluded(std::string_view{ "/data/a/f" });
+        const auto b = snapshot->excluded(std::string_view{ "/data/b/f" });
+        torn += a == b ? 1 : 0;
+      }
+    });
+  }
+
+  for (auto i = 0; i < 100; ++i)
+  {
+    auto next = arude::includexclude_pathlist<path>{};
+    next.add_includepath(path{ "/data" }, false);
+    next.add_excludepath(path{ i % 2 == 0 ? "/data/b" : "/data/a" });
+    shared.publish(next);
+  }
+  done = true;
+  for (auto& i : readers)
+  {
+    i.join();
+  }
+
+  BOOST_CHECK_EQUAL(torn, 0);
+  BOOST_CHECK(shared.excluded(path{ "/data/a/f" }));
+  BOOST_CHECK(!shared.excluded(path{ "/data/b/f" }));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ring_buffer_test)
+{
+  auto q = arude::ring_buffer<int>{ 5 };
+  BOOST_CHECK_EQUAL(q.capacity(), 8u);
+  for (auto i = 0; i < 8; ++i)
+  {
+    BOOST_CHECK(q.try_push(int{ i }));
+  }
+  BOOST_CHECK(!q.try_push(8));
+
+  auto out = std::vector<int>{};
+  BOOST_CHECK_EQUAL(q.try_pop(std::back_inserter(out), 3), 3u);
+  BOOST_CHECK((out == std::vector<int>{ 0, 1, 2 }));
+  BOOST_CHECK(q.try_push(8));
+  BOOST_CHECK_EQUAL(q.try_pop(std::back_inserter(out), 100), 6u);
+  BOOST_CHECK_EQUAL(out.size(), 9u);
+  BOOST_CHECK_EQUAL(out.back(), 8);
+
+  // Each producer's values arrive complete and in order
+  const auto producers = 4;
+  const auto count = 10000;
+  auto threads = std::vector<std::thread>{};
+  for (auto i = 0; i < producers; ++i)
+  {
+    threads.emplace_back([&q, i]
+    {
+      for (auto j = 0; j < count; ++j)
+      {
+        while (!q.try_push(i * count + j))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  auto next = std::vector<int>(producers, 0);
+  auto ordered = true;
+  for (auto taken = 0; taken < producers * count;)
+  {
+    out.clear();
+    q.try_pop(std::back_inserter(out), 64);
+    for (const auto v : out)
+    {
+      ordered = ordered && v % count == next[v / count]++;
+    }
+    taken += static_cast<int>(out.size());
+  }
+  for (auto& i : threads)
+  {
+    i.join();
+  }
+  BOOST_CHECK(ordered);
+  BOOST_CHECK(!q.closed());
+  q.close();
+  BOOST_CHECK(q.closed());
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_run_test)
+{
+  using path = boost::filesystem::path;
+  const auto tree = temp_tree{};
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(tree.root, false);
+  l.add_excludepath(tree.root / "a" / "cache");
+  l.add_excludepattern("*.tmp");
+
+  auto found = std::vector<std::string>{};
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.run([&found, &tree](path p) { found.push_back(p.lexically_relative(tree.root).generic_string()); });
+  walker.wait();
+  BOOST_CHECK(!walker.running());
+
+  std::sort(std::begin(found), std::end(found));
+  BOOST_CHECK((found == std::vector<std::string>{ "a/x", "b/w" }));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_compact_path_test)
+{
+  using path = arude::compact_path;
+  const auto tree = temp_tree{};
+  const auto root = path{ tree.root };
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(root, false);
+  l.add_excludepath(root / "a/cache");
+  l.add_excludepattern("*.tmp");
+
+  auto found = std::vector<std::string>{};
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.run([&found, &root](path p) { found.emplace_back(p.string().substr(root.size() + 1)); });
+  walker.wait();
+
+  std::sort(std::begin(found), std::end(found));
+  BOOST_CHECK((found == std::vector<std::string>{ "a/x", "b/w" }));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_parallel_test)
+{
+  using path = boost::filesystem::path;
+  const auto root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  auto expected = std::vector<std::string>{};
+  for (auto i = 0; i < 8; ++i)
+  {
+    for (auto j = 0; j < 8; ++j)
+    {
+      const auto dir = root / std::to_string(i) / std::to_string(j);
+      boost::filesystem::create_directories(dir / "cache");
+      boost::filesystem::ofstream{ dir / "cache" / "f" };
+      for (auto k = 0; k < 4; ++k)
+      {
+        boost::filesystem::ofstream{ dir / std::to_string(k) };
+        expected.push_back((dir / std::to_string(k)).string());
+      }
+    }
+  }
+  std::sort(std::begin(expected), std::end(expected));
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(root, false);
+  l.add_excludepattern("cache");
+
+  for (const auto threads : { 1u, 4u, 0u })
+  {
+    auto found = std::vector<std::string>{};
+    auto found_mtx = std::mutex{};
+    auto walker = arude::filesystem_walker<path>{ l };
+    walker.run([&found, &found_mtx](path p)
+    {
+      std::lock_guard<std::mutex> lock{ found_mtx };
+      found.push_back(p.string());
+    }, threads);
+    walker.wait();
+
+    std::sort(std::begin(found), std::end(found));
+    BOOST_CHECK(found == expected);
+  }
+
+  // Stopping from the handler ends all threads
+  auto count = std::atomic<int>{ 0 };
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.run([&count, &walker](path) { ++count; walker.stop(); }, 4);
+  walker.wait();
+  BOOST_CHECK(!walker.running());
+  BOOST_CHECK(count < static_cast<int>(expected.size()));
+
+  // Handler errors are rethrown
+  walker.run([](path) { throw std::runtime_error{ "handler" }; }, 4);
+  BOOST_CHECK_THROW(walker.wait(), std::runtime_error);
+
+  boost::filesystem::remove_all(root);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_batched_test)
+{
+  using path = boost::filesystem::path;
+  const auto root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  auto expected = std::vector<std::string>{};
+  for (auto i = 0; i < 8; ++i)
+  {
+    const auto dir = root / std::to_string(i);
+    boost::filesystem::create_directories(dir);
+    for (auto j = 0; j < 64; ++j)
+    {
+      boost::filesystem::ofstream{ dir / std::to_string(j) };
+      expected.push_back((dir / std::to_string(j)).string());
+    }
+  }
+  std::sort(std::begin(expected), std::end(expected));
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(root, false);
+
+  // A slow handler and a small buffer make the walking threads wait, batches are handed on a single thread
+  auto found = std::vector<std::string>{};
+  auto largest = std::size_t{ 0 };
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.run_batched([&found, &largest](std::vector<path>& batch)
+  {
+    largest = std::max(largest, batch.size());
+    for (auto& i : batch)
+    {
+      found.push_back(i.string());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+  }, 4, 16);
+  walker.wait();
+
+  std::sort(std::begin(found), std::end(found));
+  BOOST_CHECK(found == expected);
+  BOOST_CHECK(largest > 1);
+  BOOST_CHECK(largest <= 16);
+
+  // Handler errors stop the walk and are rethrown
+  walker.run_batched([](std::vector<path>&) { throw std::runtime_error{ "handler" }; }, 4, 16);
+  BOOST_CHECK_THROW(walker.wait(), std::runtime_error);
+
+  boost::filesystem::remove_all(root);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_checkpoint_test)
+{
+  using path = boost::filesystem::path;
+  const auto root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  auto expected = std::vector<std::string>{};
+  for (auto i = 0; i < 4; ++i)
+  {
+    for (auto j = 0; j < 4; ++j)
+    {
+      const auto dir = root / std::to_string(i) / std::to_string(j);
+      boost::filesystem::create_directories(dir);
+      for (auto k = 0; k < 50; ++k)
+      {
+        boost::filesystem::ofstream{ dir / std::to_string(k) };
+        expected.push_back((dir / std::to_string(k)).string());
+      }
+    }
+  }
+  std::sort(std::begin(expected), std::end(expected));
+  const auto file = (root.parent_path() / boost::filesystem::unique_path()).string();
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(root, false);
+
+  auto found = std::vector<std::string>{};
+  auto found_mtx = std::mutex{};
+  const auto handler = [&found, &found_mtx](path p)
+  {
+    std::lock_guard<std::mutex> lock{ found_mtx };
+    found.push_back(p.string());
+  };
+  const auto covered = [&found, &expected]
+  {
+    auto all = found;
+    std::sort(std::begin(all), std::end(all));
+    all.erase(std::unique(std::begin(all), std::end(all)), std::end(all));
+    return all == expected;
+  };
+
+  // Stopped walks resume where they stopped, handing only the files of the entries in progress again
+  auto stops = 0;
+  for (auto threads = 1u; boost::filesystem::exists(file) || stops == 0; threads = 4)
+  {
+    auto walker = arude::filesystem_walker<path>{ l };
+    walker.checkpoint(file);
+    auto count = std::atomic<int>{ 0 };
+    walker.run([&handler, &count, &walker](path p)
+    {
+      handler(std::move(p));
+      if (++count == 150)
+      {
+        walker.stop();
+      }
+    }, threads);
+    walker.wait();
+    ++stops;
+  }
+  BOOST_CHECK_EQUAL(stops, static_cast<int>(expected.size() / 150 + 1));
+  BOOST_CHECK(covered());
+  BOOST_CHECK(found.size() < expected.size() + 4 * static_cast<std::size_t>(stops));
+
+  // A walk ended without stopping, like a crash, resumes from the last checkpoint saved while walking
+  found.clear();
+  auto copied = std::size_t{ 0 };
+  {
+    auto walker = arude::filesystem_walker<path>{ l };
+    walker.checkpoint(file, std::chrono::milliseconds{ 1 });
+    walker.run_batched([&handler, &found, &found_mtx, &copied, &file](std::vector<path>& batch)
+    {
+      for (auto& i : batch)
+      {
+        handler(std::move(i));
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+
+      std::lock_guard<std::mutex> lock{ found_mtx };
+      if (copied == 0 && found.size() >= 400 && boost::filesystem::exists(file))
+      {
+        boost::filesystem::copy_file(file, file + ".crash");
+        copied = found.size();
+      }
+    }, 2, 16);
+    walker.wait();
+  }
+  BOOST_REQUIRE(copied > 0);
+  BOOST_CHECK(!boost::filesystem::exists(file));
+  found.resize(copied);
+  boost::filesystem::rename(file + ".crash", file);
+
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.checkpoint(file);
+  walker.run(handler, 2);
+  walker.wait();
+  BOOST_CHECK(covered());
+  BOOST_CHECK(found.size() < 2 * expected.size());
+  BOOST_CHECK(!boost::filesystem::exists(file));
+
+  // With a metadata filter predicate files wait in batches, while the sub directories between them are queued at once
+  const auto mixed = root.parent_path() / boost::filesystem::unique_path();
+  expected.clear();
+  const std::function<void(const path&, int)> fill = [&fill, &expected](const path& dir, int depth)
+  {
+    boost::filesystem::create_directories(dir);
+    for (auto k = 0; k < 40; ++k)
+    {
+      boost::filesystem::ofstream{ dir / ("f" + std::to_string(k)) };
+      expected.push_back((dir / ("f" + std::to_string(k))).string());
+      if (depth < 2 && k % 10 == 5)
+      {
+        fill(dir / ("d" + std::to_string(k)), depth + 1);
+      }
+    }
+  };
+  fill(mixed, 0);
+  std::sort(std::begin(expected), std::end(expected));
+
+  auto ml = arude::includexclude_pathlist<path>{};
+  ml.add_includepath(mixed, false);
+  found.clear();
+  stops = 0;
+  for (auto threads = 1u; boost::filesystem::exists(file) || stops == 0; threads = 4)
+  {
+    auto metadata_walker = arude::filesystem_walker<path>{ ml, [](const path&, const arude::file_metadata& md) { return md.valid; } };
+    metadata_walker.checkpoint(file);
+    auto count = std::atomic<int>{ 0 };
+    metadata_walker.run([&handler, &count, &metadata_walker](path p)
+    {
+      handler(std::move(p));
+      if (++count == 100)
+      {
+        metadata_walker.stop();
+      }
+    }, threads);
+    metadata_walker.wait();
+    ++stops;
+  }
+  BOOST_CHECK(stops > 1);
+  BOOST_CHECK(covered());
+  BOOST_CHECK(found.size() < expected.size() + 4 * static_cast<std::size_t>(stops));
+
+  boost::filesystem::remove_all(mixed);
+  boost::filesystem::remove_all(root);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(io_governor_test)
+{
+  using namespace std::chrono_literals;
+  using governor_type = arude::io_governor;
+
+  // A burst is free, more runs into debt shared by all charges
+  auto limits = governor_type::limits{};
+  limits.dirs_per_second = 100;
+  limits.bytes_per_second = 1000;
+  limits.burst = 100ms;
+  auto g = governor_type{ limits };
+  BOOST_CHECK(g.charge(10, 1000, 100) == 0ns);
+  BOOST_CHECK(g.charge(0, 1000, 0) == 0ns);
+  const auto wait = g.charge(10, 0, 0);
+  BOOST_CHECK(wait > 80ms && wait <= 100ms);
+  BOOST_CHECK(g.charge(0, 0, 1000) > 900ms);
+
+  // Backing off while the latency is too high, and recovering
+  limits = governor_type::limits{};
+  limits.latency_target = 1ms;
+  limits.idle_priority = true;
+  auto adaptive = governor_type{ limits };
+  BOOST_CHECK(adaptive.charge(1, 1000000, 1000000) == 0ns);
+  adaptive.measured(100us);
+  BOOST_CHECK(adaptive.backoff() == 0ns);
+  for (auto i = 0; i < 4; ++i)
+  {
+    adaptive.measured(20ms);
+  }
+  BOOST_CHECK(adaptive.latency() > 1ms);
+  BOOST_CHECK(adaptive.backoff() >= 4ms);
+  BOOST_CHECK(adaptive.charge(1, 0, 0) == adaptive.backoff());
+  BOOST_CHECK(adaptive.charge(0, 0, 100) == 0ns);
+  for (auto i = 0; i < 200; ++i)
+  {
+    adaptive.measured(100us);
+  }
+  BOOST_CHECK(adaptive.backoff() == 0ns);
+
+#if defined(ARUDE_IO_GOVERNOR_IOPRIO)
+  auto entered = false;
+  std::thread{ [&adaptive, &entered] { entered = adaptive.enter_thread(); } }.join();
+  BOOST_CHECK(entered);
+#endif
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_throttle_test)
+{
+  using path = boost::filesystem::path;
+  const auto root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  for (auto i = 0; i < 30; ++i)
+  {
+    boost::filesystem::create_directories(root / std::to_string(i));
+    boost::filesystem::ofstream{ root / std::to_string(i) / "f" };
+  }
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(root, false);
+
+  // 31 directories with a burst of 10 take at least 0.2 seconds, with any number of threads
+  auto limits = arude::io_governor::limits{};
+  limits.dirs_per_second = 100;
+  limits.latency_target = std::chrono::seconds{ 1 };
+  const auto governor = std::make_shared<arude::io_governor>(limits);
+  auto count = std::atomic<int>{ 0 };
+  auto walker = arude::filesystem_walker<path>{ l };
+  walker.throttle(governor);
+  const auto start = std::chrono::steady_clock::now();
+  walker.run([&count](path) { ++count; }, 4);
+  walker.wait();
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{ 190 });
+  BOOST_CHECK_EQUAL(count, 30);
+  BOOST_CHECK(governor->latency().count() > 0);
+
+  // Stopping does not wait for the debt
+  limits.dirs_per_second = 1;
+  walker.throttle(std::make_shared<arude::io_governor>(limits));
+  walker.run([](path) {}, 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+  const auto stopped = std::chrono::steady_clock::now();
+  walker.stop();
+  walker.wait();
+  BOOST_CHECK(std::chrono::steady_clock::now() - stopped < std::chrono::milliseconds{ 500 });
+
+  boost::filesystem::remove_all(root);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_metadata_test)
+{
+  using path = boost::filesystem::path;
+  const auto tree = temp_tree{};
+  boost::filesystem::ofstream{ tree.root / "a" / "empty" };
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(tree.root, false);
+  l.add_excludepattern("*.tmp");
+
+  // Only files with contents, on several threads
+  for (const auto threads : { 1u, 4u })
+  {
+    auto found = std::vector<std::string>{};
+    auto found_mtx = std::mutex{};
+    auto walker = arude::filesystem_walker<path>{ l, [](const path&, const arude::file_metadata& md) { return md.valid && md.size > 0; } };
+    walker.run([&found, &found_mtx, &tree](path p)
+    {
+      std::lock_guard<std::mutex> lock{ found_mtx };
+      found.push_back(p.lexically_relative(tree.root).generic_string());
+    }, threads);
+    walker.wait();
+
+    std::sort(std::begin(found), std::end(found));
+    BOOST_CHECK((found == std::vector<std::string>{ "a/cache/y", "a/x", "b/w" }));
+  }
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_rescan_test)
+{
+  using path = boost::filesystem::path;
+  using walker_type = arude::filesystem_walker<path>;
+  const auto tree = temp_tree{};
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(tree.root, false);
+  l.add_excludepattern("*.tmp");
+
+  auto snapshot = arude::directory_snapshot{};
+  const auto rescan = [&l, &tree, &snapshot](std::size_t threads)
+  {
+    auto changes = std::vector<std::string>{};
+    auto changes_mtx = std::mutex{};
+    auto walker = walker_type{ l };
+    walker.rescan(snapshot, [&changes, &changes_mtx, &tree](path p, walker_type::change c)
+    {
+      const char* names[] = { "+", "-", "*" };
+      std::lock_guard<std::mutex> lock{ changes_mtx };
+      changes.push_back(names[static_cast<int>(c)] + p.lexically_relative(tree.root).generic_string());
+    }, threads);
+    walker.wait();
+    std::sort(std::begin(changes), std::end(changes));
+    return changes;
+  };
+
+  BOOST_CHECK((rescan(1) == std::vector<std::string>{ "+a/cache/y", "+a/x", "+b/w" }));
+  BOOST_CHECK_EQUAL(snapshot.size(), 4u);
+  BOOST_CHECK(rescan(4).empty());
+
+  boost::filesystem::ofstream{ tree.root / "a" / "new" };
+  boost::filesystem::ofstream{ tree.root / "a" / "x", std::ios::app } << "more";
+  boost::filesystem::remove_all(tree.root / "a" / "cache");
+  boost::filesystem::remove(tree.root / "b" / "w");
+  BOOST_CHECK((rescan(4) == std::vector<std::string>{ "*a/x", "+a/new", "-a/cache/y", "-b/w" }));
+  BOOST_CHECK(rescan(1).empty());
+
+  // Saved and loaded
+  const auto file = (tree.root.parent_path() / boost::filesystem::unique_path()).string();
+  snapshot.save(file);
+  snapshot.clear();
+  snapshot.load(file);
+  boost::filesystem::remove(file);
+  BOOST_CHECK_EQUAL(snapshot.size(), 3u);
+  BOOST_CHECK(rescan(1).empty());
+  BOOST_CHECK_THROW(snapshot.load(file), std::runtime_error);
+
+  // Listings of directories with an old modification time are taken from the snapshot, not read
+  const auto old = std::time(nullptr) - 3600;
+  for (const auto& i : { tree.root, tree.root / "a", tree.root / "b" })
+  {
+    boost::filesystem::last_write_time(i, old);
+  }
+  BOOST_CHECK(rescan(1).empty());
+  BOOST_CHECK(rescan(4).empty());
+  BOOST_CHECK_EQUAL(snapshot.size(), 3u);
+  boost::filesystem::ofstream{ tree.root / "b" / "unseen" };
+  boost::filesystem::last_write_time(tree.root / "b", old);
+  BOOST_CHECK(rescan(1).empty());
+  boost::filesystem::ofstream{ tree.root / "b" / "seen" };
+  BOOST_CHECK((rescan(1) == std::vector<std::string>{ "+b/seen", "+b/unseen" }));
+
+  // An unchanged listing drops the listings of sub directories excluded since
+  l.add_excludepath(tree.root / "a");
+  BOOST_CHECK(rescan(1).empty());
+  BOOST_CHECK_EQUAL(snapshot.size(), 2u);
+  BOOST_CHECK(snapshot.find((tree.root / "a").string()) == nullptr);
+  l.add_includepath(tree.root, true);
+  BOOST_CHECK((rescan(1) == std::vector<std::string>{ "+a/new", "+a/x" }));
+  BOOST_CHECK_EQUAL(snapshot.size(), 3u);
+
+  // A removed include path removes all its files
+  boost::filesystem::remove_all(tree.root);
+  BOOST_CHECK((rescan(4) == std::vector<std::string>{ "-a/new", "-a/x", "-b/seen", "-b/unseen" }));
+  BOOST_CHECK(snapshot.empty());
+}
+
+#if defined(ARUDE_DIRECTORY_WATCHER_INOTIFY)
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(filesystem_walker_watch_test)
+{
+  using path = boost::filesystem::path;
+  using walker_type = arude::filesystem_walker<path>;
+  const auto tree = temp_tree{};
+
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(tree.root, false);
+  l.add_excludepattern("*.tmp");
+
+  auto snapshot = arude::directory_snapshot{};
+  auto changes = std::vector<std::string>{};
+  auto changes_mtx = std::mutex{};
+  auto walker = walker_type{ l };
+  walker.watch(snapshot, [&changes, &changes_mtx, &tree](path p, walker_type::change c)
+  {
+    const char* names[] = { "+", "-", "*" };
+    std::lock_guard<std::mutex> lock{ changes_mtx };
+    changes.push_back(names[static_cast<int>(c)] + p.lexically_relative(tree.root).generic_string());
+  }, 2);
+
+  // Takes the changes reported so far once they are as expected, a file modified by several writes may be reported more than once
+  const auto reported = [&changes, &changes_mtx](const std::vector<std::string>& expected)
+  {
+    for (auto i = 0; i < 500; ++i)
+    {
+      {
+        std::lock_guard<std::mutex> lock{ changes_mtx };
+        std::sort(std::begin(changes), std::end(changes));
+        changes.erase(std::unique(std::begin(changes), std::end(changes)), std::end(changes));
+        if (changes == expected)
+        {
+          changes.clear();
+          return true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+    }
+    return false;
+  };
+
+  BOOST_CHECK(reported({ "+a/cache/y", "+a/x", "+b/w" }));
+
+  boost::filesystem::ofstream{ tree.root / "a" / "new" };
+  boost::filesystem::ofstream{ tree.root / "a" / "x", std::ios::app } << "more";
+  boost::filesystem::remove_all(tree.root / "a" / "cache");
+  boost::filesystem::remove(tree.root / "b" / "w");
+  boost::filesystem::ofstream{ tree.root / "b" / "ignored.tmp" };
+  BOOST_CHECK(reported({ "*a/x", "+a/new", "-a/cache/y", "-b/w" }));
+
+  // Created directories are walked and watched
+  boost::filesystem::create_directories(tree.root / "c" / "d");
+  boost::filesystem::ofstream{ tree.root / "c" / "d" / "e" };
+  BOOST_CHECK(reported({ "+c/d/e" }));
+  boost::filesystem::ofstream{ tree.root / "c" / "d" / "f" };
+  BOOST_CHECK(reported({ "+c/d/f" }));
+
+  // Moved directories
+  boost::filesystem::rename(tree.root / "c", tree.root / "b" / "moved");
+  BOOST_CHECK(reported({ "+b/moved/d/e", "+b/moved/d/f", "-c/d/e", "-c/d/f" }));
+  boost::filesystem::remove(tree.root / "b" / "moved" / "d" / "f");
+  BOOST_CHECK(reported({ "-b/moved/d/f" }));
+
+  walker.stop();
+  walker.wait();
+
+  // The snapshot is up to date
+  auto rescanner = walker_type{ l };
+  rescanner.rescan(snapshot, [&changes, &changes_mtx](path p, walker_type::change)
+  {
+    std::lock_guard<std::mutex> lock{ changes_mtx };
+    changes.push_back(p.string());
+  });
+  rescanner.wait();
+  BOOST_CHECK(changes.empty());
+}
+#endif
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(content_hash_test)
+{
+  // Reference digests of XXH64 with seed 0
+  const auto of = [](std::string_view s) { return arude::content_hash::of(s.data(), s.size()); };
+  BOOST_CHECK_EQUAL(of(""), 0xef46db3751d8e999ull);
+  BOOST_CHECK_EQUAL(of("a"), 0xd24ec4f1a98c6e5bull);
+  BOOST_CHECK_EQUAL(of("abc"), 0x44bc2cf5ad770999ull);
+  BOOST_CHECK_EQUAL(of("Nobody inspects the spammish repetition"), 0xfbcea83c8a378bf1ull);
+  BOOST_CHECK_NE(arude::content_hash::of("abc", 3, 1), of("abc"));
+
+  // Added in pieces of any size
+  auto data = std::string(10000, '\0');
+  for (auto i = std::size_t{ 0 }; i < data.size(); ++i)
+  {
+    data[i] = static_cast<char>(i * 131);
+  }
+  for (const auto piece : { 1u, 7u, 32u, 33u, 1000u })
+  {
+    auto h = arude::content_hash{};
+    for (auto i = std::size_t{ 0 }; i < data.size(); i += piece)
+    {
+      h.update(data.data() + i, std::min<std::size_t>(piece, data.size() - i));
+    }
+    BOOST_CHECK_EQUAL(h.digest(), of(data));
+  }
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(duplicate_finder_test)
+{
+  using path = boost::filesystem::path;
+  const auto tree = temp_tree{};
+  const auto write = [&tree](const char* name, std::string contents)
+  {
+    boost::filesystem::create_directories((tree.root / name).parent_path());
+    boost::filesystem::ofstream{ tree.root / name, std::ios::binary } << contents;
+  };
+
+  // Large files equal, differing in the middle only, at the head only; small ones equal and not; empty ones
+  auto large = std::string(100000, 'l');
+  write("c/large1", large);
+  write("d/large2", large);
+  large[50000] = 'm';
+  write("c/middle", large);
+  large[0] = 'h';
+  write("c/head", large);
+  write("d/small1", "small");
+  write("d/small2", "small");
+  write("c/small3", "smalL");
+  write("c/empty1", "");
+  write("c/empty2", "");
+
+  // Hard links count as one file, reported by the first path
+  boost::filesystem::create_hard_link(tree.root / "c" / "large1", tree.root / "d" / "link1");
+  write("c/solo", std::string(3333, 's'));
+  boost::filesystem::create_hard_link(tree.root / "c" / "solo", tree.root / "d" / "solo_link");
+
+  const auto relative = [&tree](std::vector<arude::duplicate_finder::group_type> groups)
+  {
+    for (auto& g : groups)
+    {
+      for (auto& p : g)
+      {
+        p = path{ p }.lexically_relative(tree.root).generic_string();
+      }
+    }
+    return groups;
+  };
+  const auto expected = std::vector<arude::duplicate_finder::group_type>{ { "c/large1", "d/large2" }, { "d/small1", "d/small2" } };
+
+  // Fed with the sizes read by the walk, on several threads
+  for (const auto threads : { 1u, 4u })
+  {
+    auto options = arude::duplicate_finder::options{};
+    options.threads = threads;
+    options.buffer_size = 4096;
+    auto finder = arude::duplicate_finder{ options };
+    auto l = arude::includexclude_pathlist<path>{};
+    l.add_includepath(tree.root, false);
+    auto walker = arude::filesystem_walker<path>{ l, [&finder](const path& p, const arude::file_metadata& md)
+    {
+      if (md.valid)
+      {
+        finder.add(p.string(), md.size);
+      }
+      return false;
+    } };
+    walker.run([](path) {}, threads);
+    walker.wait();
+    BOOST_CHECK_EQUAL(finder.size(), 16u);
+
+    BOOST_CHECK(relative(finder.find()) == expected);
+    // The large file differing at the head is not read whole, the others are read whole once by the comparison only
+    BOOST_CHECK_LT(finder.bytes_read(), 3 * 100000 + 5 * 8192 + 2 * 3333 + 100);
+
+    // Trusting the hashes finds the same without comparing
+    options.verify = false;
+    auto trusting = arude::duplicate_finder{ options };
+    for (const auto i : { "c/large1", "d/large2", "d/link1", "c/middle", "c/head" })
+    {
+      trusting.add((tree.root / i).string(), 100000);
+    }
+    BOOST_CHECK((relative(trusting.find()) == std::vector<arude::duplicate_finder::group_type>{ { "c/large1", "d/large2" } }));
+    BOOST_CHECK_EQUAL(trusting.bytes_read(), 3 * 100000 + 5 * 8192);
+  }
+
+  // Sizes read by the search, empty files included, removed files left out
+  auto options = arude::duplicate_finder::options{};
+  options.min_size = 0;
+  auto finder = arude::duplicate_finder{ options };
+  for (const auto i : { "c/large1", "d/large2", "c/middle", "c/empty1", "c/empty2", "c/gone" })
+  {
+    finder.add((tree.root / i).string());
+  }
+  BOOST_CHECK((relative(finder.find()) == std::vector<arude::duplicate_finder::group_type>{ { "c/empty1", "c/empty2" }, { "c/large1", "d/large2" } }));
+
+  // Files split off where they differ are compared on from there, two of them equal, and none read again
+  auto split = std::string(100000, 's');
+  write("e/base", split);
+  split[90000] = 't';
+  write("e/late", split);
+  split[90000] = 's';
+  split[30000] = 't';
+  write("e/early1", split);
+  write("e/early2", split);
+  split[60000] = 't';
+  write("e/early3", split);
+  options.buffer_size = 4096;
+  auto splitting = arude::duplicate_finder{ options };
+  for (const auto i : { "e/base", "e/late", "e/early1", "e/early2", "e/early3" })
+  {
+    splitting.add((tree.root / i).string());
+  }
+  BOOST_CHECK((relative(splitting.find()) == std::vector<arude::duplicate_finder::group_type>{ { "e/early1", "e/early2" } }));
+  BOOST_CHECK_LT(splitting.bytes_read(), 5 * 100000 + 5 * 8192 + 4 * 4096);
+
+  finder.clear();
+  BOOST_CHECK_EQUAL(finder.size(), 0u);
+  BOOST_CHECK(finder.find().empty());
+}
@@ -0,0 +1,583 @@
+///
+/// This file belongs to the libarude.
+///
+/// \author Adrian Rudin
+/// \copyright Copyright 2016 Adrian Rudin (arude).
+///
+/// For commercial or closed source software a commercial license must be
+/// obtained. Please contact me.
+///
+/// This file/project is part of libarude and released under the GNU General
+/// Public License for non commercial software.
+///
+/// libarude is free software for non commerical use. You can redistribute it
+/// and / or modify it under the terms of the GNU General Public License as
+/// published by the Free Software Foundation, either version 3 of the License,
+/// or (at your option) any later version.
+///
+/// libarude is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Foobar.If not, see <http://www.gnu.org/licenses/>.
+///
+
+#include "libarude_test.hpp"
+
+#include <libarude/compact_path.hpp>
+#include <libarude/includeexclude_pathlist.hpp>
+#include <libarude/path_pattern_set.hpp>
+#include <libarude/path_trie.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(path_trie_lookup_test)
+{
+  auto t = arude::path_trie{};
+  t.set("/foo", arude::path_trie::mark::include);
+  t.set("/foo/bar/", arude::path_trie::mark::exclude);
+  t.set("/foo/bar/baz", arude::path_trie::mark::include);
+
+  BOOST_CHECK(t.lookup("/") == arude::path_trie::mark::none);
+  BOOST_CHECK(t.lookup("/foo/x") == arude::path_trie::mark::include);
+  BOOST_CHECK(t.lookup("/foo//bar/./x") == arude::path_trie::mark::exclude);
+  BOOST_CHECK(t.lookup("/foo/barx") == arude::path_trie::mark::include);
+  BOOST_CHECK(t.lookup("/foo/bar/baz/x") == arude::path_trie::mark::include);
+
+  t.clear_below("/foo", arude::path_trie::mark::exclude);
+  BOOST_CHECK(t.lookup("/foo/bar/x") == arude::path_trie::mark::include);
+
+  // Enough nodes to grow the hash table several times
+  for (auto i = 0; i < 1000; ++i)
+  {
+    t.set("/foo/d" + std::to_string(i), arude::path_trie::mark::exclude);
+  }
+  BOOST_CHECK(t.lookup("/foo/d999/x") == arude::path_trie::mark::exclude);
+  BOOST_CHECK(t.lookup("/foo/d1000/x") == arude::path_trie::mark::include);
+  BOOST_CHECK_EQUAL(t.marked_subtree(t.find("/foo/bar")).size(), 1u);
+
+  // Pruned nodes are reused, the other nodes stay reachable
+  const auto size = t.size();
+  for (auto i = 0; i < 1000; i += 2)
+  {
+    const auto n = t.find("/foo/d" + std::to_string(i));
+    t.set({}, arude::path_trie::mark::none, n);
+    t.prune(n);
+  }
+  BOOST_CHECK(t.find("/foo/d0") == arude::path_trie::npos);
+  BOOST_CHECK(t.lookup("/foo/d998/x") == arude::path_trie::mark::include);
+  for (auto i = 1; i < 1000; i += 2)
+  {
+    BOOST_REQUIRE(t.lookup("/foo/d" + std::to_string(i)) == arude::path_trie::mark::exclude);
+  }
+  for (auto i = 0; i < 1000; i += 2)
+  {
+    t.set("/foo/e" + std::to_string(i), arude::path_trie::mark::exclude);
+  }
+  BOOST_CHECK_EQUAL(t.size(), size);
+  BOOST_CHECK(t.lookup("/foo/e998/x") == arude::path_trie::mark::exclude);
+  BOOST_CHECK_EQUAL(t.marked_subtree(t.find("/foo")).size(), 1002u);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_excluded_test)
+{
+  using path = boost::filesystem::path;
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(path{ "/data" }, false);
+  l.add_excludepath(path{ "/data/cache" });
+  l.add_excludepath(path{ "/other/cache" }); // Not below an include path, no effect
+
+  BOOST_CHECK(!l.excluded(path{ "/data/file" }));
+  BOOST_CHECK(l.excluded(path{ "/data/cache" }));
+  BOOST_CHECK(l.excluded(path{ "/data/cache/a/b" }));
+  BOOST_CHECK(!l.excluded(path{ "/data/cachex" }));
+  BOOST_CHECK(!l.excluded(std::string_view{ "/other/cache/a" }));
+  BOOST_CHECK_THROW(l.add_excludepath(path{ "relative" }), std::runtime_error);
+
+  // Including a sub path of an include path adds nothing
+  l.add_includepath(path{ "/data/sub" }, false);
+  BOOST_CHECK_EQUAL(std::distance(l.begin(), l.end()), 1);
+
+  // Recursive include removes the excludes below
+  l.add_includepath(path{ "/data" }, true);
+  BOOST_CHECK(!l.excluded(path{ "/data/cache/a" }));
+
+  l.add_excludepath(path{ "/data/cache" });
+  l.reroot(path{ "/data" }, path{ "/mnt/data" });
+  BOOST_CHECK(!l.excluded(path{ "/data/cache/a" }));
+  BOOST_CHECK(l.excluded(path{ "/mnt/data/cache/a" }));
+  BOOST_CHECK_EQUAL(l.begin()->string(), "/mnt/data");
+
+  l.clear();
+  BOOST_CHECK(!l.excluded(path{ "/mnt/data/cache/a" }));
+
+  // The root as include path
+  l.add_includepath(path{ "/" }, false);
+  l.add_excludepath(path{ "/tmp" });
+  BOOST_CHECK(l.excluded(path{ "/tmp/x" }));
+  BOOST_CHECK(!l.excluded(path{ "/usr/x" }));
+  const path probe[] = { path{ "/usr/x" }, path{ "/tmp/x" } };
+  auto excluded = std::vector<bool>{};
+  BOOST_CHECK_EQUAL(l.excluded_n(probe, 2, excluded), 1u);
+  BOOST_CHECK(excluded[1]);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(path_pattern_set_matches_test)
+{
+  auto s = arude::path_pattern_set{};
+  BOOST_CHECK(!s.matches("/a/b"));
+
+  const char* patterns[] = { "**/node_modules", "*.tmp", "/data/*/cache", "/src/**/gen", "build[0-9]", "\\[x?" };
+  s.add(std::begin(patterns), std::end(patterns));
+  BOOST_CHECK_EQUAL(s.size(), 6u);
+
+  BOOST_CHECK(s.matches("/home/u/project/node_modules"));
+  BOOST_CHECK(s.matches("/node_modules/a/b"));
+  BOOST_CHECK(!s.matches("/home/u/node_modules_x"));
+  BOOST_CHECK(s.matches("/x/a.tmp"));
+  BOOST_CHECK(s.matches("/x/a.tmp/y"));
+  BOOST_CHECK(!s.matches("/x/a.tmpx"));
+  BOOST_CHECK(s.matches("/data/v1/cache/file"));
+  BOOST_CHECK(!s.matches("/data/v1/v2/cache"));
+  BOOST_CHECK(!s.matches("/other/data/v1/cache"));
+  BOOST_CHECK(s.matches("/src/gen"));
+  BOOST_CHECK(s.matches("/src/a/b/gen/x"));
+  BOOST_CHECK(!s.matches("/src/a/b/genx"));
+  BOOST_CHECK(s.matches("/w/build7"));
+  BOOST_CHECK(!s.matches("/w/buildx"));
+  BOOST_CHECK(s.matches("/w/[xy"));
+  BOOST_CHECK(!s.matches("/w/xy"));
+
+  BOOST_CHECK_THROW(s.add("/"), std::invalid_argument);
+  BOOST_CHECK_EQUAL(s.size(), 6u);
+
+  s.clear();
+  BOOST_CHECK(!s.matches("/x/a.tmp"));
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_pattern_test)
+{
+  using path = boost::filesystem::path;
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(path{ "/data" }, false);
+  l.add_excludepattern("**/.git");
+
+  BOOST_CHECK(l.excluded(path{ "/data/repo/.git/objects" }));
+  BOOST_CHECK(!l.excluded(path{ "/data/repo/src" }));
+  BOOST_CHECK_EQUAL(l.exclude_patterns().size(), 1u);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_excluded_n_test)
+{
+  using path = boost::filesystem::path;
+  auto l = arude::includexclude_pathlist<path>{};
+  l.add_includepath(path{ "/data" }, false);
+  l.add_excludepath(path{ "/data/a" });
+  l.add_excludepath(path{ "/data/c/d" });
+  l.add_includepath(path{ "/data/a/keep" }, false);
+  l.add_excludepattern("*.tmp");
+
+  auto paths = std::vector<path>{};
+  const char* names[] = { "a", "ab", "b", "c", "d", "keep", "x.tmp" };
+  for (const auto i : names)
+  {
+    for (const auto j : names)
+    {
+      paths.emplace_back(std::string{ "/data/" } + i + "/" + j + "/f");
+      paths.emplace_back(std::string{ "/data/" } + i + "//" + j);
+    }
+  }
+  paths.emplace_back("/other");
+  paths.emplace_back("/");
+
+  auto excluded = std::vector<bool>{};
+  const auto n = l.excluded_n(paths.data(), paths.size(), excluded);
+  BOOST_REQUIRE_EQUAL(excluded.size(), paths.size());
+
+  auto expected = std::size_t{ 0 };
+  for (auto i = std::size_t{ 0 }; i < paths.size(); ++i)
+  {
+    BOOST_CHECK_MESSAGE(excluded[i] == l.excluded(paths[i]), paths[i].string());
+    expected += l.excluded(paths[i]) ? 1 : 0;
+  }
+  BOOST_CHECK_EQUAL(n, expected);
+  BOOST_CHECK(excluded[0]); // "/data/a/a/f"
+}
+
+namespace
+{
+
+///
+/// Random absolute paths over a small alphabet, so that paths often are sub paths of each other.
+///
+std::vector<boost::filesystem::path> random_paths(std::mt19937& rng, std::size_t n)
+{
+  const char* names[] = { "a", "b", "c" };
+  auto retval = std::vector<boost::filesystem::path>{};
+  for (auto i = std::size_t{ 0 }; i < n; ++i)
+  {
+    auto p = boost::filesystem::path{ "/" };
+    for (auto depth = 1 + rng() % 4; depth > 0; --depth)
+    {
+      p /= names[rng() % 3];
+    }
+    retval.push_back(p);
+  }
+  return retval;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_assign_test)
+{
+  using path = boost::filesystem::path;
+  auto rng = std::mt19937{ 42 };
+  const auto probes = random_paths(rng, 200);
+  for (auto round = 0; round < 50; ++round)
+  {
+    const auto includes = random_paths(rng, 4);
+    const auto excludes = random_paths(rng, 8);
+
+    auto sequential = arude::includexclude_pathlist<path>{};
+    for (const auto& i : includes)
+    {
+      sequential.add_includepath(i, false);
+    }
+    for (const auto& i : excludes)
+    {
+      sequential.add_excludepath(i);
+    }
+
+    auto bulk = arude::includexclude_pathlist<path>{};
+    bulk.assign(std::begin(includes), std::end(includes), std::begin(excludes), std::end(excludes));
+
+    BOOST_CHECK_EQUAL(std::distance(bulk.begin(), bulk.end()), std::distance(sequential.begin(), sequential.end()));
+    for (const auto& i : probes)
+    {
+      BOOST_CHECK_EQUAL(bulk.excluded(i), sequential.excluded(i));
+    }
+  }
+
+  auto l = arude::includexclude_pathlist<path>{};
+  const path relative[] = { path{ "relative" } };
+  BOOST_CHECK_THROW(l.assign(std::begin(relative), std::end(relative), std::begin(relative), std::begin(relative)), std::runtime_error);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_set_operations_test)
+{
+  using path = boost::filesystem::path;
+  using pathlist = arude::includexclude_pathlist<path>;
+  auto rng = std::mt19937{ 7 };
+  const auto probes = random_paths(rng, 200);
+
+  // Included means below an include path and not excluded
+  const auto included = [](const pathlist& l, const path& p)
+  {
+    return !l.excluded(p) && std::any_of(l.begin(), l.end(), [&p](const path& i) { return arude::is_subpath(i.string(), p.string()); });
+  };
+
+  for (auto round = 0; round < 50; ++round)
+  {
+    pathlist l[2];
+    for (auto& i : l)
+    {
+      for (const auto& j : random_paths(rng, 3))
+      {
+        i.add_includepath(j, false);
+      }
+      for (const auto& j : random_paths(rng, 6))
+      {
+        i.add_excludepath(j);
+      }
+    }
+
+    const auto u = set_union(l[0], l[1]);
+    const auto n = set_intersection(l[0], l[1]);
+    const auto d = set_difference(l[0], l[1]);
+    for (const auto& i : probes)
+    {
+      const auto a = included(l[0], i);
+      const auto b = included(l[1], i);
+      BOOST_CHECK_EQUAL(included(u, i), a || b);
+      BOOST_CHECK_EQUAL(included(n, i), a && b);
+      BOOST_CHECK_EQUAL(included(d, i), a && !b);
+    }
+
+    // The results can nest include paths, the batch must resolve them like a single lookup
+    for (const auto* i : { &u, &n, &d })
+    {
+      auto excluded = std::vector<bool>{};
+      i->excluded_n(probes.data(), probes.size(), excluded);
+      for (auto j = std::size_t{ 0 }; j < probes.size(); ++j)
+      {
+        BOOST_CHECK_EQUAL(excluded[j], i->excluded(probes[j]));
+      }
+    }
+  }
+
+  // Patterns mixed with paths, the operations which can't be represented throw
+  const char* patterns[] = { "b/c", "/a/a", "c/*" };
+  for (auto round = 0; round < 200; ++round)
+  {
+    pathlist l[2];
+    unsigned masks[2];
+    for (auto side = 0; side < 2; ++side)
+    {
+      // Sometimes the second list includes nothing
+      if (side == 0 || round % 5 != 0)
+      {
+        for (const auto& j : random_paths(rng, 3))
+        {
+          l[side].add_includepath(j, false);
+        }
+      }
+      for (const auto& j : random_paths(rng, 4))
+      {
+        l[side].add_excludepath(j);
+      }
+      masks[side] = static_cast<unsigned>(rng() % 8);
+      for (auto j = 0; j < 3; ++j)
+      {
+        if (masks[side] & (1u << j))
+        {
+          l[side].add_excludepattern(patterns[j]);
+        }
+      }
+    }
+
+    // Exclude paths may drop include paths, so either list may include nothing
+    const auto a_empty = l[0].begin() == l[0].end();
+    const auto b_empty = l[1].begin() == l[1].end();
+    const auto n = set_intersection(l[0], l[1]);
+    for (const auto& i : probes)
+    {
+      BOOST_CHECK_EQUAL(included(n, i), included(l[0], i) && included(l[1], i));
+    }
+
+    if (a_empty || b_empty || masks[0] == masks[1])
+    {
+      const auto u = set_union(l[0], l[1]);
+      for (const auto& i : probes)
+      {
+        BOOST_CHECK_EQUAL(included(u, i), included(l[0], i) || included(l[1], i));
+      }
+    }
+    else
+    {
+      BOOST_CHECK_THROW(set_union(l[0], l[1]), std::runtime_error);
+    }
+
+    if (b_empty || (masks[0] & masks[1]) == masks[1])
+    {
+      const auto d = set_difference(l[0], l[1]);
+      for (const auto& i : probes)
+      {
+        BOOST_CHECK_EQUAL(included(d, i), included(l[0], i) && !included(l[1], i));
+      }
+    }
+    else
+    {
+      BOOST_CHECK_THROW(set_difference(l[0], l[1]), std::runtime_error);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_reroot_test)
+{
+  using path = boost::filesystem::path;
+  using pathlist = arude::includexclude_pathlist<path>;
+  auto rng = std::mt19937{ 11 };
+  const auto probes = random_paths(rng, 200);
+
+  // The new roots are not in the alphabet, so rerooting renames a sub tree, whether the old root is an include path, a parent or inside one.
+  // Exclude paths above the old root stay, so the renamed sub tree keeps its exclusion only if there are none.
+  const path new_roots[] = { path{ "/d" }, path{ "/d/e" } };
+  for (auto round = 0; round < 100; ++round)
+  {
+    auto l = pathlist{};
+    for (const auto& i : random_paths(rng, 3))
+    {
+      l.add_includepath(i, false);
+    }
+    for (const auto& i : random_paths(rng, 6))
+    {
+      l.add_excludepath(i);
+    }
+
+    const auto old_root = random_paths(rng, 1).front().string();
+    const auto new_root = new_roots[round % 2].string();
+    if (l.excluded(path{ old_root }.parent_path()))
+    {
+      continue;
+    }
+    auto r = l;
+    r.reroot(path{ old_root }, path{ new_root });
+    BOOST_CHECK_EQUAL(std::distance(r.begin(), r.end()), std::distance(l.begin(), l.end()));
+    for (const auto& i : probes)
+    {
+      const auto s = i.string();
+      const auto moved = arude::is_subpath(old_root, s);
+      const auto target = moved ? path{ new_root + s.substr(old_root.size()) } : i;
+      BOOST_CHECK_EQUAL(r.excluded(target), l.excluded(i));
+      BOOST_CHECK_EQUAL(r.excluded(std::string_view{ target.string() }), l.excluded(i));
+    }
+  }
+
+  // Moving an include path keeps all its exclude paths
+  auto l = pathlist{};
+  l.add_includepath(path{ "/data" }, false);
+  l.add_includepath(path{ "/other" }, false);
+  for (auto i = 0; i < 10000; ++i)
+  {
+    l.add_excludepath(path{ "/data/d" + std::to_string(i) });
+  }
+  l.reroot(path{ "/data" }, path{ "/mnt/data" });
+  BOOST_CHECK(l.excluded(path{ "/mnt/data/d9999/x" }));
+  BOOST_CHECK(!l.excluded(path{ "/mnt/data/d10000" }));
+  BOOST_CHECK(!l.excluded(path{ "/data/d0" }));
+  BOOST_CHECK(!l.excluded(path{ "/other/d0" }));
+
+  const path probe[] = { path{ "/mnt/data/d5" }, path{ "/data/d5" }, path{ "/mnt/data" } };
+  auto excluded = std::vector<bool>{};
+  BOOST_CHECK_EQUAL(l.excluded_n(probe, 3, excluded), 1u);
+  BOOST_CHECK(excluded[0]);
+
+  // Moving back and forth reuses the nodes of the root table
+  for (auto i = 0; i < 100; ++i)
+  {
+    l.reroot(path{ "/mnt/data" }, path{ "/data" + std::to_string(i % 7) });
+    l.reroot(path{ "/data" + std::to_string(i % 7) }, path{ "/mnt/data" });
+  }
+  BOOST_CHECK(l.excluded(path{ "/mnt/data/d42" }));
+  BOOST_CHECK(!l.excluded(path{ "/data0/d42" }));
+  BOOST_CHECK_EQUAL(l.excluded_n(probe, 3, excluded), 1u);
+
+  // Rerooting back into the other include path nests the roots
+  l.reroot(path{ "/mnt/data" }, path{ "/other/data" });
+  BOOST_CHECK(l.excluded(path{ "/other/data/d42" }));
+  BOOST_CHECK(!l.excluded(path{ "/other/data" }));
+  BOOST_CHECK_EQUAL(std::distance(l.begin(), l.end()), 2);
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(compact_path_test)
+{
+  using arude::compact_path;
+  auto p = compact_path{ "/data//photos/./2016/img.jpg/" };
+  BOOST_CHECK_EQUAL(p.string(), "/data/photos/2016/img.jpg");
+  BOOST_CHECK_EQUAL(std::string{ p.c_str() }, "/data/photos/2016/img.jpg");
+  BOOST_CHECK(p.is_absolute());
+  BOOST_CHECK_EQUAL(p.depth(), 4u);
+  BOOST_CHECK_EQUAL(p.component(1), "photos");
+  BOOST_CHECK_EQUAL(p.prefix(0), "/");
+  BOOST_CHECK_EQUAL(p.prefix(2), "/data/photos");
+  BOOST_CHECK_EQUAL(p.parent_path(), "/data/photos/2016");
+  BOOST_CHECK_EQUAL(p.filename(), "img.jpg");
+  BOOST_CHECK_EQUAL(p.stem(), "img");
+  BOOST_CHECK_EQUAL(p.extension(), ".jpg");
+  BOOST_CHECK_EQUAL(compact_path{ "/.bashrc" }.stem(), ".bashrc");
+  BOOST_CHECK(!compact_path{ "/.bashrc" }.has_extension());
+  BOOST_CHECK(compact_path{ "a/b" }.is_relative());
+
+  p.remove_filename();
+  BOOST_CHECK_EQUAL(p.string(), "/data/photos/2016");
+  BOOST_CHECK_EQUAL(p.filename(), "2016");
+  BOOST_CHECK(p == compact_path{ "/data/photos/2016" });
+  BOOST_CHECK_EQUAL(p.hash(), compact_path{ "/data/photos/2016/" }.hash());
+
+  // Appending, also past the inline buffer
+  auto q = compact_path{ "/" };
+  auto expected = std::string{};
+  for (auto i = 0; i < 100; ++i)
+  {
+    q /= "dir" + std::to_string(i);
+    expected += "/dir" + std::to_string(i);
+  }
+  BOOST_CHECK_EQUAL(q.string(), expected);
+  BOOST_CHECK_EQUAL(q.depth(), 100u);
+  BOOST_CHECK_EQUAL(q.component(99), "dir99");
+  BOOST_CHECK(q == compact_path{ expected });
+  q /= q.filename();
+  BOOST_CHECK_EQUAL(q.filename(), "dir99");
+  BOOST_CHECK_EQUAL(q.depth(), 101u);
+  q.assign(q.prefix(1));
+  BOOST_CHECK_EQUAL(q.string(), "/dir0");
+  BOOST_CHECK_EQUAL((compact_path{ "a" } / "b/./c").string(), "a/b/c");
+  BOOST_CHECK_EQUAL((compact_path{ "/a" } / "/b").string(), "/b");
+
+  // Copies and moves of heap and inline paths
+  const auto long_path = compact_path{ expected };
+  auto copy = long_path;
+  auto moved = std::move(copy);
+  BOOST_CHECK(moved == long_path);
+  copy = p;
+  swap(copy, moved);
+  BOOST_CHECK(copy == long_path);
+  BOOST_CHECK(moved == p);
+
+  // Ordered by components like boost::filesystem::path, hashed by the cached hash
+  BOOST_CHECK(compact_path{ "/a/b" } < compact_path{ "/a-b" });
+  BOOST_CHECK(compact_path{ "/a" } < compact_path{ "/a/b" });
+  BOOST_CHECK(boost::filesystem::path{ "/a/b" } < boost::filesystem::path{ "/a-b" });
+  const auto set = std::unordered_set<compact_path>{ compact_path{ "/a" }, compact_path{ "/a/" }, compact_path{ "/b" } };
+  BOOST_CHECK_EQUAL(set.size(), 2u);
+
+  auto os = std::ostringstream{};
+  os << compact_path{ boost::filesystem::path{ "/x//y" } };
+  BOOST_CHECK_EQUAL(os.str(), "/x/y");
+}
+
+//---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(includeexclude_pathlist_compact_path_test)
+{
+  using path = boost::filesystem::path;
+  auto rng = std::mt19937{ 3 };
+  const auto probes = random_paths(rng, 200);
+  for (auto round = 0; round < 50; ++round)
+  {
+    auto l = arude::includexclude_pathlist<path>{};
+    auto c = arude::includexclude_pathlist<arude::compact_path>{};
+    for (const auto& i : random_paths(rng, 3))
+    {
+      l.add_includepath(i, false);
+      c.add_includepath(arude::compact_path{ i }, false);
+    }
+    for (const auto& i : random_paths(rng, 6))
+    {
+      l.add_excludepath(i);
+      c.add_excludepath(arude::compact_path{ i });
+    }
+    l.reroot(path{ "/a" }, path{ "/d" });
+    c.reroot(arude::compact_path{ "/a" }, arude::compact_path{ "/d" });
+    l.sort();
+    c.sort();
+
+    BOOST_CHECK(std::equal(l.begin(), l.end(), c.begin(), c.end(), [](const path& a, const arude::compact_path& b) { return a.string() == b.string(); }));
+    for (const auto& i : probes)
+    {
+      BOOST_CHECK_EQUAL(c.excluded(arude::compact_path{ i }), l.excluded(i));
+    }
+  }
+}